@@ -19,6 +19,7 @@ REM Od : debug mode
 REM 0i: if the compiler knows the intrinsic version, do it(in assembly code), and don't use the c++ runtime library.  ex) sinf
 REM -GR-: Turn off c++ runtime typo.
 REM -Eha: Turn off c++ exception handler(it creates extra things in stack)
+REM -DFOX_ARENA_PROFILE=1 : Records every arena push by where it came from. It looks at every push, so it's off.
 
 REM -MD: Use the internal(hidden) C runtime DLL instead of packing into exe. DONT USE THIS!!!
 REM -MT: Use the static library and pack the c runtime library to the exe so that
@@ -29,7 +30,7 @@ REM cl: command line
 REM -Fm: Create map file. MTdap file shows the whole process.
 REM -opt:ref: Hey linker don't put something into the exe if noone is using it.
 
-set commonCompilerFlags= -Od -MTd -nologo -Gm- -GR- -EHa- -Oi -WX -W4 -wd4201 -wd4100 -wd4189 -wd4505 -wd4127 -DFOX_WIN32=1 -DFOX_SLOW=1 -DFOX_DEBUG=1 -FC -Z7
+set commonCompilerFlags= -Od -MTd -nologo -Gm- -GR- -EHa- -Oi -WX -W4 -wd4201 -wd4100 -wd4189 -wd4505 -wd4127 -DFOX_WIN32=1 -DFOX_SLOW=1 -DFOX_DEBUG=1 -DFOX_ARENA_PROFILE=0 -FC -Z7
 set commonLinkerFlags= -incremental:no -opt:ref user32.lib gdi32.lib winmm.lib OpenGL32.Lib  
 
 IF NOT EXIST ..\..\build mkdir ..\..\build
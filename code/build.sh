@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# NOTE : Same as build.bat, but for linux with gcc(or clang).
+# Everything goes to the build directory next to the repo, so run the game from there.
+#   ./build.sh          builds the game, the linux platform layer, the tests and the benchmarks
+#   ./build.sh test     also runs the tests
+
+# WARNINGS
+# -Werror -Wall : Same as -WX -W4
+# -Wno-write-strings : The file names are passed as char *
+# -Wno-switch : Not every enum value is handled in the switches
+# -Wno-sign-compare : ArrayCount is unsigned
+# -Wno-unused-* : Same as c4189 and c4505
+# -Wno-missing-braces : The unions are initialized with one brace
+
+# Compiler Switches
+# -fno-rtti -fno-exceptions : Same as -GR- -EHa-
+# -g : Same as -Z7
+# -fno-strict-aliasing : msvc never assumes it, and we read the bits of the floats through the pointers
+# -DFOX_TEST=1 : Only for fox_test, turns on the reference code that the tests compare against
+# -DFOX_ARENA_PROFILE=1 : Records every arena push by where it came from. Off unless FOX_ARENA_PROFILE=1 is set,
+#                         because it looks at every push
+
+set -e
+
+codeDir="$(cd "$(dirname "$0")" && pwd)"
+buildDir="${FOX_BUILD_DIR:-$codeDir/../../build}"
+compiler="${CXX:-g++}"
+
+commonWarningFlags="-Werror -Wall -Wno-write-strings -Wno-switch -Wno-sign-compare -Wno-unused-variable -Wno-unused-function -Wno-unused-but-set-variable -Wno-missing-braces"
+commonCompilerFlags="-std=c++11 -g -fno-rtti -fno-exceptions -fno-strict-aliasing $commonWarningFlags -DFOX_LINUX=1"
+debugCompilerFlags="-O0 $commonCompilerFlags -DFOX_SLOW=1 -DFOX_DEBUG=1 -DFOX_ARENA_PROFILE=${FOX_ARENA_PROFILE:-0}"
+# NOTE : The benchmarks are optimized and have no asserts, but still have the debug counters
+benchCompilerFlags="-O2 $commonCompilerFlags -DFOX_SLOW=0 -DFOX_DEBUG=1"
+commonLinkerFlags="-lpthread -ldl"
+
+mkdir -p "$buildDir"
+pushd "$buildDir" > /dev/null
+
+$compiler $debugCompilerFlags -fPIC -shared "$codeDir/fox.cpp" -o fox.so
+$compiler $debugCompilerFlags "$codeDir/linux_fox.cpp" -o linux_fox $commonLinkerFlags
+$compiler $debugCompilerFlags -DFOX_TEST=1 "$codeDir/fox_test.cpp" -o fox_test $commonLinkerFlags
+$compiler $benchCompilerFlags "$codeDir/fox_bench.cpp" -o fox_bench $commonLinkerFlags
+
+if [ "$1" == "test" ]; then
+    ./fox_test
+fi
+
+popd > /dev/null
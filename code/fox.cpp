@@ -8,6 +8,7 @@
 
 // #include "fox_etity.cpp"
 #include "fox_sim_region.cpp"
+#include "fox_world_gen.cpp"
 
 // NOTE : OpenGL includes
 // #include "fox_opengl.cpp"
@@ -255,54 +256,108 @@ LoadAsset(game_assets *assets, game_asset_id id)
     }
 }
 
-// TODO : This is only for the world building! Remove it completely later.
-inline world_position
-TilePositionToChunkPosition(world *world, int32 absTileX, int32 absTileY, int32 absTileZ, 
-                            v3 additionalOffset = V3(0, 0, 0))
+struct add_low_entity_result
 {
-    world_position basePos = {};
+    uint32 lowIndex;
+    low_entity_handle handle;
+    low_entity *low;
+};
 
-    real32 tileSideInMeters = 1.4f;
-    real32 tileDeptInMeters = 3.0f;
+// NOTE : Only gets the slot, which is cleared except the generation.
+// The entity is not in the world yet!
+internal add_low_entity_result
+AllocateLowEntity(game_state *gameState)
+{
+    low_entity_storage *storage = &gameState->lowEntities;
+    uint32 lowIndex = storage->firstFree;
+    if(lowIndex)
+    {
+        storage->firstFree = GetLowEntity(storage, lowIndex)->payload.free.nextFree;
+    }
+    else
+    {
+        lowIndex = storage->count++;
 
-    v3 tileDim = V3(tileSideInMeters, tileSideInMeters, tileDeptInMeters);
-    v3 offset = Hadamard(tileDim, V3((real32)absTileX, (real32)absTileY, (real32)absTileZ));
+        uint32 pageIndex = lowIndex >> LOW_ENTITY_PAGE_SHIFT;
+        Assert(pageIndex < ArrayCount(storage->pages));
+        if(!storage->pages[pageIndex])
+        {
+            storage->pages[pageIndex] = 
+                PushArray(&gameState->worldArena, LOW_ENTITY_PAGE_SIZE, low_entity);
+        }
 
-    // Recanonicalize this value
-    world_position result = MapIntoChunkSpace(world, basePos, offset + additionalOffset);
+        // NOTE : Generation 0 is never used, so that the zeroed handle never matches
+        GetLowEntity(gameState, lowIndex)->generation = 1;
+    }
 
-    Assert(IsCanonical(world, result.offset_));
+    // NOTE : The slot that came from the free list already has the new generation
+    low_entity *low = GetLowEntity(gameState, lowIndex);
+    uint32 generation = low->generation;
+    *low = {};
+    low->generation = generation;
+    low->pos = NullPosition();
+
+    add_low_entity_result result = {};
+    result.low = low;
+    result.lowIndex = lowIndex;
+    result.handle.index = lowIndex;
+    result.handle.generation = generation;
 
     return result;
 }
 
-struct add_low_entity_result
-{
-    uint32 lowIndex;
-    low_entity *low;
-};
-
 // This function adds new low entity AND put it to the entity block based on the chunk
 // where the entity is.
 internal add_low_entity_result
-AddLowEntity(game_state *gameState, entity_type type, world_position worldPosition)
+AddLowEntity(game_state *gameState, entity_type type, world_position worldPosition,
+            sim_entity_collision_volume_group *collision)
 {
-    Assert(gameState->lowEntityCount < ArrayCount(gameState->lowEntities));
-    uint32 lowIndex = gameState->lowEntityCount++;
+    add_low_entity_result result = AllocateLowEntity(gameState);
+    low_entity *low = result.low;
+    low->type = (uint8)type;
+    low->collision = collision;
 
-    low_entity *low = gameState->lowEntities + lowIndex;
-    *low = {};
-    low->sim.type = type;
+    ChangeEntityLocation(gameState->world, &gameState->lowEntities, result.lowIndex, worldPosition);
+
+    return result;
+}
+
+// NOTE : Puts the slot in the free list. The entity should not be in any entity block.
+// The generation of the slot goes up, so every handle to this entity becomes invalid.
+internal void
+FreeLowEntity(game_state *gameState, uint32 lowIndex)
+{
+    Assert(lowIndex);
+    low_entity *low = GetLowEntity(gameState, lowIndex);
+    Assert(low->type != EntityType_Null && !low->block);
 
+    uint32 generation = low->generation + 1;
+    if(generation == 0)
+    {
+        generation = 1;
+    }
+    *low = {};
+    low->generation = generation;
+    low->type = EntityType_Null;
     low->pos = NullPosition();
+    low->payload.free.nextFree = gameState->lowEntities.firstFree;
+    gameState->lowEntities.firstFree = lowIndex;
+}
 
-    ChangeEntityLocation(&gameState->worldArena, gameState->world, low, lowIndex, worldPosition);
-    
-    add_low_entity_result result = {};
-    result.low = low;
-    result.lowIndex = lowIndex;
+// NOTE : Takes the entity out of the world and frees the slot.
+// If the sim region was passed, the collision rules of the region are also removed.
+internal void
+DeleteLowEntity(game_state *gameState, sim_region *simRegion, uint32 lowIndex)
+{
+    low_entity *low = GetLowEntity(gameState, lowIndex);
 
-    return result;
+    // NOTE : Nonspatial entities are not in any entity block
+    if(low->block)
+    {
+        ChangeEntityLocationRaw(gameState->world, &gameState->lowEntities, lowIndex, &low->pos, 0);
+    }
+    ClearCollisionRulesFor(gameState, simRegion, lowIndex);
+    FreeLowEntity(gameState, lowIndex);
 }
 
 // Draw grounded low entities
@@ -310,8 +365,7 @@ internal add_low_entity_result
 AddGroundedLowEntity(game_state *gameState, entity_type type, world_position worldPosition,
                     sim_entity_collision_volume_group *collisionGroup)
 {
-    add_low_entity_result result = AddLowEntity(gameState, type, worldPosition);
-    result.low->sim.collision = collisionGroup;
+    add_low_entity_result result = AddLowEntity(gameState, type, worldPosition, collisionGroup);
 
     return result;
 }
@@ -319,23 +373,22 @@ AddGroundedLowEntity(game_state *gameState, entity_type type, world_position wor
 internal void
 InitHitPoints(low_entity *low, uint32 hitPointCount)
 {
-    Assert(hitPointCount < ArrayCount(low->sim.hitPoints));
-    low->sim.hitPointMax = hitPointCount;
+    // NOTE : Each hit point is 4 bits
+    Assert(hitPointCount < 16);
+    low->hitPointMax = (uint8)hitPointCount;
+    low->hitPoints = 0;
     for(uint32 hitPointIndex = 0;
-        hitPointIndex < low->sim.hitPointMax;
+        hitPointIndex < low->hitPointMax;
         ++hitPointIndex)
     {
-        hit_point *hitPoint = low->sim.hitPoints + hitPointIndex;
-        hitPoint->flags = 0;
-        hitPoint->filledAmount = HIT_POINT_SUB_COUNT;
+        low->hitPoints |= (uint64)HIT_POINT_SUB_COUNT << (4*hitPointIndex);
     }
 }
 
 internal add_low_entity_result
 AddSword(game_state *gameState)
 {
-    add_low_entity_result entity = AddLowEntity(gameState, EntityType_Sword, NullPosition());
-    entity.low->sim.collision = gameState->swordCollision;
+    add_low_entity_result entity = AddLowEntity(gameState, EntityType_Sword, NullPosition(), gameState->swordCollision);
     
     return entity;
 }
@@ -346,20 +399,20 @@ AddPlayer(game_state *gameState)
     world_position pos = gameState->cameraPos;
     add_low_entity_result entity = AddGroundedLowEntity(gameState, EntityType_Hero, pos, gameState->playerCollision);
     
-    AddFlags(&entity.low->sim, EntityFlag_Movable|EntityFlag_ZSupported|EntityFlag_CanCollide);
+    AddFlags(entity.low, EntityFlag_Movable|EntityFlag_ZSupported|EntityFlag_CanCollide);
 
     InitHitPoints(entity.low, 3);
     // MakeEntityHighFrequency(gameState, entity.lowIndex);
 
     // Add sword for the player
     add_low_entity_result sword = AddSword(gameState);
-    entity.low->sim.sword.index = sword.lowIndex;
+    entity.low->payload.hero.sword = sword.handle;
 
     // If there is no entity that the camera is following,
     // Make this new entity followed by the camera
-    if(gameState->cameraFollowingEntityIndex == 0)
+    if(!IsValid(gameState, gameState->cameraFollowingEntity))
     {
-        gameState->cameraFollowingEntityIndex = entity.lowIndex;
+        gameState->cameraFollowingEntity = entity.handle;
     }
 
     return entity;
@@ -369,12 +422,12 @@ internal add_low_entity_result
 AddMonster(game_state *gameState, uint32 absTileX, uint32 absTileY, uint32 absTileZ)
 {
     world_position worldPositionOfTile = 
-        TilePositionToChunkPosition(gameState->world, absTileX, absTileY, absTileZ);
+        TilePositionToChunkPosition(&gameState->worldGen, absTileX, absTileY, absTileZ);
     
     add_low_entity_result entity = 
         AddGroundedLowEntity(gameState, EntityType_Monster, worldPositionOfTile, gameState->monsterCollision);
 
-    AddFlags(&entity.low->sim, EntityFlag_CanCollide);
+    AddFlags(entity.low, EntityFlag_CanCollide);
 
     InitHitPoints(entity.low, 2);
     
@@ -385,13 +438,12 @@ internal add_low_entity_result
 AddFamiliar(game_state *gameState, uint32 absTileX, uint32 absTileY, uint32 absTileZ)
 {
     world_position worldPositionOfTile = 
-        TilePositionToChunkPosition(gameState->world, absTileX, absTileY, absTileZ);
+        TilePositionToChunkPosition(&gameState->worldGen, absTileX, absTileY, absTileZ);
     
-    add_low_entity_result entity = AddLowEntity(gameState, EntityType_Familiar, worldPositionOfTile);
-
-    entity.low->sim.collision = gameState->familiarCollision;
+    add_low_entity_result entity = 
+        AddLowEntity(gameState, EntityType_Familiar, worldPositionOfTile, gameState->familiarCollision);
 
-    AddFlags(&entity.low->sim, EntityFlag_Movable);
+    AddFlags(entity.low, EntityFlag_Movable);
 
     return entity;
 }
@@ -402,15 +454,15 @@ AddStair(game_state *gameState, uint32 absTileX, uint32 absTileY, uint32 absTile
     // For the stairs, we want to offset a little be higher
     // so that the maximum Z value is the ground of next floor
     world_position worldPositionOfTile = 
-        TilePositionToChunkPosition(gameState->world, absTileX, absTileY, absTileZ);
+        TilePositionToChunkPosition(&gameState->worldGen, absTileX, absTileY, absTileZ);
 
     add_low_entity_result entity = 
         AddGroundedLowEntity(gameState, EntityType_Stairwell, worldPositionOfTile, gameState->stairCollision);
 
-    AddFlags(&entity.low->sim, EntityFlag_ZSupported);    
+    AddFlags(entity.low, EntityFlag_ZSupported);    
 
-    entity.low->sim.walkableDim = entity.low->sim.collision->totalVolume.dim.xy;    
-    entity.low->sim.walkableHeight = gameState->typicalFloorHeight;
+    entity.low->payload.stair.walkableDim = entity.low->collision->totalVolume.dim.xy;    
+    entity.low->payload.stair.walkableHeight = gameState->typicalFloorHeight;
 
     return entity;
 }
@@ -421,12 +473,12 @@ internal add_low_entity_result
 AddStandardSpace(game_state *gameState, uint32 absTileX, uint32 absTileY, uint32 absTileZ)
 {
     world_position worldPositionOfTile = 
-        TilePositionToChunkPosition(gameState->world, absTileX, absTileY, absTileZ);
+        TilePositionToChunkPosition(&gameState->worldGen, absTileX, absTileY, absTileZ);
 
     add_low_entity_result entity = 
         AddGroundedLowEntity(gameState, EntityType_Space, worldPositionOfTile, gameState->standardRoomCollision);
 
-    AddFlags(&entity.low->sim, EntityFlag_Traversable);
+    AddFlags(entity.low, EntityFlag_Traversable);
 
     return entity;
 }
@@ -438,16 +490,551 @@ internal add_low_entity_result
 AddWall(game_state *gameState, uint32 absTileX, uint32 absTileY, uint32 absTileZ)
 {
     world_position worldPositionOfTile = 
-        TilePositionToChunkPosition(gameState->world, absTileX, absTileY, absTileZ);
+        TilePositionToChunkPosition(&gameState->worldGen, absTileX, absTileY, absTileZ);
 
     add_low_entity_result entity = 
         AddGroundedLowEntity(gameState, EntityType_Wall, worldPositionOfTile, gameState->wallCollision);
 
-    AddFlags(&entity.low->sim, EntityFlag_CanCollide);
+    AddFlags(entity.low, EntityFlag_CanCollide);
     
     return entity;
 }
 
+// NOTE : These are set every frame, because the platform functions can move when the game is reloaded
+global_variable platform_add_entry *platformAddEntry;
+global_variable platform_complete_all_work *platformCompleteAllWork;
+
+// NOTE : Puts everything that the region job made into the world.
+// The entities are already sorted by the chunk, so we only look up the chunk when it changes.
+internal void
+AddWorldGenRegion(game_state *gameState, world_gen_region *region)
+{
+    world_chunk *chunk = 0;
+
+    for(uint32 entityIndex = 0;
+        entityIndex < region->entityCount;
+        ++entityIndex)
+    {
+        low_entity *source = region->entities + entityIndex;
+        world_position *pos = &source->pos;
+
+        if(!chunk || 
+            chunk->chunkX != pos->chunkX || chunk->chunkY != pos->chunkY || chunk->chunkZ != pos->chunkZ)
+        {
+            // NOTE : If the page of this chunk is out, these go into a new chunk,
+            // and the page is put together with them when it comes back
+            chunk = GetWorldChunk(gameState->world, pos->chunkX, pos->chunkY, pos->chunkZ, 
+                                &gameState->worldArena);
+        }
+
+        add_low_entity_result entity = AllocateLowEntity(gameState);
+        uint32 generation = entity.low->generation;
+        *entity.low = *source;
+        entity.low->generation = generation;
+        InsertEntityIntoChunk(gameState->world, &gameState->lowEntities, chunk, entity.lowIndex, &entity.low->pos);
+    }
+
+    region->gen->checksum += region->checksum;
+}
+
+// NOTE : Puts the region that was asked for first into the world, and frees its job slot.
+// If that job is not done yet, this waits for it.
+internal void
+FinishOldestWorldGenJob(thread_context *thread, game_state *gameState, transient_state *tranState,
+                        platform_work_queue *queue)
+{
+    world_gen_job *oldest = 0;
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(tranState->worldGenJobs);
+        ++jobIndex)
+    {
+        world_gen_job *job = tranState->worldGenJobs + jobIndex;
+        if(job->entry && job->requestIndex == tranState->worldGenInsertCount)
+        {
+            oldest = job;
+            break;
+        }
+    }
+    Assert(oldest);
+
+    if(!oldest->isDone && queue)
+    {
+        platformCompleteAllWork(thread, queue);
+    }
+    Assert(oldest->isDone);
+    CompletePreviousReadsBeforeFutureReads;
+
+    AddWorldGenRegion(gameState, &oldest->region);
+    oldest->entry->isQueued = false;
+    oldest->entry->isGenerated = true;
+    oldest->entry = 0;
+    ++tranState->worldGenInsertCount;
+}
+
+// NOTE : Puts every region that was asked for into the world, in the order they were asked for.
+// The regions of the shared chunks decide the order of the slots in there, and the low entity slots
+// decide the gather order and the clock phase, so the regions can't go in as their jobs get done.
+// This is called at the start of every update, which makes the world the same no matter how many threads we had.
+internal void
+FinishWorldGenJobs(thread_context *thread, game_state *gameState, transient_state *tranState,
+                    platform_work_queue *queue)
+{
+    while(tranState->worldGenInsertCount < tranState->worldGenRequestCount)
+    {
+        FinishOldestWorldGenJob(thread, gameState, tranState, queue);
+    }
+}
+
+// NOTE : Returns false if there was no free job slot
+internal bool32
+StartWorldGenJob(thread_context *thread, transient_state *tranState, platform_work_queue *queue, 
+                world_gen_region_entry *entry)
+{
+    bool32 result = false;
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(tranState->worldGenJobs);
+        ++jobIndex)
+    {
+        world_gen_job *job = tranState->worldGenJobs + jobIndex;
+        if(!job->entry)
+        {
+            BeginWorldGenRegion(&job->region, entry->regionX, entry->regionY, entry->regionZ);
+            job->entry = entry;
+            job->requestIndex = tranState->worldGenRequestCount++;
+            job->isDone = false;
+            entry->isQueued = true;
+
+            if(queue)
+            {
+                platformAddEntry(queue, DoWorldGenJob, job);
+            }
+            else
+            {
+                DoWorldGenJob(thread, 0, job);
+            }
+
+            result = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+// NOTE : Every region that the bounds touch is generated before this returns,
+// so the sim never sees the world without them. The regions around those are
+// generated ahead of time on the work queue while the rest of the frame runs, 
+// and go in at the start of the next update.
+internal void
+UpdateWorldGen(thread_context *thread, game_state *gameState, transient_state *tranState, 
+                platform_work_queue *queue, world_position center, rect3 bounds)
+{
+    BEGIN_TIMED_BLOCK(UpdateWorldGen);
+
+    world_gen *gen = &gameState->worldGen;
+    FinishWorldGenJobs(thread, gameState, tranState, queue);
+
+    // TODO : Only one floor for now!
+    int32 regionZ = 0;
+
+    world_gen_region_range needed = GetWorldGenRegionRange(gen, center, bounds, 0);
+    bool32 isWaiting = false;
+    for(int32 regionY = needed.minRegionY;
+        regionY <= needed.maxRegionY;
+        ++regionY)
+    {
+        for(int32 regionX = needed.minRegionX;
+            regionX <= needed.maxRegionX;
+            ++regionX)
+        {
+            world_gen_region_entry *entry = 
+                GetWorldGenRegionEntry(gen, &gameState->worldArena, regionX, regionY, regionZ);
+            if(!entry->isGenerated)
+            {
+                isWaiting = true;
+                if(!entry->isQueued)
+                {
+                    if(!StartWorldGenJob(thread, tranState, queue, entry))
+                    {
+                        // NOTE : Every slot is busy, so wait for the oldest one to get one
+                        FinishOldestWorldGenJob(thread, gameState, tranState, queue);
+                        StartWorldGenJob(thread, tranState, queue, entry);
+                    }
+                }
+            }
+        }
+    }
+
+    if(isWaiting)
+    {
+        FinishWorldGenJobs(thread, gameState, tranState, queue);
+    }
+
+    world_gen_region_range lookahead = 
+        GetWorldGenRegionRange(gen, center, bounds, WORLD_GEN_LOOKAHEAD_REGIONS);
+    bool32 hasFreeJob = true;
+    for(int32 regionY = lookahead.minRegionY;
+        hasFreeJob && regionY <= lookahead.maxRegionY;
+        ++regionY)
+    {
+        for(int32 regionX = lookahead.minRegionX;
+            hasFreeJob && regionX <= lookahead.maxRegionX;
+            ++regionX)
+        {
+            world_gen_region_entry *entry = 
+                GetWorldGenRegionEntry(gen, &gameState->worldArena, regionX, regionY, regionZ);
+            if(!entry->isGenerated && !entry->isQueued)
+            {
+                hasFreeJob = StartWorldGenJob(thread, tranState, queue, entry);
+            }
+        }
+    }
+
+    END_TIMED_BLOCK(UpdateWorldGen);
+}
+
+//
+// NOTE : Chunk streaming
+//
+
+// NOTE : Puts the entities of the page back into the world, in the new slots.
+// If something came into the chunk while the page was out, they are just put together.
+internal void
+PutChunkPageBack(game_state *gameState, uint8 *page)
+{
+    world *world_ = gameState->world;
+
+    world_chunk_page_header *header = (world_chunk_page_header *)page;
+    low_entity *lows = (low_entity *)(page + GetChunkPageEntitiesOffset());
+    world_chunk *chunk = GetWorldChunk(world_, header->chunkX, header->chunkY, header->chunkZ, world_->arena);
+
+    for(uint32 entityIndex = 0;
+        entityIndex < header->entityCount;
+        ++entityIndex)
+    {
+        add_low_entity_result entity = AllocateLowEntity(gameState);
+        uint32 generation = entity.low->generation;
+        *entity.low = lows[entityIndex];
+        entity.low->generation = generation;
+        InsertEntityIntoChunk(world_, &gameState->lowEntities, chunk, entity.lowIndex, &entity.low->pos);
+
+        // NOTE : The low frequency update can't see the entities in the page, so it has to hear about them again.
+        // lastSimStep came back with the entity, so it catches up on the time it missed.
+        if(IsLowSimAwake(entity.low))
+        {
+            QueueChunkForLowSim(world_, chunk);
+        }
+    }
+}
+
+// NOTE : Puts every page that was read back into the world, and frees the job slots that are done.
+internal void
+FinishWorldPageJobs(game_state *gameState)
+{
+    world *world_ = gameState->world;
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(world_->pageJobs);
+        ++jobIndex)
+    {
+        world_page_job *job = world_->pageJobs + jobIndex;
+        if(job->page && job->isDone)
+        {
+            CompletePreviousReadsBeforeFutureReads;
+
+            world_chunk_page *page = job->page;
+            if(!job->isWrite || !job->succeeded)
+            {
+                // NOTE : If the write failed, the entities are still in the job, so they just come back
+                Assert(job->isWrite || job->succeeded);
+                PutChunkPageBack(gameState, job->memory);
+                page->isPagedOut = false;
+                --world_->pagedOutChunkCount;
+            }
+
+            page->job = 0;
+            job->page = 0;
+        }
+    }
+}
+
+internal void
+StartWorldPageJob(thread_context *thread, platform_work_queue *queue, 
+                world_page_job *job, world_chunk_page *page, bool32 isWrite)
+{
+    Assert(!job->page && !page->job);
+    job->page = page;
+    job->isWrite = isWrite;
+    job->offset = page->offset;
+    job->size = page->size;
+    job->succeeded = false;
+    job->isDone = false;
+    page->job = job;
+
+    if(queue)
+    {
+        platformAddEntry(queue, DoWorldPageJob, job);
+    }
+    else
+    {
+        DoWorldPageJob(thread, 0, job);
+    }
+}
+
+// NOTE : Returns false if there was no free job slot
+internal bool32
+StartWorldPageIn(thread_context *thread, world *world_, platform_work_queue *queue, world_chunk_page *page)
+{
+    Assert(page->isPagedOut && !page->job);
+
+    world_page_job *job = GetFreeWorldPageJob(world_);
+    if(job)
+    {
+        StartWorldPageJob(thread, queue, job, page, false);
+    }
+
+    bool32 result = (job != 0);
+    return result;
+}
+
+// NOTE : Every job on the queue is done after this, including the page jobs
+internal void
+CompleteWorldPageJobs(thread_context *thread, game_state *gameState, platform_work_queue *queue)
+{
+    if(queue)
+    {
+        platformCompleteAllWork(thread, queue);
+    }
+    FinishWorldPageJobs(gameState);
+}
+
+// NOTE : Takes every entity of the chunk out of the world and frees their slots and the chunk itself.
+// The job writes them to the page file after that.
+// The page file only lives while the game is running, so the collision pointers stay valid.
+// Returns false if the chunk has to stay in memory, or there was no free job slot.
+internal bool32
+PageOutChunk(thread_context *thread, game_state *gameState, platform_work_queue *queue, world_chunk *chunk)
+{
+    world *world_ = gameState->world;
+    bool32 result = false;
+
+    uint32 entityCount = GetChunkEntityCount(chunk);
+    uint32 pageSize = GetChunkPageSize(entityCount);
+    world_page_job *job = GetFreeWorldPageJob(world_);
+    if(job && pageSize <= ((uint32)1 << WORLD_PAGE_MAX_SIZE_SHIFT))
+    {
+        world_chunk_page_header *header = (world_chunk_page_header *)job->memory;
+        header->chunkX = chunk->chunkX;
+        header->chunkY = chunk->chunkY;
+        header->chunkZ = chunk->chunkZ;
+        header->entityCount = entityCount;
+
+        low_entity *lows = (low_entity *)(job->memory + GetChunkPageEntitiesOffset());
+        bool32 isPinned = false;
+        uint32 pageEntityIndex = 0;
+        for(world_entity_block *block = chunk->firstBlock;
+            block;
+            block = block->next)
+        {
+            for(uint32 slot = 0;
+                slot < block->entityCount;
+                ++slot)
+            {
+                low_entity *low = GetLowEntity(gameState, block->lowEntityIndexes[slot]);
+                // NOTE : Heroes and swords have handles pointing at them from outside of the chunk,
+                // and those would not find them in the new slots after they came back.
+                if(low->type == EntityType_Hero || low->type == EntityType_Sword)
+                {
+                    isPinned = true;
+                }
+
+                lows[pageEntityIndex] = *low;
+                lows[pageEntityIndex].block = 0;
+                lows[pageEntityIndex].blockSlot = 0;
+                ++pageEntityIndex;
+            }
+        }
+        Assert(pageEntityIndex == entityCount);
+
+        if(!isPinned)
+        {
+            world_chunk_page *page = 
+                GetWorldChunkPage(world_, chunk->chunkX, chunk->chunkY, chunk->chunkZ, world_->arena);
+            Assert(!page->isPagedOut && !page->job);
+            ReserveWorldChunkPage(world_, page, pageSize);
+
+            for(world_entity_block *block = chunk->firstBlock;
+                block;
+                block = block->next)
+            {
+                for(uint32 slot = 0;
+                    slot < block->entityCount;
+                    ++slot)
+                {
+                    uint32 lowIndex = block->lowEntityIndexes[slot];
+                    GetLowEntity(gameState, lowIndex)->block = 0;
+                    ClearCollisionRulesFor(gameState, 0, lowIndex);
+                    FreeLowEntity(gameState, lowIndex);
+                }
+            }
+
+            world_entity_block *block = chunk->firstBlock;
+            while(block)
+            {
+                world_entity_block *nextBlock = block->next;
+                FreeEntityBlock(world_, block);
+                block = nextBlock;
+            }
+            chunk->firstBlock = 0;
+            MarkChunkEmpty(world_, chunk);
+            FreeWorldChunk(world_, chunk);
+
+            page->isPagedOut = true;
+            ++world_->pagedOutChunkCount;
+            StartWorldPageJob(thread, queue, job, page, true);
+
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+// NOTE : bounds should cover everything that the sim regions of this frame can touch.
+// Those chunks are paged in before this returns, the ones around them are paged in ahead of time
+// on the work queue, and the chunks that are far away are paged out a few per frame.
+internal void
+UpdateWorldStreaming(thread_context *thread, game_state *gameState, platform_work_queue *queue,
+                    world_position center, rect3 bounds)
+{
+    world *world_ = gameState->world;
+    if(world_->readPageFile)
+    {
+        BEGIN_TIMED_BLOCK(UpdateWorldStreaming);
+
+        FinishWorldPageJobs(gameState);
+
+        world_position minChunkPos = MapIntoChunkSpace(world_, center, GetMinCorner(bounds));
+        world_position maxChunkPos = MapIntoChunkSpace(world_, center, GetMaxCorner(bounds));
+
+        // NOTE : Nothing gets paged out inside the keep range, 
+        // so we only have to look again when we moved to the other chunk
+        if(world_->pageFile.noErrors &&
+            (world_->hasPendingPageIns || !AreInSameChunk(world_, &center, &world_->streamCenter)))
+        {
+            world_->streamCenter = center;
+            world_->hasPendingPageIns = false;
+
+            bool32 isWaiting = false;
+            uint32 prefetchCount = 0;
+            int32 radius = WORLD_STREAM_PREFETCH_CHUNKS;
+            for(int32 chunkZ = minChunkPos.chunkZ - radius;
+                chunkZ <= maxChunkPos.chunkZ + radius;
+                ++chunkZ)
+            {
+                for(int32 chunkY = minChunkPos.chunkY - radius;
+                    chunkY <= maxChunkPos.chunkY + radius;
+                    ++chunkY)
+                {
+                    for(int32 chunkX = minChunkPos.chunkX - radius;
+                        chunkX <= maxChunkPos.chunkX + radius;
+                        ++chunkX)
+                    {
+                        world_chunk_page *page = GetWorldChunkPage(world_, chunkX, chunkY, chunkZ);
+                        if(page && page->isPagedOut)
+                        {
+                            if(IsChunkInRange(chunkX, chunkY, chunkZ, minChunkPos, maxChunkPos, 0))
+                            {
+                                // NOTE : The sim region is about to touch this one
+                                isWaiting = true;
+                                if(page->job && page->job->isWrite)
+                                {
+                                    // NOTE : Still on the way out, so that has to finish first
+                                    CompleteWorldPageJobs(thread, gameState, queue);
+                                    ++world_->blockingPageWaitCount;
+                                }
+
+                                if(page->isPagedOut && !page->job &&
+                                    !StartWorldPageIn(thread, world_, queue, page))
+                                {
+                                    // NOTE : Every slot is busy, so wait for them to get one
+                                    CompleteWorldPageJobs(thread, gameState, queue);
+                                    ++world_->blockingPageWaitCount;
+                                    StartWorldPageIn(thread, world_, queue, page);
+                                }
+                            }
+                            else if(!page->job || page->job->isWrite)
+                            {
+                                if(!page->job && prefetchCount < WORLD_STREAM_MAX_PAGE_INS &&
+                                    StartWorldPageIn(thread, world_, queue, page))
+                                {
+                                    ++prefetchCount;
+                                }
+                                else
+                                {
+                                    world_->hasPendingPageIns = true;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            if(isWaiting)
+            {
+                CompleteWorldPageJobs(thread, gameState, queue);
+                ++world_->blockingPageWaitCount;
+            }
+        }
+
+        uint32 pageOutCount = 0;
+        for(uint32 scanIndex = 0;
+            scanIndex < WORLD_STREAM_EVICT_SCAN_COUNT && pageOutCount < WORLD_STREAM_MAX_PAGE_OUTS;
+            ++scanIndex)
+        {
+            if(!world_->pageFile.noErrors)
+            {
+                break;
+            }
+
+            if(!world_->evictCursor)
+            {
+                world_->evictCursor = world_->firstChunk;
+                if(!world_->evictCursor)
+                {
+                    break;
+                }
+            }
+
+            world_chunk *chunk = world_->evictCursor;
+            world_->evictCursor = chunk->next;
+
+            // NOTE : The chunks in the low sim queue still have something moving in them,
+            // so they wait until that stops
+            if(!chunk->isLowSimQueued &&
+                !IsChunkInRange(chunk, minChunkPos, maxChunkPos, WORLD_STREAM_KEEP_CHUNKS))
+            {
+                if(!chunk->firstBlock)
+                {
+                    FreeWorldChunk(world_, chunk);
+                }
+                else
+                {
+                    // NOTE : If the page of this chunk is still out, everything in here came in after that.
+                    // Those wait until the page comes back, so that they are all in one page next time.
+                    world_chunk_page *page = GetWorldChunkPage(world_, chunk->chunkX, chunk->chunkY, chunk->chunkZ);
+                    if((!page || !page->isPagedOut) &&
+                        PageOutChunk(thread, gameState, queue, chunk))
+                    {
+                        ++pageOutCount;
+                    }
+                }
+            }
+        }
+
+        END_TIMED_BLOCK(UpdateWorldStreaming);
+    }
+}
+
 // DrawHitPoints
 internal void
 DrawHitpoints(sim_entity *entity, render_group *pieceGroup)
@@ -579,12 +1166,8 @@ MakeEmptyBitmap(memory_arena *arena, int32 width, int32 height, bool32 shouldBeC
     result.height = height;
     result.pitch = result.width * BITMAP_BYTES_PER_PIXEL;
     int32 totalBitmapSize = result.width * result.height * BITMAP_BYTES_PER_PIXEL;
-    result.memory = PushSize_(arena, totalBitmapSize);
-
-    if(shouldBeCleared)
-    {
-        ClearBitmap(&result);
-    }
+    result.memory = shouldBeCleared ? 
+        PushSizeZeroed(arena, totalBitmapSize) : PushSize(arena, totalBitmapSize);
 
     return result;
 }
@@ -653,45 +1236,485 @@ MakeSphereNormalMap(loaded_bitmap *bitmap, real32 roughness)
         {
             v2 bitmapUV = {invWidth*(real32)x, invHeight*(real32)y};
 
-            real32 nX = 2.0f*bitmapUV.x - 1.0f;
-            real32 nY = 2.0f*bitmapUV.y - 1.0f;
+            real32 nX = 2.0f*bitmapUV.x - 1.0f;
+            real32 nY = 2.0f*bitmapUV.y - 1.0f;
+
+            real32 rootTerm = 1.0f - nX*nX - nY*nY;
+            
+            // Normal is in -101 space!
+            v3 normal = {0, 0.707106781188f, 0.707106781188f};
+            real32 nZ = 0.0f;
+            if(rootTerm >= 0.0f)
+            {
+                nZ = Root2(rootTerm);
+                normal = {nX, nY, nZ};
+            }
+
+            v4 color = {255.0f*(0.5f*(normal.x + 1.0f)),
+                        255.0f*(0.5f*(normal.y + 1.0f)),
+                        255.0f*(0.5f*(normal.z + 1.0f)),
+                        255.0f*roughness};
+            
+            *pixel++ = (((uint32)(color.a + 0.5f) << 24) |
+                            ((uint32)(color.r + 0.5f) << 16) |
+                            ((uint32)(color.g + 0.5f) << 8) |
+                            ((uint32)(color.b + 0.5f) << 0));
+        }
+
+        row += bitmap->pitch;
+    }
+}
+
+inline void
+SetHeroBitmapAlign(hero_bitmaps *bitmap, v2 align)
+{    
+    v2 topDownAlign = SetTopDownAlign(&bitmap->head, align);
+
+    bitmap->head.alignPercentage = topDownAlign;
+    bitmap->cape.alignPercentage = topDownAlign;
+    bitmap->torso.alignPercentage = topDownAlign;
+}
+
+// NOTE : Everything that moves has the drag, so whatever it was doing outside
+// the sim region comes to a stop instead of sliding away forever.
+// Swords are the only ones without it, and they stop when they run out of distance.
+internal void
+InitializeMoveSpecs(game_state *gameState)
+{
+    for(uint32 type = 0;
+        type < EntityType_Count;
+        ++type)
+    {
+        gameState->moveSpecs[type] = DefaultMoveSpec();
+    }
+
+    move_spec *heroSpec = gameState->moveSpecs + EntityType_Hero;
+    heroSpec->unitMaxAccelVector = true;
+    heroSpec->speed = 50.0f;
+    heroSpec->drag = 8.0f;
+
+    move_spec *swordSpec = gameState->moveSpecs + EntityType_Sword;
+    swordSpec->unitMaxAccelVector = false;
+    swordSpec->speed = 50.0f;
+    swordSpec->drag = 0.0f;
+
+    gameState->moveSpecs[EntityType_Monster].drag = 8.0f;
+    gameState->moveSpecs[EntityType_Familiar].drag = 8.0f;
+}
+
+// NOTE : Moves every spatial and movable entity in the list with the same move spec,
+// using the acceleration that was requested for each of them.
+// Each entity moves by its own dt, because some of them don't run every step.
+internal void
+MoveEntities(game_state *gameState, sim_region *simRegion, sim_entity_list *list, 
+            move_spec *moveSpec)
+{
+    for(uint32 entityIndex = 0;
+        entityIndex < list->count;
+        ++entityIndex)
+    {
+        sim_entity *entity = list->entities[entityIndex];
+
+        if(!IsSet(entity, EntityFlag_Nonspatial) && IsSet(entity, EntityFlag_Movable))
+        {
+            // NOTE : Controller input, jump or anything that gave this entity
+            // a velocity wakes it up
+            if(LengthSq(entity->ddP) > 0.0f || LengthSq(entity->dPos) > 0.0f)
+            {
+                WakeEntity(entity);
+            }
+
+            // Sleeping entities are resting on the ground, 
+            // so moving them would do nothing
+            if(!IsSet(entity, EntityFlag_Sleeping))
+            {
+                MoveEntity(gameState, simRegion, entity, entity->dt, moveSpec, entity->ddP);
+            }
+        }
+    }
+}
+
+internal void
+UpdateHeroes(game_state *gameState, sim_region *simRegion)
+{
+    // NOTE : Go through the controllers instead of the heroes,
+    // so that we don't have to find the controller of each hero.
+    for(uint32 controlIndex = 0;
+        controlIndex < ArrayCount(gameState->controlledHeroes);
+        ++controlIndex)
+    {
+        controlled_hero *conHero = gameState->controlledHeroes + controlIndex;
+        sim_entity *entity = 
+            IsValid(gameState, conHero->entity) ? GetEntityByStorageIndex(simRegion, conHero->entity.index) : 0;
+
+        if(entity && entity->updatable)
+        {
+            Assert(entity->type == EntityType_Hero);
+
+            if(conHero->dZ != 0.0f)
+            {
+                entity->dPos.z = conHero->dZ;
+                entity->dirty = true;
+            }
+
+            // This will be used later in MoveEntities
+            entity->ddP = V3(conHero->ddPlayer, 0);
+
+            // If the player's sword is in valid space in the world
+            sim_entity *sword = entity->sword.ptr;
+            if(sword && (conHero->dSword.x != 0.0f || conHero->dSword.y != 0.0f))
+            {
+                sword->distanceLimit = 5.0f;
+                MakeEntitySpatial(sword, 
+                                entity->pos, 
+                                entity->dPos + 5.0f * V3(conHero->dSword, 0));
+
+                // Sword itself should not collide with the player!
+                // TODO : Maybe change this when the enemy that makes player hit himself appears...?
+                AddCollisionRule(gameState, simRegion, entity->storageIndex, sword->storageIndex, false);
+            }
+        }
+    }
+
+    // NOTE : Heroes that nobody is controlling just slow down
+    MoveEntities(gameState, simRegion, simRegion->typeLists + EntityType_Hero, 
+                gameState->moveSpecs + EntityType_Hero);
+}
+
+internal void
+UpdateSwords(game_state *gameState, sim_region *simRegion)
+{
+    sim_entity_list *swords = simRegion->typeLists + EntityType_Sword;
+    for(uint32 swordIndex = 0;
+        swordIndex < swords->count;
+        ++swordIndex)
+    {
+        sim_entity *entity = swords->entities[swordIndex];
+
+        if(entity->distanceLimit <= 0.0f)
+        {
+            MakeEntityNonSpatial(entity);
+            // When we make the sword disapper, make it
+            ClearCollisionRulesFor(gameState, simRegion, entity->storageIndex);
+        }
+    }
+
+    MoveEntities(gameState, simRegion, swords, gameState->moveSpecs + EntityType_Sword);
+}
+
+internal void
+UpdateMonsters(game_state *gameState, sim_region *simRegion)
+{
+    MoveEntities(gameState, simRegion, simRegion->typeLists + EntityType_Monster, 
+                gameState->moveSpecs + EntityType_Monster);
+}
+
+internal void
+UpdateFamiliars(game_state *gameState, sim_region *simRegion)
+{
+    MoveEntities(gameState, simRegion, simRegion->typeLists + EntityType_Familiar, 
+                gameState->moveSpecs + EntityType_Familiar);
+}
+
+// NOTE : One fixed step of the game logic.
+// Nothing in here should push anything to the render group,
+// because this might run several times in a frame, or not at all.
+internal void
+UpdateSimRegion(game_state *gameState, sim_region *simRegion)
+{
+    // NOTE : Heroes go first, because they throw the swords
+    UpdateHeroes(gameState, simRegion);
+    UpdateSwords(gameState, simRegion);
+    UpdateMonsters(gameState, simRegion);
+    UpdateFamiliars(gameState, simRegion);
+
+    // NOTE : Walls, stairs and spaces never move or change by themselves,
+    // so they don't have a system. Only the renderer and the collision look at them.
+}
+
+// NOTE : Cheap update for the awake entities outside the sim region.
+// No collision and no controller, they just slide with their drag until they stop,
+// and the time that they missed is done in one go, up to LOW_SIM_MAX_CATCH_UP_SECONDS.
+internal void
+UpdateLowSimEntity(game_state *gameState, uint32 lowIndex, real32 dt)
+{
+    low_entity *low = GetLowEntity(gameState, lowIndex);
+    world *world_ = gameState->world;
+
+    real32 drag = gameState->moveSpecs[low->type].drag;
+
+    // NOTE : We don't know where the ground is, so whatever was in the air just lands there
+    v3 dPos = V3(low->dPos.xy, 0.0f);
+    v3 delta;
+    if(drag > 0.0f)
+    {
+        // NOTE : dPos' = -drag*dPos, so this is exact for any dt
+        real32 decay = Exp(-drag*dt);
+        delta = ((1.0f - decay) / drag)*dPos;
+        dPos *= decay;
+    }
+    else
+    {
+        delta = dt*dPos;
+    }
+
+    bool32 isOutOfDistance = false;
+    if(low->distanceLimit > 0.0f)
+    {
+        real32 deltaLength = Length(delta);
+        if(deltaLength >= low->distanceLimit)
+        {
+            delta *= low->distanceLimit / deltaLength;
+            isOutOfDistance = true;
+        }
+        low->distanceLimit -= Length(delta);
+    }
+
+    low->dPos = dPos;
+    // NOTE : This was out of the sim region, so there is nothing to draw it sliding from
+    low->prevPos = V3(0, 0, 0);
+    low->moveStepCount = 0;
+    low->lastSimStep = gameState->simStepIndex;
+    AddFlags(low, EntityFlag_ZSupported);
+
+    // NOTE : If the page of the new chunk is out, this goes into a new chunk,
+    // and the page is put together with it when it comes back
+    world_position newPos = MapIntoChunkSpace(world_, low->pos, delta);
+    ChangeEntityLocation(world_, &gameState->lowEntities, lowIndex, newPos);
+
+    if(isOutOfDistance)
+    {
+        // NOTE : Same as what UpdateSwords does when the sword ran out of distance
+        low->distanceLimit = 0.0f;
+        low->dPos = V3(0, 0, 0);
+        ChangeEntityLocation(world_, &gameState->lowEntities, lowIndex, NullPosition());
+        ClearCollisionRulesFor(gameState, 0, lowIndex);
+    }
+    else if(LengthSq(low->dPos) < Square(ENTITY_SLEEP_SPEED))
+    {
+        low->dPos = V3(0, 0, 0);
+        AddFlags(low, EntityFlag_Sleeping);
+    }
+}
+
+// NOTE : How many chunks the low frequency update can do in one frame
+#define LOW_SIM_MAX_CHUNKS_PER_FRAME 32
+// NOTE : The most time that one entity catches up on at once
+#define LOW_SIM_MAX_CATCH_UP_SECONDS 2.0f
+
+// NOTE : The low frequency tier. Takes a few chunks from the front of the low sim queue every frame,
+// and moves their awake entities by however long it has been since they were moved.
+// The chunks that the sim region can touch are skipped, because the sim region moves those entities.
+internal void
+UpdateLowFrequencyEntities(game_state *gameState, memory_arena *tempArena, 
+                            world_position center, rect3 simBounds)
+{
+    BEGIN_TIMED_BLOCK(UpdateLowFrequencyEntities);
+
+    world *world_ = gameState->world;
+    world_position minChunkPos = MapIntoChunkSpace(world_, center, GetMinCorner(simBounds));
+    world_position maxChunkPos = MapIntoChunkSpace(world_, center, GetMaxCorner(simBounds));
+
+    uint32 updatedChunkCount = 0;
+    // NOTE : Every chunk is looked at most once per frame, even the ones that go back to the queue
+    uint32 chunkCount = world_->lowSimChunkCount;
+    for(uint32 chunkIndex = 0;
+        chunkIndex < chunkCount && updatedChunkCount < LOW_SIM_MAX_CHUNKS_PER_FRAME;
+        ++chunkIndex)
+    {
+        world_chunk *chunk = PopLowSimChunk(world_);
+        if(IsChunkInRange(chunk, minChunkPos, maxChunkPos, 1))
+        {
+            QueueChunkForLowSim(world_, chunk);
+        }
+        else
+        {
+            ++updatedChunkCount;
+
+            temporary_memory chunkMemory = BeginTemporaryMemory(tempArena);
+
+            // NOTE : Moving the entities changes the entity blocks of this chunk,
+            // so get the awake ones first
+            uint32 awakeCount = 0;
+            uint32 *awakeIndices = PushArray(tempArena, GetChunkEntityCount(chunk), uint32);
+            for(world_entity_block *block = chunk->firstBlock;
+                block;
+                block = block->next)
+            {
+                for(uint32 slot = 0;
+                    slot < block->entityCount;
+                    ++slot)
+                {
+                    uint32 lowIndex = block->lowEntityIndexes[slot];
+                    if(IsLowSimAwake(GetLowEntity(gameState, lowIndex)))
+                    {
+                        awakeIndices[awakeCount++] = lowIndex;
+                    }
+                }
+            }
+
+            for(uint32 awakeIndex = 0;
+                awakeIndex < awakeCount;
+                ++awakeIndex)
+            {
+                uint32 lowIndex = awakeIndices[awakeIndex];
+                low_entity *low = GetLowEntity(gameState, lowIndex);
+                real32 dt = (real32)(gameState->simStepIndex - low->lastSimStep)*gameState->simStepDt;
+                // NOTE : The chunk could have waited for a long time in the queue or in the page file,
+                // and everything with the drag has stopped long before this anyway.
+                dt = Minimum(dt, LOW_SIM_MAX_CATCH_UP_SECONDS);
+                if(dt > 0.0f)
+                {
+                    UpdateLowSimEntity(gameState, lowIndex, dt);
+                }
+
+                // NOTE : Whatever chunk it is in now should look at it again
+                if(IsLowSimAwake(low))
+                {
+                    world_chunk *lowChunk = 
+                        GetWorldChunk(world_, low->pos.chunkX, low->pos.chunkY, low->pos.chunkZ);
+                    QueueChunkForLowSim(world_, lowChunk);
+                }
+            }
+
+            EndTemporaryMemory(chunkMemory);
+        }
+    }
+
+    END_TIMED_BLOCK(UpdateLowFrequencyEntities);
+}
+
+// NOTE : The entities are stored where they are after the last sim step,
+// but the frame is somewhere between the last step and the next one.
+// stepAlpha is how far we are into the next step, so we draw everything
+// back from where it is by the part of its last move that we have not reached yet.
+// This only decompresses what it draws, and never goes through BeginSim, 
+// because nothing here is simulated or written back.
+internal void
+RenderEntities(game_state *gameState, transient_state *tranState, render_group *renderGroup, 
+                world_position origin, rect3 bounds, real32 stepAlpha)
+{
+    world *world_ = gameState->world;
+    uint32 stepIndex = gameState->simStepIndex;
+
+    // NOTE : The camera follows its entity, so it should be drawn back the same way.
+    low_entity *cameraEntity = GetLowEntity(gameState, gameState->cameraFollowingEntity);
+    v3 cameraOffset = cameraEntity ? GetEntityRenderOffset(cameraEntity, stepIndex, stepAlpha) : V3(0, 0, 0);
+
+    // NOTE : The render bases are pushed after the query, so this is freed with the rest of the render memory
+    world_query query = BeginWorldQuery(world_, &tranState->tranArena, origin, bounds);
+    for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+        IsValid(&iter);
+        Advance(&iter))
+    {
+        low_entity *low = GetLowEntity(gameState, iter.lowEntityIndex);
+        if(IsSet(low, EntityFlag_Nonspatial))
+        {
+            continue;
+        }
+
+        v3 pos = SubstractTwoWMP(world_, &low->pos, &origin);
+        if(EntityOverlapsRectangle(pos, low->collision->totalVolume, bounds))
+        {
+            sim_entity entity_;
+            sim_entity *entity = &entity_;
+            DecompressEntity(low, entity);
+            entity->storageIndex = iter.lowEntityIndex;
+            entity->pos = pos;
+
+            // NOTE : The origin is the camera, so this is also camera relative
+            v3 groundPos = GetEntityGroundPoint(entity) + 
+                            GetEntityRenderOffset(low, stepIndex, stepAlpha) - cameraOffset;
+
+            render_basis *basis = PushStruct(&tranState->tranArena, render_basis);
+            basis->pos = groundPos;
+            
+            // Set this to basis so that when we PushPiece, the entity basis will be set to the basis
+            // because we are setting the piece->basis = group->defaultBasis
+            // even if we don't come to this scope, because the defaultBasis is (0, 0, 0), it does not matter
+            // in pushpiece call.
+            renderGroup->defaultBasis = basis;
+            
+            hero_bitmaps *heroBitmaps = &tranState->assets.heroBitmaps[entity->facingDirection];
+
+            v3 cameraRelativeGroundPos = groundPos;
+            // NOTE : This is written in Z order
+            real32 fadeTopEndZ = 1.0f*gameState->typicalFloorHeight;
+            real32 fadeTopStartZ = 0.5f*gameState->typicalFloorHeight;
+            real32 fadeBottomStartZ = -2.0f*gameState->typicalFloorHeight;
+            real32 fadeBottomEndZ = -2.25f*gameState->typicalFloorHeight;
+
+            if(cameraRelativeGroundPos.z > fadeTopStartZ)
+            {
+                // because the direction of increase is different, we need to change the start and end values
+                renderGroup->globalAlpha = Clamp01MapInRange(fadeTopEndZ, cameraRelativeGroundPos.z, fadeTopStartZ);
+            }
+            else if(cameraRelativeGroundPos.z < fadeBottomStartZ)
+            {
+                renderGroup->globalAlpha = Clamp01MapInRange(fadeBottomEndZ, cameraRelativeGroundPos.z, fadeBottomStartZ);
+            }
+            renderGroup->globalAlpha = Clamp01(1.5f - cameraRelativeGroundPos.z);
+
+            switch(entity->type)
+            {
+                case EntityType_Hero:
+                {
+                    real32 heroSizeC = 2.0f;
+
+                    PushBitmap(renderGroup, &heroBitmaps->torso, heroSizeC*1.4f, V3(0, 0, 0));
+                    PushBitmap(renderGroup, &heroBitmaps->cape, heroSizeC*1.4f, V3(0, 0, 0));                
+                    PushBitmap(renderGroup, &heroBitmaps->head, heroSizeC*1.4f, V3(0, 0, 0));
+
+                    DrawHitpoints(entity, renderGroup);
+                }break;
+
+                case EntityType_Sword:
+                {
+                    PushBitmap(renderGroup, GAI_Sword, 0.4f, V3(0, 0, 0));
+                }break;
+
+                case EntityType_Wall:
+                {
+                    PushBitmap(renderGroup, GAI_Tree, 2.5f, V3(0, 0, 0));
+                }break;
+
+                case EntityType_Monster:
+                {
+
+                }break;
+                
+                case EntityType_Space:
+                {
+
+                    for(uint32 volumeIndex = 0;
+                        volumeIndex < entity->collision->volumeCount;
+                        volumeIndex++)
+                    {
+                        sim_entity_collision_volume *volume = entity->collision->volumes + volumeIndex;
+                        //PushRectOutline(renderGroup, V3(volume->offset.xy, 0), volume->dim.xy, V4(0.3f, 0.3f, 0.9f, 1));  
+                    }
+                }break;
+
+                case EntityType_Stairwell:
+                {
+                    PushRect(renderGroup, V3(0, 0, 0), entity->walkableDim, V4(1, 1, 0, 1));
+                    PushRect(renderGroup, V3(0, 0, entity->walkableHeight), entity->walkableDim, V4(1, 1, 0, 1));
+                    
+                }break;
+
+                case EntityType_Familiar:
+                {
+                }break;
 
-            real32 rootTerm = 1.0f - nX*nX - nY*nY;
-            
-            // Normal is in -101 space!
-            v3 normal = {0, 0.707106781188f, 0.707106781188f};
-            real32 nZ = 0.0f;
-            if(rootTerm >= 0.0f)
-            {
-                nZ = Root2(rootTerm);
-                normal = {nX, nY, nZ};
+                default:
+                {
+                    InvalidCodePath;
+                }
             }
-
-            v4 color = {255.0f*(0.5f*(normal.x + 1.0f)),
-                        255.0f*(0.5f*(normal.y + 1.0f)),
-                        255.0f*(0.5f*(normal.z + 1.0f)),
-                        255.0f*roughness};
-            
-            *pixel++ = (((uint32)(color.a + 0.5f) << 24) |
-                            ((uint32)(color.r + 0.5f) << 16) |
-                            ((uint32)(color.g + 0.5f) << 8) |
-                            ((uint32)(color.b + 0.5f) << 0));
         }
-
-        row += bitmap->pitch;
     }
 }
 
-inline void
-SetHeroBitmapAlign(hero_bitmaps *bitmap, v2 align)
-{    
-    v2 topDownAlign = SetTopDownAlign(&bitmap->head, align);
-
-    bitmap->head.alignPercentage = topDownAlign;
-    bitmap->cape.alignPercentage = topDownAlign;
-    bitmap->torso.alignPercentage = topDownAlign;
-}
-
 #if FOX_DEBUG
 game_memory *debugGlobalMemory;
 #endif
@@ -701,6 +1724,8 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 #if FOX_DEBUG
     debugGlobalMemory = memory;
 #endif
+    platformAddEntry = memory->platformAddEntry;
+    platformCompleteAllWork = memory->platformCompleteAllWork;
 
     BEGIN_TIMED_BLOCK(GameUpdateAndRender);
 
@@ -714,20 +1739,51 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 
     if(!memory->isInitialized)
     {
+        // NOTE : If the platform only reserved the storage, the states themselves 
+        // have to be committed before we touch them. The arenas after them commit as they grow.
+        if(memory->platformCommitMemory)
+        {
+            bool32 committed = 
+                memory->platformCommitMemory(memory->permanentStorage, sizeof(game_state)) &&
+                memory->platformCommitMemory(memory->transientStorage, sizeof(transient_state));
+            Assert(committed);
+        }
+
         // TODO : Talk about this soon!  Let's start partitioning our memory space!
         InitializeArena(&gameState->worldArena, 
                         // world arena 
                         (memory_index)(memory->permanentStorageSize - sizeof(game_state)),
-                        (uint8 *)memory->permanentStorage + sizeof(game_state));
+                        (uint8 *)memory->permanentStorage + sizeof(game_state),
+                        memory->platformCommitMemory, memory->platformDecommitMemory);
+        DEBUG_REGISTER_ARENA(memory, &gameState->worldArena, "world");
 
         gameState->world = PushStruct(&gameState->worldArena, world);
 
+        InitializeCollisionRules(&gameState->collisionRules, &gameState->worldArena);
+        DEBUG_REGISTER_ARENA(memory, &gameState->collisionRules.arenas[0], "collision rules");
+        DEBUG_REGISTER_ARENA(memory, &gameState->collisionRules.arenas[1], "collision rules");
+
         gameState->typicalFloorHeight = 3.0f;
-        InitializeWorld(gameState->world, 
+
+        gameState->simStepDt = 1.0f / 30.0f;
+        gameState->maxSimStepsPerFrame = 4;
+        gameState->simTimeAccumulator = 0.0f;
+        InitializeWorld(gameState->world, &gameState->worldArena,
                         V3(pixelsToMeters*groundBufferWidth,
                             pixelsToMeters*groundBufferHeight,
                             gameState->typicalFloorHeight));
 
+        // NOTE : If we can't get a page file, the whole world just stays in memory
+        if(memory->platformOpenPageFile)
+        {
+            platform_file_handle pageFile = memory->platformOpenPageFile(thread, "fox_world.page");
+            if(pageFile.noErrors)
+            {
+                InitializeWorldStreaming(gameState->world, pageFile, 
+                                        memory->platformReadPageFile, memory->platformWritePageFile);
+            }
+        }
+
         uint32 tilesPerWidth = 10;
         uint32 tilesPerHeight = 10;
 
@@ -735,8 +1791,8 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
         real32 tileDeptInMeters = 3.0f;
         
         // NOTE : Reserve entity slot 0 for the null entity
-        AddLowEntity(gameState, EntityType_Null, NullPosition());
-        gameState->lowEntityCount = 1;
+        AddLowEntity(gameState, EntityType_Null, NullPosition(), 0);
+        gameState->lowEntities.count = 1;
 
         gameState->swordCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.1f);
         gameState->stairCollision = MakeSimpleGroundedCollision(gameState, 
@@ -745,7 +1801,7 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
                                                                 1.1f*tileDeptInMeters);
         gameState->playerCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 1.2f);
         gameState->monsterCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.5f);
-        gameState->monsterCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.5f);        
+        gameState->familiarCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.5f);
         gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 
                                                                 tileSideInMeters, 
                                                                 tileSideInMeters, 
@@ -756,173 +1812,26 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
                                                                 tilesPerHeight * tileSideInMeters, 
                                                                 0.9f*tileDeptInMeters);  
 
+        InitializeMoveSpecs(gameState);
+
+        // NOTE : Nothing is generated here! The rooms are generated 
+        // when the sim gets close to them(see UpdateWorldGen).
         // (0, 0, 0) is the center of the world!!
-        // becauseit's int
+        world_gen *gen = &gameState->worldGen;
+        InitializeWorldGen(gen, gameState->world, 321, tilesPerWidth, tilesPerHeight,
+                            tileSideInMeters, tileDeptInMeters);
+        gen->wallCollision = gameState->wallCollision;
+        gen->standardRoomCollision = gameState->standardRoomCollision;
+
         uint32 screenBaseX = 0;
         uint32 screenBaseY = 0;
         uint32 screenBaseZ = 0;
-        uint32 screenX = screenBaseX;
-        uint32 screenY = screenBaseY;
-
-        uint32 absTileZ = screenBaseZ;
-
-        // Tracker of the random number table
-        uint32 randomNumberIndex = 0;
-
-        bool32 doorLeft = false;
-        bool32 doorRight = false;
-        bool32 doorTop = false;
-        bool32 doorBottom = false;
-        bool32 doorUp = false;
-        bool32 doorDown =false;
-
-        bool32 zDoorCreated = false;
-        
-        random_series series = Seed(321);
-        
-        // For now, one screen is worth one room
-        for(uint32 screenIndex = 0;
-            screenIndex < 1;
-            ++screenIndex)
-        {
-            uint32 doorDirection = RandomChoice(&series, (doorUp || doorDown) ? 2 : 3);
-            // uint32 doorDirection = RandomChoice(&series, 2);
-            
-            bool32 createdZDoor = false;
-            if(doorDirection == 2)
-            {
-                createdZDoor = true;
-                if(absTileZ == 0)
-                {
-                    doorUp = true;
-                }
-                else
-                {
-                    doorDown = true;
-                }
-            }
-            else if(doorDirection == 1)
-            {
-                doorRight = true;
-            }
-            else
-            {
-                doorTop = true;
-            }
-            
-            AddStandardSpace(gameState, 
-                            screenX * tilesPerWidth + tilesPerWidth/2,
-                            screenY * tilesPerHeight + tilesPerHeight/2,
-                            absTileZ);
-
-            for(uint32 tileY = 0;
-                tileY < tilesPerHeight;
-                ++tileY)
-            {
-
-                for(uint32 tileX = 0;
-                    tileX < tilesPerWidth;
-                    ++tileX)
-                {
-                    // These values will always increase
-                    uint32 absTileX = screenX * tilesPerWidth + tileX;
-                    uint32 absTileY = screenY * tilesPerHeight + tileY;
-
-                    uint32 shouldBeDoor = false;
-
-                    if(tileX == 0 && ((tileY != (tilesPerHeight / 2))))
-                    {
-                        shouldBeDoor = true;
-                    }
-
-                    if(tileX == tilesPerWidth - 1 && (tileY != tilesPerHeight / 2))
-                    {
-                        shouldBeDoor = true;
-                    }
-
-                    if(tileY == 0 && (tileX != tilesPerWidth / 2))
-                    {
-                        shouldBeDoor = true;
-                    } 
-                    
-                    if(tileY == tilesPerHeight - 1 && (tileX != tilesPerWidth / 2))
-                    {
-                        shouldBeDoor = true;
-                    }
-                    
-                    if(shouldBeDoor)
-                    {
-                        AddWall(gameState, absTileX, absTileY, absTileZ);
-                    }
-                    else if(createdZDoor)
-                    {
-                        if((tileX == 10) && (tileY == 6))
-                        {
-                            if(!zDoorCreated)
-                            {
-                                AddStair(gameState, absTileX, absTileY - 1, absTileZ);
-                                zDoorCreated = true;
-                            }
-                            // if(doorUp)
-                            // {
-                            //     tileValue = 3;
-                            // }
-
-                            // if(doorDown)
-                            // {
-                            //     tileValue = 4;
-                            // }   
-                        }
-                    }
-                }
-            }
-
-            // If the door was OPEN to the left in this tilemap,
-            // The door in the next tilemap should be OPEN to the right 
-            // Same with the top and bottom
-            doorLeft = doorRight;
-            doorBottom = doorTop;
-
-            if(createdZDoor)
-            {
-                doorDown = !doorDown;
-                doorUp = !doorUp;
-            }
-            else
-            {
-                doorUp = false;
-                doorDown = false;
-            }
-
-            doorRight = false;
-            doorTop = false;
-
-            if(doorDirection == 2)
-            {
-                if(absTileZ == screenBaseZ)
-                {
-                    absTileZ = screenBaseZ + 1;
-                }
-                else
-                {
-                    absTileZ = screenBaseZ;
-                }                
-            }
-            else if(doorDirection == 1)
-            {
-                screenX += 1;
-            }
-            else
-            {
-                screenY += 1;
-            }
-        }
 
         world_position cameraPos = {};
         uint32 cameraTileX = screenBaseX * tilesPerWidth + 17/2;
         uint32 cameraTileY = screenBaseY * tilesPerHeight + 9/2;
         uint32 cameraTileZ = screenBaseZ;
-        cameraPos = TilePositionToChunkPosition(gameState->world, cameraTileX, cameraTileY, cameraTileZ);
+        cameraPos = TilePositionToChunkPosition(&gameState->worldGen, cameraTileX, cameraTileY, cameraTileZ);
         gameState->cameraPos = cameraPos;
         
         // AddMonster(gameState, cameraTileX + 4, cameraTileY + 2, cameraTileZ);
@@ -938,12 +1847,29 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
     {
         InitializeArena(&tranState->tranArena, 
                         (memory_index)(memory->transientStorageSize - sizeof(transient_state)),
-                        (uint8 *)memory->transientStorage + sizeof(transient_state));                
+                        (uint8 *)memory->transientStorage + sizeof(transient_state),
+                        memory->platformCommitMemory, memory->platformDecommitMemory);
+        DEBUG_REGISTER_ARENA(memory, &tranState->tranArena, "transient");
 
         SubArena(&tranState->assets.arena, &tranState->tranArena, Megabytes(64));
+        DEBUG_REGISTER_ARENA(memory, &tranState->assets.arena, "assets");
         tranState->assets.readEntireFile = memory->debugPlatformReadEntireFile;
         LoadAsset(&tranState->assets, GAI_Tree);
 
+        InitializeSimEntityHash(&tranState->simEntityHash, &tranState->tranArena);
+        DEBUG_REGISTER_ARENA(memory, &tranState->simEntityHash.arena, "sim hash");
+
+        for(uint32 jobIndex = 0;
+            jobIndex < ArrayCount(tranState->worldGenJobs);
+            ++jobIndex)
+        {
+            world_gen_job *job = tranState->worldGenJobs + jobIndex;
+            InitializeWorldGenRegion(&gameState->worldGen, &job->region, &tranState->tranArena);
+            job->entry = 0;
+        }
+        tranState->worldGenRequestCount = 0;
+        tranState->worldGenInsertCount = 0;
+
         tranState->groundBufferCount = 64;
         tranState->groundBuffers = 
             PushArray(&tranState->tranArena, tranState->groundBufferCount, ground_buffer);
@@ -1041,20 +1967,22 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 		game_controller *controller = &input->controllers[controllerIndex];
         controlled_hero *conHero = gameState->controlledHeroes + controllerIndex;
 
-        if(conHero->entityIndex == 0)
+        // NOTE : If the hero was deleted, the handle doesn't match anymore
+        // and the player can start again
+        if(!IsValid(gameState, conHero->entity))
         {
             if(controller->start.endedDown)
             {
                 *conHero = {};
-                conHero->entityIndex = AddPlayer(gameState).lowIndex;
+                conHero->entity = AddPlayer(gameState).handle;
             }
         }
         else
         {
-            conHero->dZ = 0.0f;
+            // NOTE : dZ and dSword are cleared by the sim step that used them,
+            // so that they are not lost in the frames that had no sim step.
             // player acceleration
             conHero->ddPlayer = {};
-            conHero->dSword = {};
 
             if(controller->isAnalog)
             {
@@ -1242,189 +2170,72 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
     v3 simBoundsExpansion = V3(15.0f, 15.0f, 0.0f);
     // The center is (0, 0) because the cameraPos is (0, 0)!!
     rect3 simBounds = AddRadiusToRect(cameraBoundsInMeters, simBoundsExpansion);
-    temporary_memory simMemory = BeginTemporaryMemory(&tranState->tranArena);
-    world_position simCenterPos = gameState->cameraPos;
-    sim_region *simRegion = 
-        BeginSim(&tranState->tranArena, 
-                gameState, gameState->world, 
-                simCenterPos, simBounds, 
-                input->dtForFrame);
-
-
-    // TODO : Purely for the debugging purpose! Not a good API>> clean this up!
-    render_basis *debugBasis = PushStruct(&tranState->tranArena, render_basis);
-    debugBasis->pos = V3(0, 0, 0);
-    renderGroup->defaultBasis = debugBasis;
-    // PushRectOutline(renderGroup, V3(0, 0, 0), GetDim(screenBound), V4(1.0f, 0.7f, 0.0f, 1.0f));
-
-    v3 cameraPos = SubstractTwoWMP(gameState->world, &gameState->cameraPos, &simCenterPos);
-    
-    for(uint32 entityIndex = 0;
-        entityIndex < simRegion->entityCount;
-        ++entityIndex)
+    // NOTE : BeginSim gathers more than the simBounds, 
+    // so the streaming and the world gen go by what it actually gathers.
+    rect3 streamBounds = GetSimRegionGatherBounds(simBounds, gameState->simStepDt);
+
+    // NOTE : Simulate in fixed steps, no matter how long this frame was.
+    gameState->simTimeAccumulator += input->dtForFrame;
+    uint32 simStepCount = 0;
+    while(gameState->simTimeAccumulator >= gameState->simStepDt &&
+        simStepCount < gameState->maxSimStepsPerFrame)
     {
-        sim_entity *entity = simRegion->entities + entityIndex;
-    
-        if(entity->updatable)
-        {
-            // TODO : This is incorrect, should be computed after update!!!!
-            real32 shadowAlpha = 1.0f - 0.5f*entity->pos.z;
-            if(shadowAlpha < 0)
-            {
-                shadowAlpha = 0.0f;
-            }
-
-            move_spec moveSpec = DefaultMoveSpec();
-            v3 ddP = {};
-
-            render_basis *basis = PushStruct(&tranState->tranArena, render_basis);
-            basis->pos = GetEntityGroundPoint(entity);
-            
-            // Set this to basis so that when we PushPiece, the entity basis will be set to the basis
-            // because we are setting the piece->basis = group->defaultBasis
-            // even if we don't come to this scope, because the defaultBasis is (0, 0, 0), it does not matter
-            // in pushpiece call.
-            renderGroup->defaultBasis = basis;
-            
-            hero_bitmaps *heroBitmaps = &tranState->assets.heroBitmaps[entity->facingDirection];
-
-            v3 cameraRelativeGroundPos = GetEntityGroundPoint(entity) - cameraPos;
-            // NOTE : This is written in Z order
-            real32 fadeTopEndZ = 1.0f*gameState->typicalFloorHeight;
-            real32 fadeTopStartZ = 0.5f*gameState->typicalFloorHeight;
-            real32 fadeBottomStartZ = -2.0f*gameState->typicalFloorHeight;
-            real32 fadeBottomEndZ = -2.25f*gameState->typicalFloorHeight;
-
-            if(cameraRelativeGroundPos.z > fadeTopStartZ)
-            {
-                // because the direction of increase is different, we need to change the start and end values
-                renderGroup->globalAlpha = Clamp01MapInRange(fadeTopEndZ, cameraRelativeGroundPos.z, fadeTopStartZ);
-            }
-            else if(cameraRelativeGroundPos.z < fadeBottomStartZ)
-            {
-                renderGroup->globalAlpha = Clamp01MapInRange(fadeBottomEndZ, cameraRelativeGroundPos.z, fadeBottomStartZ);
-            }
-            renderGroup->globalAlpha = Clamp01(1.5f - cameraRelativeGroundPos.z);
-
-            switch(entity->type)
-            {
-                case EntityType_Hero:
-                {
-                    // Prepare for the multiple players
-                    for(uint32 controlIndex = 0;
-                        controlIndex < ArrayCount(gameState->controlledHeroes);
-                        ++controlIndex)
-                    {
-                        controlled_hero *conHero = gameState->controlledHeroes + controlIndex;
-
-                        // Find out which controller is controlling this entity, 
-                        // so that we don't process this entity multiple times
-                        if(entity->storageIndex == conHero->entityIndex)
-                        {
-                            if(conHero->dZ != 0.0f)
-                            {
-                                entity->dPos.z = conHero->dZ;
-                            }
-
-                            // Changing the movespec does not effect the entity immediately
-                            // it will be used later in MoveEntity call.
-                            moveSpec.unitMaxAccelVector = true;
-                            moveSpec.speed = 50.0f;
-                            moveSpec.drag = 8.0f;
-                            ddP = V3(conHero->ddPlayer, 0);
-
-                            // If the player's sword is in valid space in the world
-                            if(conHero->dSword.x != 0.0f || conHero->dSword.y != 0.0f)
-                            {
-                                sim_entity *sword = entity->sword.ptr;
-                            
-                                sword->distanceLimit = 5.0f;
-                                MakeEntitySpatial(sword, 
-                                                entity->pos, 
-                                                entity->dPos + 5.0f * V3(conHero->dSword, 0));
-
-                                // Sword itself should not collide with the player!
-                                // TODO : Maybe change this when the enemy that makes player hit himself appears...?
-                                AddCollisionRule(gameState, entity->storageIndex, sword->storageIndex, false);
-                            }
-                        }
-                    }
-
-                    real32 heroSizeC = 2.0f;
+        ++gameState->simStepIndex;
 
-                    PushBitmap(renderGroup, &heroBitmaps->torso, heroSizeC*1.4f, V3(0, 0, 0));
-                    PushBitmap(renderGroup, &heroBitmaps->cape, heroSizeC*1.4f, V3(0, 0, 0));                
-                    PushBitmap(renderGroup, &heroBitmaps->head, heroSizeC*1.4f, V3(0, 0, 0));
-
-                    DrawHitpoints(entity, renderGroup);
-                }break;
-
-                case EntityType_Sword:
-                {
-                    moveSpec.unitMaxAccelVector = false;
-                    moveSpec.speed = 50.0f;
-                    moveSpec.drag = 0.0f;
-                    ddP = V3(0, 0, 0);
-
-                    if(entity->distanceLimit <= 0.0f)
-                    {
-                        MakeEntityNonSpatial(entity);
-                        // When we make the sword disapper, make it
-                        ClearCollisionRulesFor(gameState, entity->storageIndex);
-                    }
-
-                    PushBitmap(renderGroup, GAI_Sword, 0.4f, V3(0, 0, 0));
-                    
-                }break;
+        // NOTE : The camera can move to the other chunk in the middle of the steps
+        UpdateWorldStreaming(thread, gameState, memory->workQueue, gameState->cameraPos, streamBounds);
+        UpdateWorldGen(thread, gameState, tranState, memory->workQueue, gameState->cameraPos, streamBounds);
 
-                case EntityType_Wall:
-                {
-                    PushBitmap(renderGroup, GAI_Tree, 2.5f, V3(0, 0, 0));
-                }break;
+        temporary_memory simMemory = BeginTemporaryMemory(&tranState->tranArena);
+        sim_region *simRegion = 
+            BeginSim(&tranState->tranArena, &tranState->simEntityHash,
+                    gameState, gameState->world, 
+                    gameState->cameraPos, simBounds, cameraBoundsInMeters,
+                    gameState->simStepDt);
 
-                case EntityType_Monster:
-                {
+        UpdateSimRegion(gameState, simRegion);
 
-                }break;
-                
-                case EntityType_Space:
-                {
+        EndSim(simRegion, gameState);
+        EndTemporaryMemory(simMemory);
 
-                    for(uint32 volumeIndex = 0;
-                        volumeIndex < entity->collision->volumeCount;
-                        volumeIndex++)
-                    {
-                        sim_entity_collision_volume *volume = entity->collision->volumes + volumeIndex;
-                        //PushRectOutline(renderGroup, V3(volume->offset.xy, 0), volume->dim.xy, V4(0.3f, 0.3f, 0.9f, 1));  
-                    }
-                }break;
+        // NOTE : Jumping and throwing the sword should happen once per press,
+        // not once per step
+        for(uint32 controlIndex = 0;
+            controlIndex < ArrayCount(gameState->controlledHeroes);
+            ++controlIndex)
+        {
+            controlled_hero *conHero = gameState->controlledHeroes + controlIndex;
+            conHero->dZ = 0.0f;
+            conHero->dSword = {};
+        }
 
-                case EntityType_Stairwell:
-                {
-                    PushRect(renderGroup, V3(0, 0, 0), entity->walkableDim, V4(1, 1, 0, 1));
-                    PushRect(renderGroup, V3(0, 0, entity->walkableHeight), entity->walkableDim, V4(1, 1, 0, 1));
-                    
-                }break;
+        gameState->simTimeAccumulator -= gameState->simStepDt;
+        ++simStepCount;
+    }
 
-                case EntityType_Familiar:
-                {
-                }break;
+    UpdateLowFrequencyEntities(gameState, &tranState->tranArena, gameState->cameraPos, simBounds);
 
-                default:
-                {
-                    InvalidCodePath;
-                }
-            }
+    if(gameState->simTimeAccumulator >= gameState->simStepDt)
+    {
+        // NOTE : We couldn't keep up, so just drop the time we could not simulate.
+        // Trying to catch up in the next frames would only make those frames slower!
+        gameState->simTimeAccumulator = 0.0f;
+    }
 
+    // NOTE : The world was already streamed and generated around the camera in the sim steps,
+    // so drawing only reads what is there.
+    // TODO : Only the camera bounds should be enough here, but some bitmaps are bigger than
+    // their collision volumes and get cut off at the edge of the screen.
+    rect3 renderBounds = AddRadiusToRect(simBounds, V3(5.0f, 5.0f, 0.0f));
 
-            // Move every entity that was set special && movable
-            if(!IsSet(entity, EntityFlag_Nonspatial) && IsSet(entity, EntityFlag_Movable))
-            {
-                MoveEntity(gameState, simRegion, entity, input->dtForFrame, &moveSpec, ddP);
-            }
+    // TODO : Purely for the debugging purpose! Not a good API>> clean this up!
+    render_basis *debugBasis = PushStruct(&tranState->tranArena, render_basis);
+    debugBasis->pos = V3(0, 0, 0);
+    renderGroup->defaultBasis = debugBasis;
+    // PushRectOutline(renderGroup, V3(0, 0, 0), GetDim(screenBound), V4(1.0f, 0.7f, 0.0f, 1.0f));
 
-        }
-    }
+    real32 stepAlpha = gameState->simTimeAccumulator / gameState->simStepDt;
+    RenderEntities(gameState, tranState, renderGroup, gameState->cameraPos, renderBounds, stepAlpha);
 
 #if 0
     {
@@ -1540,12 +2351,11 @@ extern "C" GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
 #endif
     RenderGroupToOutputBuffer(renderGroup, drawBuffer);
 
-    EndSim(simRegion, gameState);
-    EndTemporaryMemory(simMemory);
     EndTemporaryMemory(renderMemory);    
     
     CheckArena(&gameState->worldArena);
     CheckArena(&tranState->tranArena);
+    CheckScratchArena(&thread->scratchArena);
 
     END_TIMED_BLOCK(GameUpdateAndRender);
 }
@@ -62,39 +62,332 @@
 // expensive because of precision purpose
 #include <math.h>
 
-struct memory_arena
-{
-    memory_index size;
-    uint8 *base;
-    memory_index used;
-
-    int32 tempCount;
-};
-
-struct temporary_memory
-{
-    memory_index used;
-    memory_arena *arena;
-};
-
+// NOTE : The arena commits this much at once when it grows.
+// Must be a power of 2
+#define ARENA_COMMIT_SIZE Kilobytes(64)
+// NOTE : When the temporary memory ends with more than this committed after it,
+// the arena gives the rest back to the platform.
+#define ARENA_DECOMMIT_THRESHOLD Megabytes(16)
+
+// NOTE : The memory should be all 0, like the fresh storage from the platform.
 inline void
-InitializeArena(memory_arena *arena, memory_index size, void *base)
+InitializeArena(memory_arena *arena, memory_index size, void *base,
+                platform_commit_memory *commitMemory = 0, platform_decommit_memory *decommitMemory = 0)
 {
     arena->size = size;
     // Base is the start of the memory
     arena->base = (uint8 *)base;
     arena->used = 0;
+    arena->committed = commitMemory ? 0 : size;
+    arena->commitMemory = commitMemory;
+    arena->decommitMemory = decommitMemory;
+    arena->zeroFrom = 0;
     arena->tempCount = 0;
+
+#if FOX_ARENA_PROFILE
+    arena->name[0] = 0;
+    arena->maxUsed = 0;
+    arena->tempMaxUsed = 0;
+    arena->framePushCount = 0;
+    arena->frameByteCount = 0;
+    arena->lastFramePushCount = 0;
+    arena->lastFrameByteCount = 0;
+#endif
+}
+
+inline memory_index
+AlignArenaCommitSize(memory_index size)
+{
+    memory_index result = (size + ARENA_COMMIT_SIZE - 1) & ~((memory_index)ARENA_COMMIT_SIZE - 1);
+    return result;
+}
+
+// NOTE : Where in the code the push came from, for the arena profile(see DEBUGGetArenaSite).
+#if FOX_ARENA_PROFILE
+    #define ARENA_SITE __FILE__, __LINE__
+#else
+    #define ARENA_SITE 0, 0
+#endif
+
+#if FOX_ARENA_PROFILE
+// NOTE : Cuts off what doesn't fit, and always ends with 0
+inline void
+DEBUGCopyArenaName(char *dest, memory_index destCount, char *source)
+{
+    memory_index index = 0;
+    if(source)
+    {
+        while(source[index] && index < destCount - 1)
+        {
+            dest[index] = source[index];
+            ++index;
+        }
+    }
+    dest[index] = 0;
 }
 
+// NOTE : The registered arenas show up in the frame summary
+inline void
+DEBUGRegisterArena(game_memory *memory, memory_arena *arena, char *name)
+{
+    DEBUGCopyArenaName(arena->name, sizeof(arena->name), name);
+
+    debug_arena_profile *profile = &memory->arenaProfile;
+    bool32 isRegistered = false;
+    for(uint32 arenaIndex = 0;
+        arenaIndex < profile->arenaCount;
+        ++arenaIndex)
+    {
+        if(profile->arenas[arenaIndex] == arena)
+        {
+            isRegistered = true;
+        }
+    }
+
+    if(!isRegistered && profile->arenaCount < ArrayCount(profile->arenas))
+    {
+        profile->arenas[profile->arenaCount++] = arena;
+    }
+}
+
+// NOTE : Writes "file(line)" and always ends with 0
+inline void
+DEBUGFormatArenaSiteName(char *dest, memory_index destCount, char *fileName, int32 line)
+{
+    char lineText[16];
+    uint32 lineTextCount = 0;
+    uint32 lineValue = (uint32)line;
+    do
+    {
+        lineText[lineTextCount++] = (char)('0' + lineValue % 10);
+        lineValue /= 10;
+    } while(lineValue);
+
+    memory_index index = 0;
+    for(char *scan = fileName;
+        *scan && index < destCount - 1;
+        ++scan)
+    {
+        dest[index++] = *scan;
+    }
+    if(index < destCount - 1)
+    {
+        dest[index++] = '(';
+    }
+    while(lineTextCount && index < destCount - 1)
+    {
+        dest[index++] = lineText[--lineTextCount];
+    }
+    if(index < destCount - 1)
+    {
+        dest[index++] = ')';
+    }
+    dest[index] = 0;
+}
+
+// NOTE : The sites are keyed by the hash of their "file(line)", not by the __FILE__ pointer,
+// so that the same site is still the same one after the game code gets reloaded.
+// The site cache is keyed by the pointer, so this only hashes the file name 
+// the first time each place pushes, and again after the reload.
+internal debug_arena_site *
+DEBUGGetArenaSite(memory_arena *arena, char *file, int32 line, bool32 isTemporary)
+{
+    debug_arena_site *result = 0;
+
+    debug_arena_profile *profile = debugGlobalMemory ? &debugGlobalMemory->arenaProfile : 0;
+    if(profile && file)
+    {
+        // NOTE : Fibonacci hashing of the pointer and the line
+        uint64 fileLine = (uint64)(memory_index)file ^ ((uint64)(uint32)line << 40);
+        uint32 cacheIndex = (uint32)((fileLine*11400714819323198485ULL) >> 32) & 
+                            (DEBUG_ARENA_SITE_CACHE_COUNT - 1);
+        debug_arena_site *cached = profile->siteCache[cacheIndex];
+        if(cached && cached->file == file && cached->line == line)
+        {
+            result = cached;
+        }
+        else
+        {
+            // NOTE : Only the file name, because the compiler might give us the whole path
+            char *fileName = file;
+            for(char *scan = file;
+                *scan;
+                ++scan)
+            {
+                if(*scan == '\\' || *scan == '/')
+                {
+                    fileName = scan + 1;
+                }
+            }
+
+            // NOTE : FNV-1a, and 0 is the empty slot
+            uint64 key = 14695981039346656037ULL;
+            for(char *scan = fileName;
+                *scan;
+                ++scan)
+            {
+                key ^= (uint8)*scan;
+                key *= 1099511628211ULL;
+            }
+            for(uint32 byteIndex = 0;
+                byteIndex < 4;
+                ++byteIndex)
+            {
+                key ^= (uint8)((uint32)line >> (8*byteIndex));
+                key *= 1099511628211ULL;
+            }
+            if(!key)
+            {
+                key = 1;
+            }
+
+            uint32 hashMask = DEBUG_MAX_ARENA_SITE_COUNT - 1;
+            for(uint32 probeIndex = 0;
+                !result && probeIndex < DEBUG_MAX_ARENA_SITE_COUNT;
+                ++probeIndex)
+            {
+                debug_arena_site *site = profile->sites + ((key + probeIndex) & hashMask);
+                uint64 siteKey = site->key;
+                if(!siteKey)
+                {
+                    // NOTE : Other thread might be taking this slot at the same time
+                    siteKey = AtomicCompareExchangeU64(&site->key, key, 0);
+                    if(!siteKey)
+                    {
+                        DEBUGFormatArenaSiteName(site->name, sizeof(site->name), fileName, line);
+                        DEBUGCopyArenaName(site->arenaName, sizeof(site->arenaName), arena->name);
+                        site->line = line;
+                        site->isTemporary = isTemporary;
+                        siteKey = key;
+                    }
+                }
+
+                if(siteKey == key)
+                {
+                    result = site;
+                }
+            }
+
+            if(result)
+            {
+                // NOTE : Other thread might see the cache, so the file has to be there first.
+                // If two places share the cache slot, they just keep taking it from each other.
+                result->file = file;
+                CompletePreviousWritesBeforeFutureWrites;
+                profile->siteCache[cacheIndex] = result;
+            }
+            else
+            {
+                AtomicAddU64(&profile->droppedPushCount, 1);
+            }
+        }
+    }
+
+    return result;
+}
+
+// NOTE : The arena is only touched by one thread, but the sites can be shared.
+inline void
+DEBUGRecordArenaPush(memory_arena *arena, char *file, int32 line, memory_index size)
+{
+    ++arena->framePushCount;
+    arena->frameByteCount += size;
+    if(arena->used > arena->maxUsed)
+    {
+        arena->maxUsed = arena->used;
+    }
+    if(arena->used > arena->tempMaxUsed)
+    {
+        arena->tempMaxUsed = arena->used;
+    }
+
+    debug_arena_site *site = DEBUGGetArenaSite(arena, file, line, false);
+    if(site)
+    {
+        AtomicAddU64(&site->pushCount, 1);
+        AtomicAddU64(&site->byteCount, size);
+        AtomicAddU64(&site->framePushCount, 1);
+        AtomicAddU64(&site->frameByteCount, size);
+    }
+}
+
+inline void
+DEBUGRecordTemporaryMemory(memory_arena *arena, char *file, int32 line, memory_index maxSize)
+{
+    debug_arena_site *site = DEBUGGetArenaSite(arena, file, line, true);
+    if(site)
+    {
+        AtomicAddU64(&site->pushCount, 1);
+        AtomicAddU64(&site->framePushCount, 1);
+
+        uint64 oldMax = site->maxTempByteCount;
+        while(maxSize > oldMax)
+        {
+            uint64 seen = AtomicCompareExchangeU64(&site->maxTempByteCount, maxSize, oldMax);
+            oldMax = (seen == oldMax) ? maxSize : seen;
+        }
+    }
+}
+
+// NOTE : The platform calls this once a frame, before it prints the summary.
+// What was pushed since the last call moves to the lastFrame counts.
+inline void
+DEBUGEndArenaProfileFrame(game_memory *memory)
+{
+    debug_arena_profile *profile = &memory->arenaProfile;
+    ++profile->frameCount;
+
+    for(uint32 arenaIndex = 0;
+        arenaIndex < profile->arenaCount;
+        ++arenaIndex)
+    {
+        memory_arena *arena = profile->arenas[arenaIndex];
+        arena->lastFramePushCount = arena->framePushCount;
+        arena->lastFrameByteCount = arena->frameByteCount;
+        arena->framePushCount = 0;
+        arena->frameByteCount = 0;
+    }
+
+    for(uint32 siteIndex = 0;
+        siteIndex < ArrayCount(profile->sites);
+        ++siteIndex)
+    {
+        debug_arena_site *site = profile->sites + siteIndex;
+        if(site->key)
+        {
+            // NOTE : The worker threads might still be pushing
+            site->lastFramePushCount = AtomicExchangeU64(&site->framePushCount, 0);
+            site->lastFrameByteCount = AtomicExchangeU64(&site->frameByteCount, 0);
+            if(site->lastFrameByteCount > site->maxFrameByteCount)
+            {
+                site->maxFrameByteCount = site->lastFrameByteCount;
+            }
+        }
+    }
+}
+
+    #define DEBUG_REGISTER_ARENA(memory, arena, name) DEBUGRegisterArena(memory, arena, name)
+#else
+    #define DEBUG_REGISTER_ARENA(memory, arena, name)
+#endif
+
+#define BeginTemporaryMemory(arena) BeginTemporaryMemory_(arena, ARENA_SITE)
+
 inline temporary_memory
-BeginTemporaryMemory(memory_arena *arena)
+BeginTemporaryMemory_(memory_arena *arena, char *file = 0, int32 line = 0)
 {
     temporary_memory result = {};
 
     result.arena = arena;
     result.used = arena->used;
     ++result.arena->tempCount;
+
+#if FOX_ARENA_PROFILE
+    result.siteFile = file;
+    result.siteLine = line;
+    result.outerTempMaxUsed = arena->tempMaxUsed;
+    arena->tempMaxUsed = arena->used;
+#endif
     
     return result;
 }
@@ -104,7 +397,27 @@ EndTemporaryMemory(temporary_memory memory)
 {
     memory_arena *arena = memory.arena;
     Assert(arena->used >= memory.used);
+
+#if FOX_ARENA_PROFILE
+    DEBUGRecordTemporaryMemory(arena, memory.siteFile, memory.siteLine, arena->tempMaxUsed - memory.used);
+    arena->tempMaxUsed = Maximum(memory.outerTempMaxUsed, arena->tempMaxUsed);
+#endif
+
     arena->used = memory.used;
+
+    // NOTE : The sub arenas that were made in this temporary memory commit their own memory,
+    // so go up to everything that was handed out, not only what this arena has committed.
+    memory_index handedOut = Maximum(arena->committed, arena->zeroFrom);
+    if(arena->decommitMemory &&
+        handedOut > arena->used + ARENA_DECOMMIT_THRESHOLD)
+    {
+        memory_index keep = AlignArenaCommitSize(arena->used);
+        arena->decommitMemory(arena->base + keep, handedOut - keep);
+        arena->committed = keep;
+        // NOTE : The decommit does not throw away the page that keep is in,
+        // and the page is never bigger than the commit size.
+        arena->zeroFrom = Minimum(arena->zeroFrom, keep + ARENA_COMMIT_SIZE);
+    }
     Assert(arena->tempCount > 0)
     --arena->tempCount;
 }
@@ -115,6 +428,15 @@ CheckArena(memory_arena *arena)
     Assert(arena->tempCount == 0);
 }
 
+// NOTE : Nothing should be left in the scratch arena when the thread is done,
+// or it would pile up frame after frame.
+inline void
+CheckScratchArena(memory_arena *arena)
+{
+    CheckArena(arena);
+    Assert(arena->used == 0);
+}
+
 // NOTE : How much should I go to align by alignment?
 inline memory_index
 GetAlignmentOffset(memory_arena *arena, memory_index alignment)
@@ -146,12 +468,14 @@ GetArenaRemainingSize(memory_arena * arena, memory_index alignment=4)
     return result;
 }
 
-#define PushStruct(Arena, type) (type *)PushSize_(Arena, sizeof(type))
-#define PushArray(Arena, count, type) (type *)PushSize_(Arena, count * sizeof(type))
-#define PushSize(Arena, size) PushSize_(Arena, size)
+#define PushStruct(Arena, type) (type *)PushSize_(Arena, sizeof(type), 4, ARENA_SITE)
+#define PushArray(Arena, count, type) (type *)PushSize_(Arena, count * sizeof(type), 4, ARENA_SITE)
+#define PushSize(Arena, size) PushSize_(Arena, size, 4, ARENA_SITE)
+#define PushSizeAligned(Arena, size, alignment) PushSize_(Arena, size, alignment, ARENA_SITE)
 
+// NOTE : Takes the space, but does not commit it
 inline void *
-PushSize_(memory_arena *arena, memory_index sizeInit, memory_index alignment = 4)
+ReserveSize_(memory_arena *arena, memory_index sizeInit, memory_index alignment = 4, char *file = 0, int32 line = 0)
 {
     memory_index size = sizeInit;
 
@@ -161,42 +485,206 @@ PushSize_(memory_arena *arena, memory_index sizeInit, memory_index alignment = 4
     Assert(arena->used + size <= arena->size);
     void *result = arena->base + arena->used;
     arena->used += size;
+    if(arena->used > arena->zeroFrom)
+    {
+        arena->zeroFrom = arena->used;
+    }
 
     Assert(size >= sizeInit);
 
+#if FOX_ARENA_PROFILE
+    DEBUGRecordArenaPush(arena, file, line, size);
+#endif
+
     return result;
 }
 
+inline void *
+PushSize_(memory_arena *arena, memory_index sizeInit, memory_index alignment = 4, char *file = 0, int32 line = 0)
+{
+    void *result = ReserveSize_(arena, sizeInit, alignment, file, line);
+
+    if(arena->used > arena->committed)
+    {
+        // NOTE : Only from where this push starts, because the space before that 
+        // might be a sub arena, which commits its own memory.
+        memory_index commitStart = Maximum(arena->committed, (memory_index)((uint8 *)result - arena->base));
+        memory_index newCommitted = Minimum(AlignArenaCommitSize(arena->used), arena->size);
+
+        bool32 committed = arena->commitMemory(arena->base + commitStart, newCommitted - commitStart);
+        Assert(committed);
+        arena->committed = newCommitted;
+    }
+
+    return result;
+}
+
+#define SubArena(result, arena, size) SubArena_(result, arena, size, 16, ARENA_SITE)
+
+// NOTE : The sub arena commits its own memory as it grows, like the parent does.
 inline void
-SubArena(memory_arena *result, memory_arena *arena, memory_index size, memory_index alignment = 16)
+SubArena_(memory_arena *result, memory_arena *arena, memory_index size, memory_index alignment = 16, char *file = 0, int32 line = 0)
 {
-    result->size = size;
-    result->base = (uint8 *)PushSize_(arena, size, alignment);
-    result->used = 0;
-    result->tempCount = 0;
+    memory_index parentZeroFrom = arena->zeroFrom;
+    uint8 *base = (uint8 *)ReserveSize_(arena, size, alignment, file, line);
+    InitializeArena(result, size, base, arena->commitMemory, arena->decommitMemory);
+#if FOX_ARENA_PROFILE
+    DEBUGCopyArenaName(result->name, sizeof(result->name), arena->name);
+#endif
+
+    // NOTE : The parent might have used this space before
+    memory_index start = (memory_index)(base - arena->base);
+    if(parentZeroFrom > start)
+    {
+        result->zeroFrom = Minimum(parentZeroFrom - start, size);
+    }
 }
 
+// NOTE : Zeroing more than this goes around the cache with the non-temporal stores.
+// It's past the L2 by then, so the normal stores are not faster,
+// and they would throw away everything that was in the cache.
+#define ZERO_SIZE_STREAMING_THRESHOLD Megabytes(8)
+
 #define ZeroStruct(instance) ZeroSize(sizeof(instance), &(instance))
 // Zero memory
 inline void
 ZeroSize(memory_index size, void *ptr)
 {
-    // TODO : Check this guy for performance
     uint8 *byte = (uint8 *)ptr;
-    while(size--)
+
+    if(size >= 16)
+    {
+        // NOTE : One unaligned store for the head, then the aligned stores from the 16 byte boundary,
+        // and one unaligned store that ends at the end for the tail. They overlap, which is fine.
+        uint8 *end = byte + size;
+        __m128i zero = _mm_setzero_si128();
+        _mm_storeu_si128((__m128i *)byte, zero);
+        byte = (uint8 *)(((memory_index)byte + 16) & ~(memory_index)15);
+
+        if(size >= ZERO_SIZE_STREAMING_THRESHOLD)
+        {
+            while(byte + 64 <= end)
+            {
+                _mm_stream_si128((__m128i *)byte + 0, zero);
+                _mm_stream_si128((__m128i *)byte + 1, zero);
+                _mm_stream_si128((__m128i *)byte + 2, zero);
+                _mm_stream_si128((__m128i *)byte + 3, zero);
+                byte += 64;
+            }
+            // NOTE : The non-temporal stores are weakly ordered
+            _mm_sfence();
+        }
+        else
+        {
+            while(byte + 64 <= end)
+            {
+                _mm_store_si128((__m128i *)byte + 0, zero);
+                _mm_store_si128((__m128i *)byte + 1, zero);
+                _mm_store_si128((__m128i *)byte + 2, zero);
+                _mm_store_si128((__m128i *)byte + 3, zero);
+                byte += 64;
+            }
+        }
+
+        while(byte + 16 <= end)
+        {
+            _mm_store_si128((__m128i *)byte, zero);
+            byte += 16;
+        }
+        _mm_storeu_si128((__m128i *)(end - 16), zero);
+    }
+    else
     {
-        *byte++ = 0;
+        while(size--)
+        {
+            *byte++ = 0;
+        }
     }
 }
 
+#define PushStructZeroed(Arena, type) (type *)PushSizeZeroed_(Arena, sizeof(type), 4, ARENA_SITE)
+#define PushArrayZeroed(Arena, count, type) (type *)PushSizeZeroed_(Arena, (count)*sizeof(type), 4, ARENA_SITE)
+#define PushSizeZeroed(Arena, size) PushSizeZeroed_(Arena, size, 4, ARENA_SITE)
+
+// NOTE : Only clears the part that was handed out before
+inline void *
+PushSizeZeroed_(memory_arena *arena, memory_index size, memory_index alignment = 4, char *file = 0, int32 line = 0)
+{
+    memory_index zeroFrom = arena->zeroFrom;
+    uint8 *result = (uint8 *)PushSize_(arena, size, alignment, file, line);
+
+    memory_index start = (memory_index)(result - arena->base);
+    if(start < zeroFrom)
+    {
+        ZeroSize(Minimum(zeroFrom - start, size), result);
+    }
+
+    return result;
+}
+
+// NOTE : 8 bytes at a time, and then the rest
+inline bool32
+AreBytesEqual(memory_index size, void *aInit, void *bInit)
+{
+    bool32 result = true;
+
+    uint8 *a = (uint8 *)aInit;
+    uint8 *b = (uint8 *)bInit;
+    while(result && size >= sizeof(uint64))
+    {
+        result = (*(uint64 *)a == *(uint64 *)b);
+        a += sizeof(uint64);
+        b += sizeof(uint64);
+        size -= sizeof(uint64);
+    }
+
+    while(result && size--)
+    {
+        result = (*a++ == *b++);
+    }
+
+    return result;
+}
+
 #include "fox_intrinsics.h"
 #include "fox_math.h"
 #include "fox_world.h"
 #include "fox_sim_region.h"
 #include "fox_render_group.h"
 
+// NOTE : Only the entity types that need these have them
+union low_entity_payload
+{
+    // EntityType_Hero
+    struct
+    {
+        low_entity_handle sword;
+    } hero;
+
+    // EntityType_Familiar
+    struct
+    {
+        real32 tBob;
+    } familiar;
+
+    // EntityType_Stairwell
+    struct
+    {
+        v2 walkableDim;
+        real32 walkableHeight;
+    } stair;
+
+    // EntityType_Null, when this slot is in the free list
+    struct
+    {
+        uint32 nextFree;
+    } free;
+};
+
 // This entity is being updated in low frequency(enemy that is far away from the player)    
-// TODO : This is getting really huge. need to do something!
+// NOTE : This is the compressed version of the sim_entity.
+// BeginSim decompresses it to the sim_entity, and EndSim compresses it back,
+// so only the things that should survive between the frames are in here.
 struct low_entity
 {
     // TODO : It's kind of busted that pos can be invalid here,
@@ -204,12 +692,43 @@ struct low_entity
     // so we have to check both.
     // Can we do something better here?
     world_position pos;
-    sim_entity sim;
+    v3 dPos;
+    // NOTE : Where the renderer starts the last move of this entity from, relative to pos.
+    // The move is spread over moveStepCount steps from moveStep(see GetEntityRenderOffset).
+    v3 prevPos;
+    real32 distanceLimit;
+    // NOTE : Goes up every time this slot is deleted, see low_entity_handle
+    uint32 generation;
+    // NOTE : The last sim step that this entity was moved to,
+    // so that the low frequency update knows how far behind it is
+    uint32 lastSimStep;
+    // NOTE : The sim step that this entity was last moved in
+    uint32 moveStep;
+
+    sim_entity_collision_volume_group *collision;
+
+    // NOTE : filledAmount of each hit point, 4 bits each
+    uint64 hitPoints;
+
+    uint16 flags;
+    uint8 type;
+    uint8 facingDirection;
+    uint8 hitPointMax;
+    // NOTE : How many steps the last move was, 0 if there is nothing to spread
+    uint8 moveStepCount;
+    // NOTE : Where this entity is in the entity blocks of its chunk,
+    // so that we can remove it without searching. 0 if it's not in any chunk.
+    uint8 blockSlot;
+    world_entity_block *block;
+
+    low_entity_payload payload;
 };
 
+#include "fox_world_gen.h"
+
 struct controlled_hero
 {
-    uint32 entityIndex;
+    low_entity_handle entity;
     // Request for the hero ddp
     v2 ddPlayer;
     // Request for the sword dp
@@ -217,18 +736,56 @@ struct controlled_hero
     real32 dZ;
 };
 
-// This is an external hash!
+// NOTE : This is an internal hash keyed by the pair of storage indices!
+// Every rule is also linked into the rule list of both of its entities,
+// so that we can find all the rules of one entity without searching the entire table.
 struct pairwise_collision_rule
 {
-    // This is the only rule we currently have
-    bool32 canCollide;
-    
+    // storageIndexA is always smaller than storageIndexB,
+    // and 0 in storageIndexA means this slot is empty
     uint32 storageIndexA;
     // This is the target entity index
     uint32 storageIndexB;
 
-    // This is an external hash!    
-    pairwise_collision_rule *nextInHash;
+    // This is the only rule we currently have
+    bool32 canCollide;
+
+    // NOTE : These are slot + 1 of the neighbour rules in the list of each entity,
+    // so that 0 can be the end of the list
+    uint32 prevInA;
+    uint32 nextInA;
+    uint32 prevInB;
+    uint32 nextInB;
+};
+
+// Head of the rule list of one entity.
+// Only entities that have at least one rule are stored here.
+struct collision_rule_entity
+{
+    // 0 means this slot is empty
+    uint32 storageIndex;
+    // slot + 1 of the first rule
+    uint32 firstRule;
+};
+
+// NOTE : Only reserved, each of the arenas should fit the biggest tables
+#define COLLISION_RULE_ARENA_SIZE Megabytes(64)
+
+struct collision_rule_table
+{
+    // NOTE : When the tables grow, they are rebuilt in the other arena
+    // and the arena of the old ones is reset, so nothing is left behind.
+    memory_arena arenas[2];
+    uint32 currentArena;
+
+    // NOTE : Both of these tables must be power of two!
+    uint32 ruleCount;
+    uint32 ruleMaxCount;
+    pairwise_collision_rule *rules;
+
+    uint32 entityCount;
+    uint32 entityMaxCount;
+    collision_rule_entity *entities;
 };
 
 struct ground_buffer
@@ -274,27 +831,39 @@ GetBitmap(game_assets *assets, game_asset_id id)
     return result;
 }
 
+#define LOW_ENTITY_PAGE_SHIFT 12
+#define LOW_ENTITY_PAGE_SIZE (1 << LOW_ENTITY_PAGE_SHIFT)
+#define MAX_LOW_ENTITY_PAGE_COUNT 256
+#define MAX_LOW_ENTITY_COUNT (MAX_LOW_ENTITY_PAGE_COUNT*LOW_ENTITY_PAGE_SIZE)
+
+// NOTE : Low entities are stored in pages that are pushed to the world arena
+// when we run out of the slots, so we only pay for the entities we actually have.
+struct low_entity_storage
+{
+    // How many slots were ever used, including the free ones.
+    uint32 count;
+    // 0 if there is no free slot, because slot 0 is the null entity and never gets freed
+    uint32 firstFree;
+    low_entity *pages[MAX_LOW_ENTITY_PAGE_COUNT];
+};
+
 struct game_state
 {
     // What is this arena for?
     memory_arena worldArena;
-    world *world;
+    struct world *world;
     
     real32 typicalFloorHeight;
 
     // TODO : Should we allow split-sreen?
-    uint32 cameraFollowingEntityIndex;
+    low_entity_handle cameraFollowingEntity;
     world_position cameraPos;    
     
     controlled_hero controlledHeroes[ArrayCount(((game_input *)0)->controllers)];
 
-    uint32 lowEntityCount;
-    low_entity lowEntities[100000];
+    low_entity_storage lowEntities;
 
-    // TODO : Must be power of two!
-    // NOTE : This is external hash table as we store pointers, not entries!
-    pairwise_collision_rule *collisionRules[256];
-    pairwise_collision_rule *firstFreeCollisionRule;
+    collision_rule_table collisionRules;
 
     sim_entity_collision_volume_group *nullCollision;    
     sim_entity_collision_volume_group *swordCollision;
@@ -305,14 +874,73 @@ struct game_state
     sim_entity_collision_volume_group *wallCollision;
     sim_entity_collision_volume_group *standardRoomCollision;    
 
+    // NOTE : How each type moves, for both the sim region and the low frequency update
+    move_spec moveSpecs[EntityType_Count];
+
+    world_gen worldGen;
+
     real32 time;
 
+    // NOTE : The simulation always runs in steps of simStepDt,
+    // and the time that was not simulated yet is carried over to the next frame.
+    real32 simStepDt;
+    uint32 maxSimStepsPerFrame;
+    real32 simTimeAccumulator;
+    // NOTE : How many sim steps were done since the game started
+    uint32 simStepIndex;
+
     // TODO : Get rid of this because diff will not be used..?
     loaded_bitmap diff;
     loaded_bitmap diffNormal;
 
 };
 
+inline low_entity *
+GetLowEntity(low_entity_storage *storage, uint32 lowIndex)
+{
+    Assert(lowIndex < storage->count);
+    low_entity *result = storage->pages[lowIndex >> LOW_ENTITY_PAGE_SHIFT] + 
+                        (lowIndex & (LOW_ENTITY_PAGE_SIZE - 1));
+    return result;
+}
+
+inline low_entity *
+GetLowEntity(game_state *gameState, uint32 lowIndex)
+{
+    low_entity *result = GetLowEntity(&gameState->lowEntities, lowIndex);
+    return result;
+}
+
+inline bool32
+IsValid(game_state *gameState, low_entity_handle handle)
+{
+    bool32 result = (handle.index != 0 &&
+                    handle.index < gameState->lowEntities.count &&
+                    GetLowEntity(gameState, handle.index)->generation == handle.generation);
+    return result;
+}
+
+// Returns 0 if the entity was deleted
+inline low_entity *
+GetLowEntity(game_state *gameState, low_entity_handle handle)
+{
+    low_entity *result = IsValid(gameState, handle) ? GetLowEntity(gameState, handle.index) : 0;
+    return result;
+}
+
+inline low_entity_handle
+GetLowEntityHandle(game_state *gameState, uint32 lowIndex)
+{
+    low_entity_handle result = {};
+    if(lowIndex)
+    {
+        result.index = lowIndex;
+        result.generation = GetLowEntity(gameState, lowIndex)->generation;
+    }
+
+    return result;
+}
+
 struct transient_state
 {
     bool32 isInitialized;
@@ -321,6 +949,13 @@ struct transient_state
     uint32 groundBufferCount;
     ground_buffer *groundBuffers;
 
+    sim_entity_hash_table simEntityHash;
+
+    world_gen_job worldGenJobs[WORLD_GEN_MAX_JOB_COUNT];
+    // NOTE : How many regions were asked for, and how many of them went into the world
+    uint32 worldGenRequestCount;
+    uint32 worldGenInsertCount;
+
     int32 envMapWidth;
     int32 envMapHeight;
     // 1 : bottom ,2 : middle, 3 : top
@@ -331,5 +966,6 @@ struct transient_state
 
 // These functions should be called externally
 internal void LoadAsset(game_assets *assets, game_asset_id id);
+internal void DeleteLowEntity(game_state *gameState, sim_region *simRegion, uint32 lowIndex);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1124 @@
+/******************************************************************************
+File:   fox_bench.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    Benchmarks for the hot parts of the game code. Built like fox_test.cpp, but optimized
+    and without the asserts(see build.sh), so the numbers are close to the release build.
+
+    ./fox_bench           runs every benchmark
+    ./fox_bench Collision runs the ones that have Collision in their name
+
+    The numbers are only good for comparing two builds on the same machine!
+*****/
+
+#include "fox.cpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "linux_fox.h"
+#include "linux_fox_memory.cpp"
+#include "linux_fox_queue.cpp"
+#include "linux_fox_file.cpp"
+
+internal real64
+GetBenchSeconds()
+{
+    timespec clock;
+    clock_gettime(CLOCK_MONOTONIC, &clock);
+    real64 result = (real64)clock.tv_sec + 1e-9*(real64)clock.tv_nsec;
+    return result;
+}
+
+// NOTE : The same numbers every run, and the period is much longer than the random table
+struct bench_series
+{
+    uint32 index;
+};
+
+inline uint32
+NextBenchRandom(bench_series *series)
+{
+    uint32 result = HashUInt32(series->index++);
+    return result;
+}
+
+inline uint32
+BenchRandomChoice(bench_series *series, uint32 choiceCount)
+{
+    uint32 result = NextBenchRandom(series) % choiceCount;
+    return result;
+}
+
+// NOTE : The game state that every benchmark gets, initialized like GameUpdateAndRender does
+// on the memory that is reserved like the platform layer does.
+struct bench_memory
+{
+    game_memory gameMemory;
+    game_state *gameState;
+    memory_arena tranArena;
+};
+
+internal void
+BeginBenchMemory(bench_memory *memory)
+{
+    *memory = {};
+
+    game_memory *gameMemory = &memory->gameMemory;
+    gameMemory->permanentStorageSize = Gigabytes(1);
+    gameMemory->transientStorageSize = Gigabytes(4);
+    bool32 reserved = LinuxReserveGameMemory(gameMemory, 0, Kilobytes(64));
+    Assert(reserved);
+    debugGlobalMemory = gameMemory;
+
+    gameMemory->platformCommitMemory(gameMemory->permanentStorage, sizeof(game_state));
+    game_state *gameState = (game_state *)gameMemory->permanentStorage;
+    InitializeArena(&gameState->worldArena,
+                    (memory_index)(gameMemory->permanentStorageSize - sizeof(game_state)),
+                    (uint8 *)gameMemory->permanentStorage + sizeof(game_state),
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    gameState->world = PushStruct(&gameState->worldArena, world);
+    InitializeCollisionRules(&gameState->collisionRules, &gameState->worldArena);
+    gameState->typicalFloorHeight = 3.0f;
+    gameState->simStepDt = 1.0f / 30.0f;
+    InitializeWorld(gameState->world, &gameState->worldArena,
+                    V3(256.0f / 42.0f, 256.0f / 42.0f, gameState->typicalFloorHeight));
+    // NOTE : Only for the tile positions, the same tiles as the game
+    InitializeWorldGen(&gameState->worldGen, gameState->world, 321, 10, 10, 1.4f, 3.0f);
+    InitializeMoveSpecs(gameState);
+
+    // NOTE : Slot 0 is the null entity
+    AddLowEntity(gameState, EntityType_Null, NullPosition(), 0);
+    gameState->lowEntities.count = 1;
+
+    InitializeArena(&memory->tranArena, (memory_index)gameMemory->transientStorageSize,
+                    gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+
+    memory->gameState = gameState;
+}
+
+internal void
+EndBenchMemory(bench_memory *memory)
+{
+    game_memory *gameMemory = &memory->gameMemory;
+    munmap(gameMemory->permanentStorage,
+            (uint8 *)gameMemory->transientStorage - (uint8 *)gameMemory->permanentStorage +
+            gameMemory->transientStorageSize + Kilobytes(64));
+    debugGlobalMemory = 0;
+}
+
+//
+// NOTE : Benchmarks
+//
+
+// NOTE : 100k entities, and every frame 2000 swords hit the hero that threw them and 8 others,
+// get looked up, and then go away. This is way more than the game does,
+// so that the growing and the clearing of the tables show up.
+internal void
+BenchCollisionRuleChurn()
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    collision_rule_table *table = &gameState->collisionRules;
+
+    uint32 entityCount = 100000;
+    uint32 swordCount = 2000;
+    uint32 hitCount = 8;
+    uint32 lookupCount = 200000;
+    uint32 frameCount = 200;
+
+    bench_series series = {1234};
+    uint32 collideCount = 0;
+    uint32 mostRules = 0;
+    real64 addSeconds = 0.0;
+    real64 lookupSeconds = 0.0;
+    real64 clearSeconds = 0.0;
+    for(uint32 frameIndex = 0;
+        frameIndex < frameCount;
+        ++frameIndex)
+    {
+        real64 start = GetBenchSeconds();
+        for(uint32 swordIndex = 0;
+            swordIndex < swordCount;
+            ++swordIndex)
+        {
+            uint32 sword = entityCount + 1 + swordIndex;
+            uint32 hero = 1 + BenchRandomChoice(&series, entityCount);
+            AddCollisionRule(gameState, 0, hero, sword, false);
+            for(uint32 hitIndex = 0;
+                hitIndex < hitCount;
+                ++hitIndex)
+            {
+                uint32 hit = 1 + BenchRandomChoice(&series, entityCount);
+                AddCollisionRule(gameState, 0, sword, hit, false);
+            }
+        }
+        real64 added = GetBenchSeconds();
+        mostRules = Maximum(mostRules, table->ruleCount);
+
+        for(uint32 lookupIndex = 0;
+            lookupIndex < lookupCount;
+            ++lookupIndex)
+        {
+            uint32 a = 1 + BenchRandomChoice(&series, entityCount + swordCount);
+            uint32 b = 1 + BenchRandomChoice(&series, entityCount + swordCount);
+            if(a != b)
+            {
+                pairwise_collision_rule *rule = FindCollisionRule(table, Minimum(a, b), Maximum(a, b));
+                collideCount += rule ? rule->canCollide : true;
+            }
+        }
+        real64 lookedUp = GetBenchSeconds();
+
+        for(uint32 swordIndex = 0;
+            swordIndex < swordCount;
+            ++swordIndex)
+        {
+            ClearCollisionRulesFor(gameState, 0, entityCount + 1 + swordIndex);
+        }
+        real64 cleared = GetBenchSeconds();
+
+        addSeconds += added - start;
+        lookupSeconds += lookedUp - added;
+        clearSeconds += cleared - lookedUp;
+    }
+
+    memory_index arenaUsed = table->arenas[0].used + table->arenas[1].used;
+    memory_index tableSize = table->ruleMaxCount*sizeof(pairwise_collision_rule) +
+                            table->entityMaxCount*sizeof(collision_rule_entity);
+    printf("  add %.3fms/f, lookup %.3fms/f, clear %.3fms/f, %u rules at most\n",
+        1000.0*addSeconds / frameCount, 1000.0*lookupSeconds / frameCount, 1000.0*clearSeconds / frameCount,
+        mostRules);
+    printf("  %uKB used in the collision rule arenas for the %uKB tables, %uKB committed in the world arena (%u)\n",
+        (uint32)(arenaUsed / 1024), (uint32)(tableSize / 1024),
+        (uint32)(gameState->worldArena.committed / 1024), collideCount);
+
+    EndBenchMemory(&memory);
+}
+
+// NOTE : What CanCollide did before the sim region had its own rules
+internal bool32
+CanCollideWithGlobalRules(game_state *gameState, sim_entity *a, sim_entity *b)
+{
+    bool32 result = false;
+
+    if(a != b)
+    {
+        if(a->storageIndex > b->storageIndex)
+        {
+            sim_entity *temp = a;
+            a = b;
+            b = temp;
+        }
+
+        if(IsSet(a, EntityFlag_CanCollide) &&
+            IsSet(b, EntityFlag_CanCollide))
+        {
+            if(!IsSet(a, EntityFlag_Nonspatial) &&
+                !IsSet(b, EntityFlag_Nonspatial))
+            {
+                result = true;
+            }
+
+            collision_rule_table *table = &gameState->collisionRules;
+            if(table->ruleCount)
+            {
+                pairwise_collision_rule *rule = FindCollisionRule(table, a->storageIndex, b->storageIndex);
+                if(rule)
+                {
+                    result = rule->canCollide;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// NOTE : A sim region packed with colliding walls and a lot of rules,
+// 10k between the walls inside and 18k to the walls far away, like the swords leave behind.
+// Every pair is asked like the inner loop of MoveEntity does,
+// once through the rules of the sim region and once through the table of the game state.
+internal void
+BenchCanCollide()
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    int32 tileRadius = 20;
+    uint32 insideCount = 0;
+    for(int32 tileY = -tileRadius;
+        tileY <= tileRadius;
+        ++tileY)
+    {
+        for(int32 tileX = -tileRadius;
+            tileX <= tileRadius;
+            ++tileX)
+        {
+            AddWall(gameState, tileX, tileY, 0);
+            ++insideCount;
+        }
+    }
+    uint32 firstInside = 1;
+    uint32 outsideCount = 2000;
+    for(uint32 outsideIndex = 0;
+        outsideIndex < outsideCount;
+        ++outsideIndex)
+    {
+        AddWall(gameState, 1000 + outsideIndex, 1000, 0);
+    }
+    uint32 firstOutside = firstInside + insideCount;
+
+    bench_series series = {777};
+    uint32 insideRuleCount = 10000;
+    uint32 outsideRuleCount = 18000;
+    for(uint32 ruleIndex = 0;
+        ruleIndex < insideRuleCount + outsideRuleCount;
+        ++ruleIndex)
+    {
+        uint32 a = firstInside + BenchRandomChoice(&series, insideCount);
+        uint32 b = (ruleIndex < insideRuleCount) ?
+            firstInside + BenchRandomChoice(&series, insideCount) :
+            firstOutside + BenchRandomChoice(&series, outsideCount);
+        if(a != b)
+        {
+            AddCollisionRule(gameState, 0, a, b, (ruleIndex & 1));
+        }
+    }
+
+    sim_entity_hash_table hash = {};
+    InitializeSimEntityHash(&hash, &memory.tranArena);
+
+    rect3 cameraBounds = RectCenterDim(V3(0, 0, 0), V3(960.0f / 42.0f, 540.0f / 42.0f, 0.0f));
+    cameraBounds.min.z = -3.0f*gameState->typicalFloorHeight;
+    cameraBounds.max.z = 1.0f*gameState->typicalFloorHeight;
+    rect3 simBounds = AddRadiusToRect(cameraBounds, V3(15.0f, 15.0f, 0.0f));
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+
+    temporary_memory simMemory = BeginTemporaryMemory(&memory.tranArena);
+    real64 start = GetBenchSeconds();
+    sim_region *simRegion = BeginSim(&memory.tranArena, &hash, gameState, gameState->world,
+                                    origin, simBounds, cameraBounds, gameState->simStepDt);
+    real64 beginSeconds = GetBenchSeconds() - start;
+
+    uint32 entityCount = simRegion->entityCount;
+    uint32 cachedCount = 0;
+    uint32 globalCount = 0;
+    uint32 mismatchCount = 0;
+    real64 cachedSeconds = Real32Max;
+    real64 globalSeconds = Real32Max;
+    uint32 batchCount = 5;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        cachedCount = 0;
+        globalCount = 0;
+        real64 batchStart = GetBenchSeconds();
+        for(uint32 indexA = 0;
+            indexA < entityCount;
+            ++indexA)
+        {
+            for(uint32 indexB = indexA + 1;
+                indexB < entityCount;
+                ++indexB)
+            {
+                cachedCount += CanCollide(gameState, simRegion,
+                                        simRegion->entities + indexA, simRegion->entities + indexB);
+            }
+        }
+        real64 cachedDone = GetBenchSeconds();
+        for(uint32 indexA = 0;
+            indexA < entityCount;
+            ++indexA)
+        {
+            for(uint32 indexB = indexA + 1;
+                indexB < entityCount;
+                ++indexB)
+            {
+                globalCount += CanCollideWithGlobalRules(gameState,
+                                                        simRegion->entities + indexA, simRegion->entities + indexB);
+            }
+        }
+        real64 globalDone = GetBenchSeconds();
+
+        cachedSeconds = Minimum(cachedSeconds, cachedDone - batchStart);
+        globalSeconds = Minimum(globalSeconds, globalDone - cachedDone);
+    }
+
+    // NOTE : Both should say the same thing for every pair
+    for(uint32 indexA = 0;
+        indexA < entityCount;
+        ++indexA)
+    {
+        for(uint32 indexB = indexA + 1;
+            indexB < entityCount;
+            ++indexB)
+        {
+            sim_entity *a = simRegion->entities + indexA;
+            sim_entity *b = simRegion->entities + indexB;
+            mismatchCount += (CanCollide(gameState, simRegion, a, b) != CanCollideWithGlobalRules(gameState, a, b));
+        }
+    }
+
+    uint64 pairCount = (uint64)entityCount*(entityCount - 1) / 2;
+    printf("  %u entities, %u rules(%u in the region), BeginSim %.1fus\n",
+        entityCount, gameState->collisionRules.ruleCount, simRegion->collisionRuleCount, 1000000.0*beginSeconds);
+    printf("  %llu pairs : sim region %.1fms(%u collide), game state %.1fms(%u collide), %u mismatches\n",
+        (unsigned long long)pairCount, 1000.0*cachedSeconds, cachedCount, 
+        1000.0*globalSeconds, globalCount, mismatchCount);
+
+    EndSim(simRegion, gameState);
+    EndTemporaryMemory(simMemory);
+
+    EndBenchMemory(&memory);
+}
+
+struct bench_sim_region_result
+{
+    uint32 entityCount;
+    uint32 lowEntityCount;
+    real64 beginSeconds;
+    real64 endSeconds;
+    real64 copyInSeconds;
+    real64 copyOutSeconds;
+};
+
+// NOTE : The walls are put every tileStep tiles in a square of tileRadius around the origin.
+// Every tile is about what a room full of walls looks like, every 10th tile is a few walls per room.
+internal bench_sim_region_result
+BenchSimRegionWithWalls(int32 tileRadius, int32 tileStep)
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    for(int32 tileY = -tileRadius;
+        tileY <= tileRadius;
+        tileY += tileStep)
+    {
+        for(int32 tileX = -tileRadius;
+            tileX <= tileRadius;
+            tileX += tileStep)
+        {
+            AddWall(gameState, tileX, tileY, 0);
+        }
+    }
+
+    sim_entity_hash_table hash = {};
+    InitializeSimEntityHash(&hash, &memory.tranArena);
+
+    // NOTE : Same bounds as the game, with the 960x540 screen
+    rect3 cameraBounds = RectCenterDim(V3(0, 0, 0), V3(960.0f / 42.0f, 540.0f / 42.0f, 0.0f));
+    cameraBounds.min.z = -3.0f*gameState->typicalFloorHeight;
+    cameraBounds.max.z = 1.0f*gameState->typicalFloorHeight;
+    rect3 simBounds = AddRadiusToRect(cameraBounds, V3(15.0f, 15.0f, 0.0f));
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+
+    // NOTE : What the storage was before the low entities were compressed : a whole sim_entity
+    // for each slot, which the sim region copied in and out as it is.
+    low_entity_storage *storage = &gameState->lowEntities;
+    uint32 lowEntityCount = storage->count;
+    sim_entity *uncompressed = PushArray(&memory.tranArena, lowEntityCount, sim_entity);
+    for(uint32 lowIndex = 1;
+        lowIndex < storage->count;
+        ++lowIndex)
+    {
+        DecompressEntity(GetLowEntity(gameState, lowIndex), uncompressed + lowIndex);
+    }
+
+    // NOTE : The fastest batch, because the other processes on the machine only ever make it slower
+    bench_sim_region_result result = {};
+    result.lowEntityCount = lowEntityCount;
+    result.beginSeconds = Real32Max;
+    result.endSeconds = Real32Max;
+    result.copyInSeconds = Real32Max;
+    result.copyOutSeconds = Real32Max;
+    uint32 batchCount = 20;
+    uint32 iterationCount = 100;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        real64 beginSeconds = 0.0;
+        real64 endSeconds = 0.0;
+        real64 copyInSeconds = 0.0;
+        real64 copyOutSeconds = 0.0;
+        for(uint32 iteration = 0;
+            iteration < iterationCount;
+            ++iteration)
+        {
+            temporary_memory simMemory = BeginTemporaryMemory(&memory.tranArena);
+            real64 start = GetBenchSeconds();
+            sim_region *simRegion = BeginSim(&memory.tranArena, &hash, gameState, gameState->world,
+                                            origin, simBounds, cameraBounds, gameState->simStepDt);
+            real64 begun = GetBenchSeconds();
+            EndSim(simRegion, gameState);
+            real64 ended = GetBenchSeconds();
+            result.entityCount = simRegion->entityCount;
+
+            // NOTE : Only the copies of the same entities, without the query, so this is
+            // the least that the uncompressed storage would have cost.
+            sim_entity *copies = PushArray(&memory.tranArena, simRegion->entityCount, sim_entity);
+            real64 copyStart = GetBenchSeconds();
+            for(uint32 entityIndex = 0;
+                entityIndex < simRegion->entityCount;
+                ++entityIndex)
+            {
+                copies[entityIndex] = uncompressed[simRegion->entities[entityIndex].storageIndex];
+            }
+            real64 copiedIn = GetBenchSeconds();
+            for(uint32 entityIndex = 0;
+                entityIndex < simRegion->entityCount;
+                ++entityIndex)
+            {
+                uncompressed[simRegion->entities[entityIndex].storageIndex] = copies[entityIndex];
+            }
+            real64 copiedOut = GetBenchSeconds();
+            EndTemporaryMemory(simMemory);
+
+            beginSeconds += begun - start;
+            endSeconds += ended - begun;
+            copyInSeconds += copiedIn - copyStart;
+            copyOutSeconds += copiedOut - copiedIn;
+        }
+        result.beginSeconds = Minimum(result.beginSeconds, beginSeconds / iterationCount);
+        result.endSeconds = Minimum(result.endSeconds, endSeconds / iterationCount);
+        result.copyInSeconds = Minimum(result.copyInSeconds, copyInSeconds / iterationCount);
+        result.copyOutSeconds = Minimum(result.copyOutSeconds, copyOutSeconds / iterationCount);
+    }
+
+    EndBenchMemory(&memory);
+
+    return result;
+}
+
+// NOTE : BeginSim and EndSim without any update in between, once for a region that is packed with walls
+// and once for a region that only has a few. Also what the low entities take in memory,
+// against the whole sim_entity that each slot used to be.
+internal void
+BenchSimRegion()
+{
+    bench_sim_region_result dense = BenchSimRegionWithWalls(40, 1);
+    bench_sim_region_result sparse = BenchSimRegionWithWalls(40, 10);
+
+    printf("  low_entity %u bytes, sim_entity %u bytes\n",
+        (uint32)sizeof(low_entity), (uint32)sizeof(sim_entity));
+    printf("  storage of %u low entities : %.1fKB, uncompressed %.1fKB\n",
+        dense.lowEntityCount,
+        (real64)(dense.lowEntityCount*sizeof(low_entity)) / 1024.0,
+        (real64)(dense.lowEntityCount*sizeof(sim_entity)) / 1024.0);
+
+    printf("  dense(%u entities) : BeginSim %.1fus, EndSim %.1fus, uncompressed copy in %.1fus, out %.1fus\n",
+        dense.entityCount, 1000000.0*dense.beginSeconds, 1000000.0*dense.endSeconds,
+        1000000.0*dense.copyInSeconds, 1000000.0*dense.copyOutSeconds);
+    printf("  sparse(%u entities) : BeginSim %.1fus, EndSim %.1fus, uncompressed copy in %.1fus, out %.1fus\n",
+        sparse.entityCount, 1000000.0*sparse.beginSeconds, 1000000.0*sparse.endSeconds,
+        1000000.0*sparse.copyInSeconds, 1000000.0*sparse.copyOutSeconds);
+}
+
+// NOTE : 4M chunks in a square of one floor, which is sixty four times more than the old table could hold.
+// Then the lookups of the chunks that are there, and of the empty space around them,
+// which is most of what the streaming and the low frequency update look up.
+internal void
+BenchWorldChunkHash()
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    world *world_ = gameState->world;
+
+    int32 sideCount = 2048;
+    real64 start = GetBenchSeconds();
+    for(int32 chunkY = 0;
+        chunkY < sideCount;
+        ++chunkY)
+    {
+        for(int32 chunkX = 0;
+            chunkX < sideCount;
+            ++chunkX)
+        {
+            GetWorldChunk(world_, chunkX, chunkY, 0, &gameState->worldArena);
+        }
+    }
+    real64 insertSeconds = GetBenchSeconds() - start;
+
+    uint32 lookupCount = 1000000;
+    bench_series series = {4321};
+    uint32 hitCount = 0;
+    real64 hitSeconds = Real32Max;
+    real64 missSeconds = Real32Max;
+    uint32 batchCount = 5;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        start = GetBenchSeconds();
+        for(uint32 lookupIndex = 0;
+            lookupIndex < lookupCount;
+            ++lookupIndex)
+        {
+            int32 chunkX = (int32)BenchRandomChoice(&series, sideCount);
+            int32 chunkY = (int32)BenchRandomChoice(&series, sideCount);
+            hitCount += (GetWorldChunk(world_, chunkX, chunkY, 0) != 0);
+        }
+        real64 hit = GetBenchSeconds();
+        for(uint32 lookupIndex = 0;
+            lookupIndex < lookupCount;
+            ++lookupIndex)
+        {
+            // NOTE : The floors above and below are empty
+            int32 chunkX = (int32)BenchRandomChoice(&series, sideCount);
+            int32 chunkY = (int32)BenchRandomChoice(&series, sideCount);
+            hitCount += (GetWorldChunk(world_, chunkX, chunkY, 1 - 2*(lookupIndex & 1)) != 0);
+        }
+        real64 missed = GetBenchSeconds();
+
+        hitSeconds = Minimum(hitSeconds, hit - start);
+        missSeconds = Minimum(missSeconds, missed - hit);
+    }
+
+    printf("  insert %.1fns/chunk, hit %.1fns, miss %.1fns, %u chunks in %u slots(%u hits)\n",
+        1e9*insertSeconds / (sideCount*sideCount), 1e9*hitSeconds / lookupCount, 1e9*missSeconds / lookupCount,
+        world_->chunkCount, world_->chunkHashMaxCount, hitCount);
+
+    EndBenchMemory(&memory);
+}
+
+// NOTE : 64k walls packed into chunks of entityPerChunk, and random walls hopping to the next chunk
+// or moving inside their own chunk. The entity knows where it is in its block, 
+// so hopping out of a crowded chunk should cost the same as out of an empty one.
+internal void
+BenchChunkCrossingWithDensity(uint32 entityPerChunk)
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    world *world_ = gameState->world;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    uint32 entityCount = 65536;
+    uint32 chunkCount = entityCount / entityPerChunk;
+    uint32 firstIndex = gameState->lowEntities.count;
+    for(uint32 entityIndex = 0;
+        entityIndex < entityCount;
+        ++entityIndex)
+    {
+        world_position pos = CenteredChunkPoint(entityIndex % chunkCount, 0, 0);
+        AddLowEntity(gameState, EntityType_Wall, pos, gameState->wallCollision);
+    }
+
+    bench_series series = {5678};
+    uint32 moveCount = 200000;
+    real64 crossSeconds = Real32Max;
+    real64 staySeconds = Real32Max;
+    uint32 batchCount = 5;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        real64 start = GetBenchSeconds();
+        for(uint32 moveIndex = 0;
+            moveIndex < moveCount;
+            ++moveIndex)
+        {
+            uint32 lowIndex = firstIndex + BenchRandomChoice(&series, entityCount);
+            low_entity *low = GetLowEntity(&gameState->lowEntities, lowIndex);
+            // NOTE : Back and forth between the two chunks, so the densities stay the same
+            int32 chunkX = low->pos.chunkX ^ 1;
+            if((uint32)chunkX >= chunkCount)
+            {
+                chunkX = low->pos.chunkX;
+            }
+            ChangeEntityLocation(world_, &gameState->lowEntities, lowIndex, CenteredChunkPoint(chunkX, 0, 0));
+        }
+        real64 crossed = GetBenchSeconds();
+        for(uint32 moveIndex = 0;
+            moveIndex < moveCount;
+            ++moveIndex)
+        {
+            uint32 lowIndex = firstIndex + BenchRandomChoice(&series, entityCount);
+            low_entity *low = GetLowEntity(&gameState->lowEntities, lowIndex);
+            world_position pos = low->pos;
+            pos.offset_.x = 0.5f - pos.offset_.x;
+            ChangeEntityLocation(world_, &gameState->lowEntities, lowIndex, pos);
+        }
+        real64 stayed = GetBenchSeconds();
+
+        crossSeconds = Minimum(crossSeconds, crossed - start);
+        staySeconds = Minimum(staySeconds, stayed - crossed);
+    }
+
+    printf("  %u per chunk : cross %.1fns, stay %.1fns\n", entityPerChunk,
+        1e9*crossSeconds / moveCount, 1e9*staySeconds / moveCount);
+
+    EndBenchMemory(&memory);
+}
+
+internal void
+BenchChunkCrossing()
+{
+    BenchChunkCrossingWithDensity(16);
+    BenchChunkCrossingWithDensity(256);
+    BenchChunkCrossingWithDensity(4096);
+}
+
+// NOTE : The world query of the sim region in a world that is full of walls, at the entity cap.
+// The walls are as far apart as they need to be to spread 100k of them over the area,
+// so a chunk that is on the edge of the bounds has a lot of walls that are outside.
+// The caches are thrown away before every query, because the low entities outside of the sim region
+// are usually not in the cache.
+// With cull, the bounds in the entity blocks throw out the walls first, like BeginSim does.
+internal void
+BenchWorldQueryWithSpacing(int32 tileSpacing, bool32 flush, bool32 cull)
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    int32 sideCount = 316;
+    int32 tileRadius = (sideCount / 2)*tileSpacing;
+    for(int32 tileY = -tileRadius;
+        tileY < tileRadius;
+        tileY += tileSpacing)
+    {
+        for(int32 tileX = -tileRadius;
+            tileX < tileRadius;
+            tileX += tileSpacing)
+        {
+            AddWall(gameState, tileX, tileY, 0);
+        }
+    }
+
+    // NOTE : Same bounds as the sim region of the game, with the 960x540 screen
+    rect3 cameraBounds = RectCenterDim(V3(0, 0, 0), V3(960.0f / 42.0f, 540.0f / 42.0f, 0.0f));
+    cameraBounds.min.z = -3.0f*gameState->typicalFloorHeight;
+    cameraBounds.max.z = 1.0f*gameState->typicalFloorHeight;
+    rect3 bounds = AddRadiusToRect(cameraBounds, V3(15.0f + 5.0f, 15.0f + 5.0f, 0.0f));
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+
+    memory_index flushSize = Megabytes(32);
+    uint8 *flushMemory = (uint8 *)PushSize(&memory.tranArena, flushSize);
+
+    uint32 candidateCount = 0;
+    uint32 culledCount = 0;
+    uint32 overlapCount = 0;
+    real64 bestSeconds = Real32Max;
+    uint32 batchCount = 10;
+    uint32 iterationCount = 20;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        real64 seconds = 0.0;
+        for(uint32 iteration = 0;
+            iteration < iterationCount;
+            ++iteration)
+        {
+            if(flush)
+            {
+                for(memory_index offset = 0;
+                    offset < flushSize;
+                    offset += 64)
+                {
+                    ++flushMemory[offset];
+                }
+            }
+
+            temporary_memory queryMemory = BeginTemporaryMemory(&memory.tranArena);
+            real64 start = GetBenchSeconds();
+            candidateCount = 0;
+            culledCount = 0;
+            overlapCount = 0;
+            world_query query = BeginWorldQuery(gameState->world, &memory.tranArena, origin, bounds);
+            world_chunk *testChunk = 0;
+            world_entity_bounds_test boundsTest = {};
+            for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+                IsValid(&iter);
+                Advance(&iter))
+            {
+                if(cull)
+                {
+                    if(iter.chunk != testChunk)
+                    {
+                        testChunk = iter.chunk;
+                        boundsTest = GetEntityBoundsTest(gameState->world, testChunk, origin, bounds);
+                    }
+                    if(!EntityBoundsMightOverlap(iter.block, iter.entitySlot, &boundsTest))
+                    {
+                        ++culledCount;
+                        continue;
+                    }
+                }
+
+                low_entity *low = GetLowEntity(gameState, iter.lowEntityIndex);
+                v3 pos = SubstractTwoWMP(gameState->world, &low->pos, &origin);
+                ++candidateCount;
+                overlapCount += EntityOverlapsRectangle(pos, low->collision->totalVolume, bounds);
+            }
+            seconds += GetBenchSeconds() - start;
+            EndTemporaryMemory(queryMemory);
+        }
+        bestSeconds = Minimum(bestSeconds, seconds / iterationCount);
+    }
+
+    printf("  every %d tiles%s%s : %.1fus, %u candidates, %u culled, %u overlap, %u entities\n", 
+        tileSpacing, flush ? "(cold)" : "", cull ? "(culled)" : "", 1000000.0*bestSeconds, 
+        candidateCount, culledCount, overlapCount, gameState->lowEntities.count - 1);
+
+    EndBenchMemory(&memory);
+}
+
+internal void
+BenchWorldQuery()
+{
+    BenchWorldQueryWithSpacing(1, false, false);
+    BenchWorldQueryWithSpacing(1, false, true);
+    BenchWorldQueryWithSpacing(1, true, false);
+    BenchWorldQueryWithSpacing(1, true, true);
+    BenchWorldQueryWithSpacing(3, true, false);
+    BenchWorldQueryWithSpacing(3, true, true);
+}
+
+// NOTE : Query and iteration of the big boxes, in a sparse world that has walls here and there,
+// and in a dense world that has a wall in every tile around the origin.
+internal real64
+BenchWorldQueryBox(game_state *gameState, memory_arena *tempArena, real32 boxSide, uint32 *entityCount)
+{
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+    rect3 bounds = RectCenterDim(V3(0, 0, 0), V3(boxSide, boxSide, gameState->typicalFloorHeight));
+
+    real64 bestSeconds = Real32Max;
+    uint32 batchCount = 10;
+    uint32 iterationCount = 10;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        real64 seconds = 0.0;
+        for(uint32 iteration = 0;
+            iteration < iterationCount;
+            ++iteration)
+        {
+            temporary_memory queryMemory = BeginTemporaryMemory(tempArena);
+            real64 start = GetBenchSeconds();
+            *entityCount = 0;
+            world_query query = BeginWorldQuery(gameState->world, tempArena, origin, bounds);
+            for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+                IsValid(&iter);
+                Advance(&iter))
+            {
+                ++*entityCount;
+            }
+            seconds += GetBenchSeconds() - start;
+            EndTemporaryMemory(queryMemory);
+        }
+        bestSeconds = Minimum(bestSeconds, seconds / iterationCount);
+    }
+
+    return bestSeconds;
+}
+
+internal void
+BenchWorldQuerySparseAndDense()
+{
+    real32 boxSides[] = {400.0f, 2000.0f};
+    for(uint32 worldIndex = 0;
+        worldIndex < 2;
+        ++worldIndex)
+    {
+        bench_memory memory;
+        BeginBenchMemory(&memory);
+        game_state *gameState = memory.gameState;
+        gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+        bool32 isDense = (worldIndex == 1);
+        if(isDense)
+        {
+            int32 tileRadius = 158;
+            for(int32 tileY = -tileRadius;
+                tileY < tileRadius;
+                ++tileY)
+            {
+                for(int32 tileX = -tileRadius;
+                    tileX < tileRadius;
+                    ++tileX)
+                {
+                    AddWall(gameState, tileX, tileY, 0);
+                }
+            }
+        }
+        else
+        {
+            // NOTE : One wall in about every hundred chunks
+            bench_series series = {99};
+            int32 tileRadius = 1000;
+            for(uint32 wallIndex = 0;
+                wallIndex < 2000;
+                ++wallIndex)
+            {
+                int32 tileX = (int32)BenchRandomChoice(&series, 2*tileRadius) - tileRadius;
+                int32 tileY = (int32)BenchRandomChoice(&series, 2*tileRadius) - tileRadius;
+                AddWall(gameState, tileX, tileY, 0);
+            }
+        }
+
+        for(uint32 boxIndex = 0;
+            boxIndex < ArrayCount(boxSides);
+            ++boxIndex)
+        {
+            uint32 entityCount = 0;
+            real64 seconds = BenchWorldQueryBox(gameState, &memory.tranArena, boxSides[boxIndex], &entityCount);
+            printf("  %s world(%u occupied chunks), %.0fm box : %.1fus, %u entities\n",
+                isDense ? "dense" : "sparse", gameState->world->occupiedChunkCount, boxSides[boxIndex],
+                1000000.0*seconds, entityCount);
+        }
+
+        EndBenchMemory(&memory);
+    }
+}
+
+// NOTE : Each path of BeginWorldQuery on its own, on the same sparse world at several box sizes.
+// The hash probe is the baseline that looks up every chunk in the bounds, like the query did before the bitmap.
+enum bench_world_query_path
+{
+    BenchWorldQueryPath_Bitmap,
+    BenchWorldQueryPath_OccupiedList,
+    BenchWorldQueryPath_HashProbe,
+
+    BenchWorldQueryPath_Count,
+};
+
+internal real64
+BenchWorldQueryPath(world *world_, memory_arena *tempArena, world_position minChunkPos, world_position maxChunkPos, 
+                    bench_world_query_path path, uint32 *chunkCount)
+{
+    real64 bestSeconds = Real32Max;
+    uint32 batchCount = 10;
+    uint32 iterationCount = 10;
+    for(uint32 batch = 0;
+        batch < batchCount;
+        ++batch)
+    {
+        real64 seconds = 0.0;
+        for(uint32 iteration = 0;
+            iteration < iterationCount;
+            ++iteration)
+        {
+            temporary_memory queryMemory = BeginTemporaryMemory(tempArena);
+            real64 start = GetBenchSeconds();
+            world_query query = {};
+            query.world = world_;
+            switch(path)
+            {
+                case BenchWorldQueryPath_Bitmap :
+                {
+                    AddWorldQueryChunksFromBitmap(&query, tempArena, minChunkPos, maxChunkPos);
+                }break;
+
+                case BenchWorldQueryPath_OccupiedList :
+                {
+                    AddWorldQueryChunksFromOccupiedList(&query, tempArena, minChunkPos, maxChunkPos);
+                }break;
+
+                case BenchWorldQueryPath_HashProbe :
+                {
+                    query.chunks = PushArray(tempArena, world_->occupiedChunkCount, world_chunk *);
+                    for(int32 chunkZ = minChunkPos.chunkZ;
+                        chunkZ <= maxChunkPos.chunkZ;
+                        ++chunkZ)
+                    {
+                        for(int32 chunkY = minChunkPos.chunkY;
+                            chunkY <= maxChunkPos.chunkY;
+                            ++chunkY)
+                        {
+                            for(int32 chunkX = minChunkPos.chunkX;
+                                chunkX <= maxChunkPos.chunkX;
+                                ++chunkX)
+                            {
+                                world_chunk *chunk = GetWorldChunk(world_, chunkX, chunkY, chunkZ);
+                                if(chunk && chunk->firstBlock)
+                                {
+                                    AddWorldQueryChunk(&query, chunk);
+                                }
+                            }
+                        }
+                    }
+                }break;
+
+                InvalidDefaultCase;
+            }
+            *chunkCount = query.chunkCount;
+            seconds += GetBenchSeconds() - start;
+            EndTemporaryMemory(queryMemory);
+        }
+        bestSeconds = Minimum(bestSeconds, seconds / iterationCount);
+    }
+
+    return bestSeconds;
+}
+
+internal void
+BenchWorldQueryPaths()
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+    game_state *gameState = memory.gameState;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    // NOTE : Same sparse world as BenchWorldQuerySparseAndDense
+    bench_series series = {99};
+    int32 tileRadius = 1000;
+    for(uint32 wallIndex = 0;
+        wallIndex < 2000;
+        ++wallIndex)
+    {
+        int32 tileX = (int32)BenchRandomChoice(&series, 2*tileRadius) - tileRadius;
+        int32 tileY = (int32)BenchRandomChoice(&series, 2*tileRadius) - tileRadius;
+        AddWall(gameState, tileX, tileY, 0);
+    }
+
+    world *world_ = gameState->world;
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+    char *pathNames[BenchWorldQueryPath_Count] = {"bitmap", "occupied list", "hash probe"};
+    real32 boxSides[] = {25.0f, 100.0f, 400.0f, 1000.0f, 3000.0f};
+    for(uint32 boxIndex = 0;
+        boxIndex < ArrayCount(boxSides);
+        ++boxIndex)
+    {
+        rect3 bounds = RectCenterDim(V3(0, 0, 0), V3(boxSides[boxIndex], boxSides[boxIndex], 
+                                                    gameState->typicalFloorHeight));
+        world_position minChunkPos = MapIntoChunkSpace(world_, origin, GetMinCorner(bounds));
+        world_position maxChunkPos = MapIntoChunkSpace(world_, origin, GetMaxCorner(bounds));
+        printf("  %.0fm box(%llu chunks in the bounds, %u occupied in the world) :", boxSides[boxIndex], 
+            (unsigned long long)GetChunkCellCount(minChunkPos, maxChunkPos), world_->occupiedChunkCount);
+        for(uint32 path = 0;
+            path < BenchWorldQueryPath_Count;
+            ++path)
+        {
+            uint32 chunkCount = 0;
+            real64 seconds = BenchWorldQueryPath(world_, &memory.tranArena, minChunkPos, maxChunkPos, 
+                                                (bench_world_query_path)path, &chunkCount);
+            printf(" %s %.1fus(%u chunks)%s", pathNames[path], 1000000.0*seconds, chunkCount,
+                (path + 1 < BenchWorldQueryPath_Count) ? "," : "\n");
+        }
+    }
+
+    EndBenchMemory(&memory);
+}
+
+// NOTE : ZeroSize against memset, from the small structs to the big tables.
+// The start is not aligned, so the head and the tail are always there.
+// Every size clears about the same number of bytes in total, so each line takes about as long.
+internal void
+BenchZeroSize()
+{
+    bench_memory memory;
+    BeginBenchMemory(&memory);
+
+    memory_index maxSize = Megabytes(16);
+    memory_index bufferSize = maxSize + 64;
+    uint8 *buffer = (uint8 *)PushSize(&memory.tranArena, bufferSize);
+    // NOTE : Commit every page before the timing
+    memset(buffer, 1, bufferSize);
+    uint8 *start = buffer + 1;
+
+    memory_index totalSize = Megabytes(256);
+    uint32 batchCount = 5;
+    for(memory_index size = 64;
+        size <= maxSize;
+        size *= 4)
+    {
+        uint32 iterationCount = (uint32)(totalSize / size);
+        real64 zeroSizeSeconds = Real32Max;
+        real64 memsetSeconds = Real32Max;
+        for(uint32 batch = 0;
+            batch < batchCount;
+            ++batch)
+        {
+            real64 begin = GetBenchSeconds();
+            for(uint32 iteration = 0;
+                iteration < iterationCount;
+                ++iteration)
+            {
+                ZeroSize(size, start);
+            }
+            real64 zeroed = GetBenchSeconds();
+            for(uint32 iteration = 0;
+                iteration < iterationCount;
+                ++iteration)
+            {
+                memset(start, 0, size);
+            }
+            real64 cleared = GetBenchSeconds();
+
+            zeroSizeSeconds = Minimum(zeroSizeSeconds, zeroed - begin);
+            memsetSeconds = Minimum(memsetSeconds, cleared - zeroed);
+        }
+
+        real64 bytes = (real64)size*(real64)iterationCount;
+        printf("  %8lluB : ZeroSize %.1fGB/s, memset %.1fGB/s\n", (unsigned long long)size,
+            1e-9*bytes / zeroSizeSeconds, 1e-9*bytes / memsetSeconds);
+    }
+
+    EndBenchMemory(&memory);
+}
+
+//
+// NOTE : Runner
+//
+
+typedef void bench_function();
+struct bench_case
+{
+    char *name;
+    bench_function *function;
+};
+
+#define BENCH_CASE(function) {#function, function}
+global_variable bench_case benchCases[] =
+{
+    BENCH_CASE(BenchCollisionRuleChurn),
+    BENCH_CASE(BenchCanCollide),
+    BENCH_CASE(BenchSimRegion),
+    BENCH_CASE(BenchWorldChunkHash),
+    BENCH_CASE(BenchChunkCrossing),
+    BENCH_CASE(BenchWorldQuery),
+    BENCH_CASE(BenchWorldQuerySparseAndDense),
+    BENCH_CASE(BenchWorldQueryPaths),
+    BENCH_CASE(BenchZeroSize),
+};
+
+int
+main(int argc, char **argv)
+{
+    for(uint32 benchIndex = 0;
+        benchIndex < ArrayCount(benchCases);
+        ++benchIndex)
+    {
+        bench_case *bench = benchCases + benchIndex;
+        // NOTE : Only run the benchmarks that have the argument in their name
+        if(argc > 1 && !strstr(bench->name, argv[1]))
+        {
+            continue;
+        }
+
+        printf("%s\n", bench->name);
+        bench->function();
+    }
+
+    return 0;
+}
@@ -23,17 +23,93 @@ ClearFlags(sim_entity *entity, uint32 flag)
     entity->flags &= ~flag;
 }
 
+// NOTE : Same as above, but for the stored entities
+inline bool32
+IsSet(low_entity *entity, uint32 flag)
+{
+    bool32 result = entity->flags & flag;
+    return result;
+}
+
+inline void
+AddFlags(low_entity *entity, uint32 flag)
+{
+    // Flags are stored in 16 bits!
+    Assert(flag <= 0xFFFF);
+    entity->flags |= (uint16)flag;
+}
+
+inline void
+ClearFlags(low_entity *entity, uint32 flag)
+{
+    entity->flags &= (uint16)~flag;
+}
+
+// NOTE : Hit points are stored as 16 filledAmounts in 4 bits each.
+// hit_point flags are not stored, because nobody is using them yet.
+inline uint64
+PackHitPoints(hit_point *hitPoints)
+{
+    // 16 hit points are 2 bytes each, so two 128 bit registers
+    __m128i hitPoints0 = _mm_loadu_si128((__m128i *)hitPoints + 0);
+    __m128i hitPoints1 = _mm_loadu_si128((__m128i *)hitPoints + 1);
+
+    // filledAmount is the high byte of each hit point
+    __m128i amounts = _mm_packus_epi16(_mm_srli_epi16(hitPoints0, 8), 
+                                        _mm_srli_epi16(hitPoints1, 8));
+    Assert(_mm_movemask_epi8(_mm_cmpgt_epi8(amounts, _mm_set1_epi8(0x0F))) == 0);
+
+    // Put the odd amount on top of the even amount, so that each 16 bit has one byte
+    __m128i pairs = _mm_or_si128(_mm_and_si128(amounts, _mm_set1_epi16(0x00FF)),
+                                _mm_slli_epi16(_mm_srli_epi16(amounts, 8), 4));
+    __m128i packed = _mm_packus_epi16(pairs, pairs);
+
+    uint64 result;
+    _mm_storel_epi64((__m128i *)&result, packed);
+
+    return result;
+}
+
+inline void
+UnpackHitPoints(uint64 packed, hit_point *hitPoints)
+{
+    __m128i packed_16x = _mm_loadl_epi64((__m128i *)&packed);
+    __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+    __m128i evenAmounts = _mm_and_si128(packed_16x, nibbleMask);
+    __m128i oddAmounts = _mm_and_si128(_mm_srli_epi16(packed_16x, 4), nibbleMask);
+    __m128i amounts = _mm_unpacklo_epi8(evenAmounts, oddAmounts);
+
+    // flags go to the low byte, and they are always 0
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128((__m128i *)hitPoints + 0, _mm_unpacklo_epi8(zero, amounts));
+    _mm_storeu_si128((__m128i *)hitPoints + 1, _mm_unpackhi_epi8(zero, amounts));
+}
+
+inline void
+WakeEntity(sim_entity *entity)
+{
+    if(IsSet(entity, EntityFlag_Sleeping))
+    {
+        ClearFlags(entity, EntityFlag_Sleeping);
+        entity->dirty = true;
+    }
+}
+
 inline void
 MakeEntityNonSpatial(sim_entity *entity)
 {
     AddFlags(entity, EntityFlag_Nonspatial);
     entity->pos = InvalidPos;
+    entity->dirty = true;
 }
 
 inline void
 MakeEntitySpatial(sim_entity *entity, v3 pos, v3 dPos)
 {
     ClearFlags(entity, EntityFlag_Nonspatial);
+    entity->dirty = true;
+    WakeEntity(entity);
     entity->pos = pos;
 
     entity->dPos = dPos;
@@ -96,6 +96,13 @@ Sin(real32 Angle)
     return(Result);
 }
 
+inline real32
+Exp(real32 value)
+{
+    real32 result = expf(value);
+    return(result);
+}
+
 inline real32
 Cos(real32 Angle)
 {
@@ -125,6 +132,12 @@ FindLeastSignificantSetBit(uint32 value)
 #if COMPILER_MSVC
     // This is much more faster because it's intrinsic
     result.found = _BitScanForward((unsigned long *)&result.index, value);
+#elif COMPILER_LLVM
+    if(value)
+    {
+        result.index = __builtin_ctz(value);
+        result.found = true;
+    }
 #else
     for(uint32 test = 0;
         test < 32;
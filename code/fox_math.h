@@ -868,5 +868,56 @@ Normalize(v3 vector)
     return result;
 }
 
+//
+// NOTE : Integer hashing
+//
+
+// Finalizer of the murmur3 hash. Every bit of the input affects every bit of the output,
+// so we can just mask the low bits to get the slot of a power-of-two table.
+inline uint32
+HashUInt32(uint32 value)
+{
+    uint32 result = value;
+
+    result ^= result >> 16;
+    result *= 0x85ebca6b;
+    result ^= result >> 13;
+    result *= 0xc2b2ae35;
+    result ^= result >> 16;
+
+    return result;
+}
+
+// Finalizer of the splitmix64. Used when the key is a pair of 32bit values.
+inline uint32
+HashUInt64(uint64 value)
+{
+    uint64 result = value;
+
+    result ^= result >> 30;
+    result *= 0xbf58476d1ce4e5b9ULL;
+    result ^= result >> 27;
+    result *= 0x94d049bb133111ebULL;
+    result ^= result >> 31;
+
+    return (uint32)result;
+}
+
+inline uint32
+HashUInt32Pair(uint32 a, uint32 b)
+{
+    uint32 result = HashUInt64(((uint64)a << 32) | (uint64)b);
+    return result;
+}
+
+// NOTE : For the grid coordinates. Neighbouring cells differ only in a few low bits,
+// so z is spread out with the golden ratio before it goes in to the key with x and y.
+inline uint32
+HashUInt32Triple(uint32 a, uint32 b, uint32 c)
+{
+    uint32 result = HashUInt64((((uint64)a << 32) | (uint64)b) ^ ((uint64)c * 0x9e3779b97f4a7c15ULL));
+    return result;
+}
+
 #define FOX_MATH_H
 #endif
\ No newline at end of file
@@ -30,6 +30,9 @@ extern "C" {
 #if COMPILER_MSVC
     #include "intrin.h"
     #pragma intrinsic(_BitScanForward)
+#else
+    // NOTE : SSE and __rdtsc for gcc and clang
+    #include <x86intrin.h>
 #endif
 
 #include <stdint.h>
@@ -94,10 +97,7 @@ union v3
 
 union v4
 {
-    struct
-    {
-        real32 x, y, z, w;
-    };
+    // NOTE : x, y, z, w are in the xyz struct, gcc doesn't allow the same member twice
     struct
     {
         union
@@ -162,11 +162,87 @@ union v4
 #define Gigabytes(value) (Megabytes(value) * 1024LL)
 #define Terabytes(value) (Gigabytes(value) * 1024LL)
 
-/*Thread handle
-For multi thread??*/
+// NOTE : If the platform only reserved the storage, the game commits it as the arenas grow.
+// Commit rounds out to the whole pages, and decommit rounds in,
+// so that it never throws away the page that still has something in it.
+// Decommitted memory is 0 again when it gets committed.
+#define PLATFORM_COMMIT_MEMORY(name) bool32 name(void *base, memory_index size)
+typedef PLATFORM_COMMIT_MEMORY(platform_commit_memory);
+
+#define PLATFORM_DECOMMIT_MEMORY(name) void name(void *base, memory_index size)
+typedef PLATFORM_DECOMMIT_MEMORY(platform_decommit_memory);
+
+// NOTE : The arena profile looks at every push, so it has its own switch
+// instead of being on with the rest of the debug code. It needs FOX_DEBUG for debugGlobalMemory.
+#if FOX_ARENA_PROFILE && !FOX_DEBUG
+    #error FOX_ARENA_PROFILE needs FOX_DEBUG
+#endif
+
+#if FOX_ARENA_PROFILE
+// NOTE : The names are copied, because the strings in the game code
+// go away when the game code gets reloaded.
+#define DEBUG_ARENA_NAME_LENGTH 16
+#define DEBUG_ARENA_SITE_NAME_LENGTH 48
+#endif
+
+// NOTE : These live here so that the platform can make the arenas too.
+// Everything that works with them is in fox.h.
+struct memory_arena
+{
+    memory_index size;
+    uint8 *base;
+    memory_index used;
+
+    // NOTE : How much from the base is committed. 
+    // If there is no commitMemory, the whole arena was committed already.
+    memory_index committed;
+    platform_commit_memory *commitMemory;
+    // 0 if the arena never gives the memory back
+    platform_decommit_memory *decommitMemory;
+
+    // NOTE : Everything after this much from the base was never handed out,
+    // so it's still 0 and the zeroed pushes don't have to clear it.
+    memory_index zeroFrom;
+
+    int32 tempCount;
+
+#if FOX_ARENA_PROFILE
+    char name[DEBUG_ARENA_NAME_LENGTH];
+    // NOTE : Most that was ever used at once
+    memory_index maxUsed;
+    // Most that was used since the innermost temporary memory began
+    memory_index tempMaxUsed;
+
+    uint32 framePushCount;
+    memory_index frameByteCount;
+    // NOTE : What the last frame pushed, for the summary
+    uint32 lastFramePushCount;
+    memory_index lastFrameByteCount;
+#endif
+};
+
+struct temporary_memory
+{
+    memory_index used;
+    memory_arena *arena;
+
+#if FOX_ARENA_PROFILE
+    // NOTE : Where this began, see ARENA_SITE in fox.h
+    char *siteFile;
+    int32 siteLine;
+    // NOTE : tempMaxUsed of the arena when this began, because the temporary memory can be nested
+    memory_index outerTempMaxUsed;
+#endif
+};
+
+// NOTE : Every thread has its own, and only that thread touches it.
 typedef struct thread_context
 {
-    int placeHolder;
+    // NOTE : For the memory that only lives while the thread is doing something,
+    // so that the jobs can allocate without locking anything.
+    // Everything in here should be inside the temporary memory, 
+    // so this is empty whenever the thread is done with the job or the frame.
+    memory_arena scratchArena;
 } thread_context;
 
 #define BITMAP_BYTES_PER_PIXEL 4
@@ -199,6 +275,12 @@ enum
     /* 3 */ DebugCycleCounter_DrawSomethingHopefullyFast,
     /* 4 */ DebugCycleCounter_ProcessPixel,
     /* 5 */ DebugCycleCounter_FillPixel,
+    /* 6 */ DebugCycleCounter_MoveEntity,
+    /* 7 */ DebugCycleCounter_BeginSim,
+    /* 8 */ DebugCycleCounter_EndSim,
+    /* 9 */ DebugCycleCounter_UpdateWorldStreaming,
+    /* 10 */ DebugCycleCounter_UpdateWorldGen,
+    /* 11 */ DebugCycleCounter_UpdateLowFrequencyEntities,
     // This DebugCycleCounter_Count indicates how many elements should be in the counter array
     // because this value is always all the Cycle Counter we need + 1!!
     DebugCycleCounter_Count,
@@ -213,12 +295,73 @@ typedef struct debug_cycle_counter
     uint32 hitCount;
 } debug_cycle_counter;
 
+#if FOX_ARENA_PROFILE
+// NOTE : Every place in the code that pushes to the arenas, or begins the temporary memory,
+// gets one of these the first time it does that.
+typedef struct debug_arena_site
+{
+    // NOTE : Hash of the "file(line)" of the site, 0 if nobody took this slot yet
+    uint64 volatile key;
+    char name[DEBUG_ARENA_SITE_NAME_LENGTH];
+    // NOTE : __FILE__ that found this site last time, only to be compared in the site cache.
+    // It is not the same pointer after the game code gets reloaded.
+    char * volatile file;
+    int32 line;
+    // NOTE : The arena that the site used first. The same site can push to the other arenas,
+    // if it's in a function that takes the arena.
+    char arenaName[DEBUG_ARENA_NAME_LENGTH];
+    // For the temporary memory, the counts are how many of them ended
+    // and the bytes are the most that each of them had at once.
+    bool32 isTemporary;
+
+    uint64 volatile pushCount;
+    uint64 volatile byteCount;
+
+    // NOTE : Since the last frame summary
+    uint64 volatile framePushCount;
+    uint64 volatile frameByteCount;
+    uint64 lastFramePushCount;
+    uint64 lastFrameByteCount;
+
+    // Most that this site pushed in one frame
+    uint64 maxFrameByteCount;
+    // NOTE : Only for the temporary memory, most that one of them had at once
+    uint64 volatile maxTempByteCount;
+} debug_arena_site;
+
+// NOTE : Must be a power of 2
+#define DEBUG_MAX_ARENA_SITE_COUNT 256
+#define DEBUG_ARENA_SITE_CACHE_COUNT 1024
+#define DEBUG_MAX_ARENA_COUNT 32
+
+typedef struct debug_arena_profile
+{
+    // NOTE : How many frames have ended since the game started
+    uint32 frameCount;
+
+    // NOTE : The arenas that show up in the summary
+    uint32 arenaCount;
+    memory_arena *arenas[DEBUG_MAX_ARENA_COUNT];
+
+    debug_arena_site sites[DEBUG_MAX_ARENA_SITE_COUNT];
+    // NOTE : The sites keyed by the __FILE__ pointer and the line, 
+    // so the push doesn't have to hash the file name every time.
+    debug_arena_site * volatile siteCache[DEBUG_ARENA_SITE_CACHE_COUNT];
+    // NOTE : The pushes that didn't get the site because the table was full
+    uint64 volatile droppedPushCount;
+} debug_arena_profile;
+
+// NOTE : How many frames the platform waits to print the arena summary by itself
+#define DEBUG_ARENA_PROFILE_SUMMARY_FRAMES 300
+#endif
+
 struct game_memory;
 
 // Doing this so that we can use counters inside any function
 // without passing the gameMemory all the time!
 extern game_memory *debugGlobalMemory;
-#if _MSC_VER
+// NOTE : __rdtsc comes from intrin.h on msvc, and x86intrin.h on the others
+#if COMPILER_MSVC || COMPILER_LLVM
     
     // ID is just for in case we want multiple cycle counter and the name can be differ from each one
     // This can be anything - number, function name, ....
@@ -229,11 +372,98 @@ extern game_memory *debugGlobalMemory;
 #else
     #define BEGIN_TIMED_BLOCK(ID)
     #define END_TIMED_BLOCK(ID)
-    #define END_TIMED_BLOCK_COUNTED(ID)
+    #define END_TIMED_BLOCK_COUNTED(ID, counter)
 #endif
 
 #endif
 
+// NOTE : The file that the world pages its chunks out to.
+// This only lives while the game is running, so it is not a save file!
+typedef struct platform_file_handle
+{
+    bool32 noErrors;
+    void *platform;
+} platform_file_handle;
+
+#define PLATFORM_OPEN_PAGE_FILE(name) platform_file_handle name(thread_context *thread, char *fileName)
+typedef PLATFORM_OPEN_PAGE_FILE(platform_open_page_file);
+
+// NOTE : Reads and writes at any offset. Writing past the end grows the file.
+#define PLATFORM_READ_PAGE_FILE(name) bool32 name(thread_context *thread, platform_file_handle *handle, uint64 offset, uint32 size, void *dest)
+typedef PLATFORM_READ_PAGE_FILE(platform_read_page_file);
+
+#define PLATFORM_WRITE_PAGE_FILE(name) bool32 name(thread_context *thread, platform_file_handle *handle, uint64 offset, uint32 size, void *source)
+typedef PLATFORM_WRITE_PAGE_FILE(platform_write_page_file);
+
+// NOTE : The platform has worker threads that take the entries of this queue
+// in the order they were added, so the callback can run on any of those threads.
+struct platform_work_queue;
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(thread_context *thread, platform_work_queue *queue, void *data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(platform_work_queue_callback);
+
+// NOTE : Only one thread should add the entries to the same queue!
+typedef void platform_add_entry(platform_work_queue *queue, platform_work_queue_callback *callback, void *data);
+// The thread that calls this also does the work, until every entry in the queue is done
+typedef void platform_complete_all_work(thread_context *thread, platform_work_queue *queue);
+
+// NOTE : For the work that is checked without waiting for the whole queue.
+// x64 doesn't reorder the stores with the other stores, or the loads with the other loads,
+// so these only have to stop the compiler.
+#if COMPILER_MSVC
+    #define CompletePreviousWritesBeforeFutureWrites _WriteBarrier()
+    #define CompletePreviousReadsBeforeFutureReads _ReadBarrier()
+#else
+    #define CompletePreviousWritesBeforeFutureWrites __asm__ __volatile__("" ::: "memory")
+    #define CompletePreviousReadsBeforeFutureReads __asm__ __volatile__("" ::: "memory")
+#endif
+
+// NOTE : For the values that more than one thread writes to.
+// These all return what was there before.
+#if COMPILER_MSVC
+inline uint64
+AtomicAddU64(uint64 volatile *value, uint64 addend)
+{
+    uint64 result = _InterlockedExchangeAdd64((__int64 volatile *)value, addend);
+    return result;
+}
+
+inline uint64
+AtomicExchangeU64(uint64 volatile *value, uint64 newValue)
+{
+    uint64 result = _InterlockedExchange64((__int64 volatile *)value, newValue);
+    return result;
+}
+
+inline uint64
+AtomicCompareExchangeU64(uint64 volatile *value, uint64 newValue, uint64 expected)
+{
+    uint64 result = _InterlockedCompareExchange64((__int64 volatile *)value, newValue, expected);
+    return result;
+}
+#else
+inline uint64
+AtomicAddU64(uint64 volatile *value, uint64 addend)
+{
+    uint64 result = __sync_fetch_and_add(value, addend);
+    return result;
+}
+
+inline uint64
+AtomicExchangeU64(uint64 volatile *value, uint64 newValue)
+{
+    // NOTE : This is only an acquire barrier, unlike the one on msvc
+    uint64 result = __sync_lock_test_and_set(value, newValue);
+    return result;
+}
+
+inline uint64
+AtomicCompareExchangeU64(uint64 volatile *value, uint64 newValue, uint64 expected)
+{
+    uint64 result = __sync_val_compare_and_swap(value, expected, newValue);
+    return result;
+}
+#endif
+
 typedef struct game_button_state
 {
     //No matter what crazy stuff this button has passed
@@ -308,9 +538,24 @@ typedef struct game_memory
     debug_platform_write_entire_file *debugPlatformWriteEntireFile;
     debug_platform_free_file_memory *debugPlatformFreeFileMemory;
 
+    platform_open_page_file *platformOpenPageFile;
+    platform_read_page_file *platformReadPageFile;
+    platform_write_page_file *platformWritePageFile;
+
+    platform_work_queue *workQueue;
+    platform_add_entry *platformAddEntry;
+    platform_complete_all_work *platformCompleteAllWork;
+
+    // NOTE : 0 if the whole storage was committed up front
+    platform_commit_memory *platformCommitMemory;
+    platform_decommit_memory *platformDecommitMemory;
+
 #if FOX_DEBUG
     debug_cycle_counter counters[DebugCycleCounter_Count];
 #endif
+#if FOX_ARENA_PROFILE
+    debug_arena_profile arenaProfile;
+#endif
 } game_memory;
 
 typedef struct game_offscreen_buffer
@@ -33,383 +33,1604 @@ GetSimSpacePos(sim_region *simRegion, low_entity *stored)
     // TODO : Do we want to set this to signaling NAN in debug mode
     // to make sure nobody eer uses the position of a nonspatial entity?
     v3 diff = InvalidPos;
-    if(!IsSet(&stored->sim, EntityFlag_Nonspatial))
+    if(!IsSet(stored, EntityFlag_Nonspatial))
     {
         diff = SubstractTwoWMP(simRegion->world, &stored->pos, &simRegion->origin);
     }
     return diff;
 }
 
-internal sim_entity_hash *
-GetHashFromStorageIndex(sim_region *simRegion, uint32 storageIndex)
+#define INITIAL_SIM_ENTITY_HASH_COUNT 256
+
+internal void
+AllocateSimEntityHash(sim_entity_hash_table *table, uint32 maxCount)
+{
+    // NOTE : The old entries are gone after this, 
+    // so whoever grows the table should put the entries back.
+    table->arena.used = 0;
+    table->generation = 1;
+    table->count = 0;
+    table->maxCount = maxCount;
+    table->hashShift = 32;
+    for(uint32 count = maxCount;
+        count > 1;
+        count >>= 1)
+    {
+        --table->hashShift;
+    }
+    table->entries = PushArrayZeroed(&table->arena, table->maxCount, sim_entity_hash);
+}
+
+// NOTE : How many slots the table needs to keep count entries under 3/4 full
+inline uint32
+GetSimEntityHashMaxCount(uint32 maxCount, uint32 count)
+{
+    while(count*4 > maxCount*3)
+    {
+        maxCount *= 2;
+    }
+
+    return maxCount;
+}
+
+// NOTE : The arena is reserved for the biggest table that we can ever need(every low entity in one region),
+// but only what the table actually uses is committed.
+internal void
+InitializeSimEntityHash(sim_entity_hash_table *table, memory_arena *arena)
+{
+    uint32 mostMaxCount = GetSimEntityHashMaxCount(INITIAL_SIM_ENTITY_HASH_COUNT, MAX_LOW_ENTITY_COUNT);
+    SubArena(&table->arena, arena, mostMaxCount*sizeof(sim_entity_hash));
+    AllocateSimEntityHash(table, INITIAL_SIM_ENTITY_HASH_COUNT);
+}
+
+// Every entry that was stored before this is now invalid
+internal void
+BeginSimEntityHash(sim_entity_hash_table *table)
+{
+    ++table->generation;
+    if(table->generation == 0)
+    {
+        // NOTE : Generation wrapped, so the old entries might look valid again
+        ZeroSize(table->maxCount*sizeof(sim_entity_hash), table->entries);
+        table->generation = 1;
+    }
+    table->count = 0;
+}
+
+// NOTE : Must be called before anything is added in this generation,
+// because growing or shrinking here does not put the entries back.
+internal void
+ReserveSimEntityHash(sim_entity_hash_table *table, uint32 count)
+{
+    Assert(table->count == 0);
+
+    uint32 maxCount = GetSimEntityHashMaxCount(table->maxCount, count);
+
+    // NOTE : If the region got much smaller than the table(i.e. we left a dense area), 
+    // shrink it so that the probes stay in the cache. This stops somewhere between 1/8 and 1/4 full,
+    // so that the table does not grow right back when a few more entities come in.
+    while(maxCount > INITIAL_SIM_ENTITY_HASH_COUNT && count*8 <= maxCount)
+    {
+        maxCount /= 2;
+    }
+
+    if(maxCount != table->maxCount)
+    {
+        AllocateSimEntityHash(table, maxCount);
+    }
+}
+
+inline uint32
+GetSimEntityHashHomeSlot(sim_entity_hash_table *table, uint32 storageIndex)
+{
+    uint32 result = (storageIndex*0x9E3779B9) >> table->hashShift;
+    return result;
+}
+
+// How far is the entry from its home slot
+inline uint32
+GetSimEntityHashDistance(sim_entity_hash_table *table, uint32 storageIndex, uint32 slot)
+{
+    uint32 result = (slot - GetSimEntityHashHomeSlot(table, storageIndex)) & (table->maxCount - 1);
+    return result;
+}
+
+inline void
+StoreEntityReference(game_state *gameState, entity_reference *ref)
+{
+    sim_entity *entity = ref->ptr;
+    ref->handle = {};
+    // NOTE : The entity might be deleted already in this EndSim, 
+    // and its slot has the new generation, so don't take it
+    if(entity && !IsSet(entity, EntityFlag_Deleted))
+    {
+        ref->handle = GetLowEntityHandle(gameState, entity->storageIndex);
+    }
+}
+
+// Returns 0 if the entity is not in the sim region
+inline sim_entity *
+GetEntityByStorageIndex(sim_region *simRegion, uint32 storageIndex)
+{
+    Assert(storageIndex);
+
+    sim_entity *result = 0;
+
+    sim_entity_hash_table *table = simRegion->hash;
+    uint32 hashMask = table->maxCount - 1;
+    uint32 slot = GetSimEntityHashHomeSlot(table, storageIndex);
+    for(uint32 distance = 0;
+        ;
+        ++distance)
+    {
+        sim_entity_hash *entry = table->entries + slot;
+        if(entry->generation != table->generation)
+        {
+            // NOTE : Empty slot
+            break;
+        }
+        else if(entry->index == storageIndex)
+        {
+            result = entry->ptr;
+            break;
+        }
+        else if(GetSimEntityHashDistance(table, entry->index, slot) < distance)
+        {
+            // NOTE : This entry is closer to its home than we are to ours,
+            // so if we were in the table, we would have taken this slot.
+            break;
+        }
+
+        slot = (slot + 1) & hashMask;
+    }
+
+    return result;
+}
+
+// NOTE : Robin Hood - whoever is further from its home gets the slot,
+// so that every probe stays short even when the table is quite full.
+// The slot should be the one that is distance away from the home of toInsert.
+internal void
+PlaceSimEntityHash(sim_entity_hash_table *table, sim_entity_hash toInsert, uint32 slot, uint32 distance)
+{
+    uint32 hashMask = table->maxCount - 1;
+    for(;;)
+    {
+        sim_entity_hash *entry = table->entries + slot;
+        if(entry->generation != table->generation)
+        {
+            *entry = toInsert;
+            ++table->count;
+            break;
+        }
+
+        Assert(entry->index != toInsert.index);
+        uint32 entryDistance = GetSimEntityHashDistance(table, entry->index, slot);
+        if(entryDistance < distance)
+        {
+            sim_entity_hash temp = *entry;
+            *entry = toInsert;
+            toInsert = temp;
+            distance = entryDistance;
+        }
+
+        slot = (slot + 1) & hashMask;
+        ++distance;
+    }
+}
+
+internal void
+InsertSimEntityHash(sim_entity_hash_table *table, uint32 storageIndex, sim_entity *entity)
+{
+    sim_entity_hash toInsert;
+    toInsert.ptr = entity;
+    toInsert.index = storageIndex;
+    toInsert.generation = table->generation;
+
+    PlaceSimEntityHash(table, toInsert, GetSimEntityHashHomeSlot(table, storageIndex), 0);
+}
+
+// NOTE : Looks up and inserts with the same probe, because almost every entity 
+// that the gather adds is not in the table yet.
+// Returns the entity that was already mapped to this storage index, or the new entity if there was none.
+internal sim_entity *
+FindOrInsertSimEntityHash(sim_entity_hash_table *table, uint32 storageIndex, sim_entity *entity)
+{
+    sim_entity *result = entity;
+
+    uint32 hashMask = table->maxCount - 1;
+    uint32 slot = GetSimEntityHashHomeSlot(table, storageIndex);
+    for(uint32 distance = 0;
+        ;
+        ++distance)
+    {
+        sim_entity_hash *entry = table->entries + slot;
+        if(entry->generation == table->generation && entry->index == storageIndex)
+        {
+            result = entry->ptr;
+            break;
+        }
+        else if(entry->generation != table->generation ||
+                GetSimEntityHashDistance(table, entry->index, slot) < distance)
+        {
+            // NOTE : This is where GetEntityByStorageIndex would stop, so it's not in the table
+            sim_entity_hash toInsert;
+            toInsert.ptr = entity;
+            toInsert.index = storageIndex;
+            toInsert.generation = table->generation;
+            PlaceSimEntityHash(table, toInsert, slot, distance);
+            break;
+        }
+
+        slot = (slot + 1) & hashMask;
+    }
+
+    return result;
+}
+
+// NOTE : Every entity that was mapped is in the entities array,
+// so we can just put them in the new table again.
+internal void
+RebuildSimEntityHash(sim_region *simRegion, uint32 maxCount)
+{
+    sim_entity_hash_table *table = simRegion->hash;
+    AllocateSimEntityHash(table, maxCount);
+    for(uint32 entityIndex = 0;
+        entityIndex < simRegion->entityCount;
+        ++entityIndex)
+    {
+        sim_entity *test = simRegion->entities + entityIndex;
+        InsertSimEntityHash(table, test->storageIndex, test);
+    }
+}
+
+// NOTE : Grows the hash if one more entity would make it too full.
+// Must be called before the next entity goes in the entities array.
+internal void
+MakeRoomInSimEntityHash(sim_region *simRegion)
+{
+    sim_entity_hash_table *table = simRegion->hash;
+
+    // Keep the load under 3/4 so that the probes stay short
+    if((table->count + 1)*4 > table->maxCount*3)
+    {
+        RebuildSimEntityHash(simRegion, 2*table->maxCount);
+    }
+}
+
+internal sim_entity *
+AddEntityToSimRegion(game_state *gameState, sim_region *region, uint32 storageIndex, low_entity *source, v3 *simPos);
+
+// Check whether the added entity has entity reference 
+// that also needed to be loaded.
+// NOTE : This can move the entities array(see GrowSimEntities),
+// so the caller should not hold on to any sim entity pointer across this call.
+inline sim_entity *
+LoadEntityReference(game_state *gameState, sim_region *simRegion, low_entity_handle handle)
+{
+    // If the handle was null or the entity was deleted, there is no entity referenced
+    sim_entity *entity = 0;
+    low_entity *low = GetLowEntity(gameState, handle);
+    if(low)
+    {
+        uint32 storageIndex = handle.index;
+        entity = GetEntityByStorageIndex(simRegion, storageIndex);
+        if(entity == 0)
+        {
+            // The reference was not in there yet
+            v3 simSpacePos = GetSimSpacePos(simRegion, low);            
+            entity = AddEntityToSimRegion(gameState, simRegion, storageIndex, low, &simSpacePos);
+        }
+    }
+
+    return entity;
+}
+
+// NOTE : Everything except the position, which should be done by the sim region.
+// Every other field of the sim entity should be set here, because 
+// clearing the whole sim entity first costs more than the decompression itself!
+internal void
+DecompressEntity(low_entity *source, sim_entity *dest)
+{
+    dest->sword.ptr = 0;
+    dest->tBob = 0.0f;
+    dest->walkableDim = V2(0, 0);
+    dest->walkableHeight = 0.0f;
+
+    dest->dPos = source->dPos;
+    dest->ddP = V3(0, 0, 0);
+    dest->type = (entity_type)source->type;
+    dest->flags = source->flags;
+    dest->collision = source->collision;
+    dest->distanceLimit = source->distanceLimit;
+    dest->facingDirection = source->facingDirection;
+
+    dest->hitPointMax = source->hitPointMax;
+    UnpackHitPoints(source->hitPoints, dest->hitPoints);
+
+    switch(dest->type)
+    {
+        case EntityType_Hero:
+        {
+            dest->sword.handle = source->payload.hero.sword;
+        }break;
+
+        case EntityType_Familiar:
+        {
+            dest->tBob = source->payload.familiar.tBob;
+        }break;
+
+        case EntityType_Stairwell:
+        {
+            dest->walkableDim = source->payload.stair.walkableDim;
+            dest->walkableHeight = source->payload.stair.walkableHeight;
+        }break;
+    }
+}
+
+// NOTE : Everything except the position, which should be done by ChangeEntityLocation
+internal void
+CompressEntity(game_state *gameState, sim_entity *source, low_entity *dest)
+{
+    Assert(source->type <= 0xFF);
+    Assert(source->flags <= 0xFFFF);
+    Assert(source->facingDirection <= 0xFF);
+    Assert(source->hitPointMax <= ArrayCount(source->hitPoints));
+
+    dest->dPos = source->dPos;
+    dest->type = (uint8)source->type;
+    dest->flags = (uint16)source->flags;
+    dest->collision = source->collision;
+    dest->distanceLimit = source->distanceLimit;
+    dest->facingDirection = (uint8)source->facingDirection;
+
+    dest->hitPointMax = (uint8)source->hitPointMax;
+    dest->hitPoints = PackHitPoints(source->hitPoints);
+
+    switch(source->type)
+    {
+        case EntityType_Hero:
+        {
+            // Store the sword to the low space
+            entity_reference sword = source->sword;
+            StoreEntityReference(gameState, &sword);
+            dest->payload.hero.sword = sword.handle;
+        }break;
+
+        case EntityType_Familiar:
+        {
+            dest->payload.familiar.tBob = source->tBob;
+        }break;
+
+        case EntityType_Stairwell:
+        {
+            dest->payload.stair.walkableDim = source->walkableDim;
+            dest->payload.stair.walkableHeight = source->walkableHeight;
+        }break;
+    }
+}
+
+// NOTE : While we are gathering, the entities array is usually at the top of the sim arena,
+// so we can grow it in place and every pointer to the entities stays valid.
+// If something was pushed after it, the array moves to a bigger one,
+// and everything that points into the old one(the hash, the references and the type lists) is fixed up.
+internal void
+GrowSimEntities(sim_region *simRegion)
+{
+    memory_arena *arena = simRegion->arena;
+    uint32 growCount = Maximum(simRegion->maxEntityCount / 2, 16);
+    if((uint8 *)(simRegion->entities + simRegion->maxEntityCount) == arena->base + arena->used)
+    {
+        PushArray(arena, growCount, sim_entity);
+        simRegion->maxEntityCount += growCount;
+    }
+    else
+    {
+        sim_entity *oldEntities = simRegion->entities;
+        uint32 newMaxCount = simRegion->maxEntityCount + growCount;
+        sim_entity *newEntities = PushArray(arena, newMaxCount, sim_entity);
+        simRegion->entities = newEntities;
+        simRegion->maxEntityCount = newMaxCount;
+
+        for(uint32 entityIndex = 0;
+            entityIndex < simRegion->entityCount;
+            ++entityIndex)
+        {
+            sim_entity *entity = newEntities + entityIndex;
+            *entity = oldEntities[entityIndex];
+            if(entity->sword.ptr)
+            {
+                entity->sword.ptr = newEntities + (entity->sword.ptr - oldEntities);
+            }
+        }
+
+        for(uint32 type = 0;
+            type < EntityType_Count;
+            ++type)
+        {
+            sim_entity_list *list = simRegion->typeLists + type;
+            for(uint32 listIndex = 0;
+                listIndex < list->count;
+                ++listIndex)
+            {
+                list->entities[listIndex] = newEntities + (list->entities[listIndex] - oldEntities);
+            }
+        }
+
+        // NOTE : Same size, only the pointers have changed
+        RebuildSimEntityHash(simRegion, simRegion->hash->maxCount);
+    }
+}
+
+internal sim_entity *
+AddEntityToSimRegionRaw(game_state *gameState, sim_region *simRegion, uint32 storageIndex, low_entity *source)
+{
+    Assert(storageIndex);
+
+    sim_entity *entity = 0;
+
+    if(simRegion->entityCount == simRegion->maxEntityCount)
+    {
+        // NOTE : Only the entities that were referenced from outside of the region
+        // are not counted in BeginSim, so this should not happen that often
+        GrowSimEntities(simRegion);
+    }
+    MakeRoomInSimEntityHash(simRegion);
+
+    if(simRegion->entityCount < simRegion->maxEntityCount)
+    {
+        sim_entity *newEntity = simRegion->entities + simRegion->entityCount;
+        if(FindOrInsertSimEntityHash(simRegion->hash, storageIndex, newEntity) == newEntity)
+        {
+            entity = newEntity;
+            ++simRegion->entityCount;
+
+            // NOTE : Storage index should be set before anything else is added,
+            // because the hash rebuilds itself from the entities array when it grows
+            entity->storageIndex = storageIndex;
+
+            if(source)
+            {
+                DecompressEntity(source, entity);
+                entity->storageIndex = storageIndex;
+
+                // Load Entity Reference that this sim entity has, which is sword for now.
+                // This has to be here because if we did not do the copy, 
+                // the sim does not have reference to the sowrd - it's empty!
+                uint32 entityIndex = (uint32)(entity - simRegion->entities);
+                sim_entity *sword = LoadEntityReference(gameState, simRegion, entity->sword.handle);
+                entity = simRegion->entities + entityIndex;
+                entity->sword.ptr = sword;
+            }
+
+            entity->storageIndex = storageIndex;
+            entity->updatable = false;
+            // NOTE : If there was no low entity to begin with, EndSim has to store everything
+            entity->dirty = (source == 0);
+            entity->dt = 0.0f;
+        }
+    }
+    else
+    {
+        InvalidCodePath;
+    }
+
+    return entity;
+}
+
+// NOTE : Heroes and anything on the screen run every step, the ones off the screen every other step,
+// and the ones near the edge of the updatable bounds every SIM_MAX_CLOCK_INTERVAL steps.
+// The phase comes from the storage index, so that the entities of the same rate are spread over the steps.
+internal real32
+GetEntityClockDt(sim_region *simRegion, sim_entity *entity, low_entity *source)
+{
+    uint32 interval = 1;
+    // NOTE : Nothing happens to the entities that can't move, so they don't need the clock
+    if(IsSet(entity, EntityFlag_Movable) && entity->type != EntityType_Hero)
+    {
+        rect3 innerBounds = AddRadiusToRect(simRegion->updatableBounds, 
+                                            V3(-SIM_CLOCK_EDGE_BAND, -SIM_CLOCK_EDGE_BAND, 0.0f));
+        if(!IsInRectangle(innerBounds, entity->pos))
+        {
+            interval = SIM_MAX_CLOCK_INTERVAL;
+        }
+        else if(!IsInRectangle(simRegion->fullRateBounds, entity->pos))
+        {
+            interval = 2;
+        }
+    }
+
+    real32 result = 0.0f;
+    uint32 phase = entity->storageIndex & (interval - 1);
+    if(((simRegion->stepIndex + phase) & (interval - 1)) == 0)
+    {
+        // NOTE : lastSimStep is only kept for the awake entities, 
+        // so the ones that just woke up can look like they have skipped a lot.
+        uint32 stepCount = simRegion->stepIndex - source->lastSimStep;
+        stepCount = Maximum(Minimum(stepCount, interval), 1);
+        result = stepCount*simRegion->dt;
+    }
+
+    return result;
+}
+
+// NOTE : How far back from pos the renderer draws this entity, stepAlpha into the step after stepIndex.
+// The last move is spread over as many steps as it took, so the entities that don't run every step
+// move as smoothly as the others, only a few steps later.
+inline v3
+GetEntityRenderOffset(low_entity *low, uint32 stepIndex, real32 stepAlpha)
+{
+    v3 result = V3(0, 0, 0);
+    if(low->moveStepCount)
+    {
+        real32 t = ((real32)(stepIndex - low->moveStep) + stepAlpha) / (real32)low->moveStepCount;
+        result = (1.0f - Clamp01(t))*low->prevPos;
+    }
+
+    return result;
+}
+
+// We get the stored entity and make it to simulation entity
+internal sim_entity *
+AddEntityToSimRegion(game_state *gameState, sim_region *simRegion, uint32 storageIndex, low_entity *source, v3 *simPos)
+{
+    sim_entity *dest = AddEntityToSimRegionRaw(gameState, simRegion, storageIndex, source);
+    if(dest)
+    {
+        // TODO : Convert the stored entity to a simulation entity
+        if(simPos)
+        {
+           // Assert(IsCanonical(simRegion->world, *simPos));
+            dest->pos = *simPos;
+            dest->updatable = EntityOverlapsRectangle(dest->pos, dest->collision->totalVolume, simRegion->updatableBounds);
+            if(dest->updatable)
+            {
+                dest->dt = GetEntityClockDt(simRegion, dest, source);
+            }
+        }
+        else
+        {
+            dest->pos = GetSimSpacePos(simRegion, source);
+        }
+
+        dest->gatheredPos = dest->pos;
+    }
+
+    return dest;
+}
+
+internal void
+BuildSimCollisionRules(game_state *gameState, sim_region *simRegion);
+
+// NOTE : Only the entities that have their turn in this step go into the lists,
+// so the systems never see the ones that are skipped.
+// The sleeping ones are left out too, because they only wait for a collision to wake them up.
+// Heroes always go in, because their system is where the controller wakes them up.
+inline bool32
+ShouldBeInTypeList(sim_entity *entity)
+{
+    bool32 result = (entity->updatable && entity->dt > 0.0f &&
+                    (!IsSet(entity, EntityFlag_Sleeping) || entity->type == EntityType_Hero));
+    return result;
+}
+
+// NOTE : Counting sort, so that every list is contiguous in one array.
+internal void
+BuildSimEntityTypeLists(sim_region *simRegion)
+{
+    uint32 typeCounts[EntityType_Count] = {};
+    uint32 updatableCount = 0;
+    for(uint32 entityIndex = 0;
+        entityIndex < simRegion->entityCount;
+        ++entityIndex)
+    {
+        sim_entity *entity = simRegion->entities + entityIndex;
+        if(ShouldBeInTypeList(entity))
+        {
+            Assert(entity->type < EntityType_Count);
+            ++typeCounts[entity->type];
+            ++updatableCount;
+        }
+    }
+
+    sim_entity **listEntities = PushArray(simRegion->arena, updatableCount, sim_entity *);
+    for(uint32 type = 0;
+        type < EntityType_Count;
+        ++type)
+    {
+        sim_entity_list *list = simRegion->typeLists + type;
+        list->count = 0;
+        list->entities = listEntities;
+        listEntities += typeCounts[type];
+    }
+
+    for(uint32 entityIndex = 0;
+        entityIndex < simRegion->entityCount;
+        ++entityIndex)
+    {
+        sim_entity *entity = simRegion->entities + entityIndex;
+        if(ShouldBeInTypeList(entity))
+        {
+            sim_entity_list *list = simRegion->typeLists + entity->type;
+            list->entities[list->count++] = entity;
+        }
+    }
+}
+
+// NOTE : Everything that BeginSim gathers for these region bounds.
+// The updatable entities can stick out of the region by their radius, and the entities around them
+// are gathered as far as the slowest clock lets them move in one step, so that they can collide.
+// The streaming and the world gen should have all of these chunks in memory before BeginSim.
+inline rect3
+GetSimRegionGatherBounds(rect3 regionBounds, real32 dt)
+{
+    // See how far can the entity go in one step, 
+    // which is longer for the entities that don't run every step
+    real32 updateSafetyMargin = SIM_MAX_ENTITY_RADIUS + SIM_MAX_CLOCK_INTERVAL*dt*SIM_MAX_ENTITY_VELOCITY; 
+    real32 updateSafetyMarginZ = 1.0f;
+
+    rect3 updatableBounds = AddRadiusToRect(regionBounds, V3(SIM_MAX_ENTITY_RADIUS, SIM_MAX_ENTITY_RADIUS, 0.0f));
+    rect3 result = AddRadiusToRect(updatableBounds, V3(updateSafetyMargin, updateSafetyMargin, updateSafetyMarginZ));
+
+    return result;
+}
+
+// start the simulation to update the entities
+internal sim_region *
+BeginSim(memory_arena *simArena, sim_entity_hash_table *hash, game_state *gameState, world *world, 
+        world_position regionCenter, rect3 regionBounds, rect3 fullRateBounds,
+        real32 dt)
+{
+    BEGIN_TIMED_BLOCK(BeginSim);
+
+    // TODO : Maybe don't take a gameState here, and make the low entities stored in the world?
+    // For now, we need gameState to get the stored entites
+    sim_region *simRegion = PushStruct(simArena, sim_region);
+    simRegion->hash = hash;
+    BeginSimEntityHash(simRegion->hash);
+
+    simRegion->maxEntityRadius = SIM_MAX_ENTITY_RADIUS;
+    simRegion->maxEntityVelocity = SIM_MAX_ENTITY_VELOCITY;
+
+    simRegion->world = world;
+    simRegion->arena = simArena;
+    simRegion->origin = regionCenter;
+    simRegion->updatableBounds = 
+        AddRadiusToRect(regionBounds, V3(simRegion->maxEntityRadius, simRegion->maxEntityRadius, 0.0f));
+    simRegion->fullRateBounds = fullRateBounds;
+    simRegion->stepIndex = gameState->simStepIndex;
+    simRegion->dt = dt;
+    simRegion->bounds = GetSimRegionGatherBounds(regionBounds, dt);
+
+    // NOTE : Only the chunks that have entities come out of the query
+    world_query query = BeginWorldQuery(world, simArena, simRegion->origin, simRegion->bounds);
+
+    // NOTE : Size everything by what's actually in the chunks.
+    // Referenced entities that are outside of these chunks(i.e. the sword in the hand) 
+    // are not counted, so the entities array grows for them while we gather.
+    simRegion->maxEntityCount = query.maxEntityCount;
+    simRegion->entityCount = 0;
+    ZeroStruct(simRegion->typeLists);
+    ReserveSimEntityHash(simRegion->hash, simRegion->maxEntityCount);
+    // NOTE : Nothing should be pushed to the simArena until the gather is done,
+    // so that the entities array can grow in place!
+    simRegion->entities = PushArray(simArena, simRegion->maxEntityCount, sim_entity);
+
+    world_chunk *testChunk = 0;
+    world_entity_bounds_test boundsTest = {};
+    for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+        IsValid(&iter);
+        Advance(&iter))
+    {
+        // NOTE : Most of the entities that are out get thrown out by the bounds in the blocks,
+        // so that we don't have to touch their low entities.
+        if(iter.chunk != testChunk)
+        {
+            testChunk = iter.chunk;
+            boundsTest = GetEntityBoundsTest(world, testChunk, simRegion->origin, simRegion->bounds);
+        }
+        if(!EntityBoundsMightOverlap(iter.block, iter.entitySlot, &boundsTest))
+        {
+            continue;
+        }
+
+        uint32 storedEntityIndex = iter.lowEntityIndex;
+        low_entity *stored = GetLowEntity(gameState, storedEntityIndex);
+
+        if(!IsSet(stored, EntityFlag_Nonspatial))
+        {
+            // Get the simspacepos so that when we add entity to the sim region,
+            // we can also set the position of that entity
+            v3 simSpacePos = GetSimSpacePos(simRegion, stored);
+            if(EntityOverlapsRectangle(simSpacePos, stored->collision->totalVolume, simRegion->bounds))
+            {
+                // TODO : Check a second rectangle to set the entity
+                // to be movable or not?
+                // Get the stored entity and add entity ot the sim region 
+                // so we can process it.
+                AddEntityToSimRegion(gameState, simRegion, storedEntityIndex, stored, &simSpacePos);
+            }
+        }
+    }
+
+    BuildSimEntityTypeLists(simRegion);
+    BuildSimCollisionRules(gameState, simRegion);
+
+    END_TIMED_BLOCK(BeginSim);
+
+    return simRegion;
+}
+
+// After the entites(in past, this was high entities) are processed, 
+// move all the entities inside the region to the low space
+internal void
+EndSim(sim_region *simRegion, game_state *gameState)
+{
+    BEGIN_TIMED_BLOCK(EndSim);
+
+    // TODO : Maybe don't take a gameState here, low entities shold be stored in the world?
+    // For now, we need gameState to get the stored entites
+    sim_entity *simEntity = simRegion->entities;
+    for(uint32 entityIndex = 0;
+        entityIndex < simRegion->entityCount;
+        ++entityIndex, ++simEntity)
+    {
+        if(IsSet(simEntity, EntityFlag_Deleted))
+        {
+            DeleteLowEntity(gameState, simRegion, simEntity->storageIndex);
+            continue;
+        }
+
+        low_entity *storage = GetLowEntity(gameState, simEntity->storageIndex);
+        bool32 wasSpatial = !IsSet(storage, EntityFlag_Nonspatial);
+
+        // NOTE : Most of the entities(walls, stairs, the sleeping ones..) never change,
+        // so only the ones that were marked dirty are compressed.
+        if(simEntity->dirty)
+        {
+            // NOTE : Even the dirty one might end up the same(i.e. pushed against the wall), 
+            // so compress to the side first and only write back the ones that changed.
+            low_entity compressed = *storage;
+            CompressEntity(gameState, simEntity, &compressed);
+
+            if(!AreBytesEqual(sizeof(compressed), &compressed, storage))
+            {
+                *storage = compressed;
+            }
+        }
+        else
+        {
+#if FOX_SLOW
+            // NOTE : Whoever changed this entity should have marked it dirty!
+            low_entity compressed = *storage;
+            CompressEntity(gameState, simEntity, &compressed);
+            Assert(AreBytesEqual(sizeof(compressed), &compressed, storage));
+            Assert(simEntity->pos.x == simEntity->gatheredPos.x &&
+                    simEntity->pos.y == simEntity->gatheredPos.y &&
+                    simEntity->pos.z == simEntity->gatheredPos.z);
+#endif
+        }
+
+        // NOTE : If the entity did not move, leave the stored position as it is.
+        // Mapping it back costs us, and the float round trip can move the entity a little bit.
+        if(simEntity->pos.x != simEntity->gatheredPos.x ||
+            simEntity->pos.y != simEntity->gatheredPos.y ||
+            simEntity->pos.z != simEntity->gatheredPos.z)
+        {
+            // If the entityflag_nonspatial was set, it means it should go to the nullposition
+            // if not, map into the chunkspace to store it.
+            world_position newChunkBasedPos = 
+                IsSet(simEntity, EntityFlag_Nonspatial) ? 
+                    NullPosition() : 
+                    MapIntoChunkSpace(gameState->world, simRegion->origin, simEntity->pos);
+
+            // NOTE : This only touches the entity blocks when the chunk has changed
+            ChangeEntityLocation(gameState->world, &gameState->lowEntities, simEntity->storageIndex, newChunkBasedPos);
+
+            if(wasSpatial && !IsSet(simEntity, EntityFlag_Nonspatial))
+            {
+                // NOTE : Start this move from where the last one was drawn at the end of the previous step,
+                // so that the entity never jumps when its clock interval changes.
+                v3 drawnPos = GetEntityRenderOffset(storage, simRegion->stepIndex - 1, 1.0f);
+                storage->prevPos = drawnPos - (simEntity->pos - simEntity->gatheredPos);
+                storage->moveStep = simRegion->stepIndex;
+                int32 moveStepCount = (simRegion->dt > 0.0f) ? RoundReal32ToInt32(simEntity->dt / simRegion->dt) : 1;
+                storage->moveStepCount = (uint8)Maximum(Minimum(moveStepCount, SIM_MAX_CLOCK_INTERVAL), 1);
+            }
+            else
+            {
+                // NOTE : Entities that appeared or disappeared in this step did not move,
+                // they should not be drawn sliding from or to somewhere else.
+                storage->prevPos = V3(0, 0, 0);
+                storage->moveStepCount = 0;
+            }
+        }
+
+        // NOTE : Only the updatable entities that had their turn were moved to this step.
+        // If this one is still moving, the low frequency update takes over once it's out of the sim region.
+        // The sleeping ones don't need the step, because only the full sim can wake them up.
+        if(simEntity->updatable && simEntity->dt > 0.0f && IsLowSimAwake(storage))
+        {
+            storage->lastSimStep = gameState->simStepIndex;
+
+            world_chunk *chunk = 
+                GetWorldChunk(gameState->world, storage->pos.chunkX, storage->pos.chunkY, storage->pos.chunkZ);
+            Assert(chunk);
+            QueueChunkForLowSim(gameState->world, chunk);
+        }
+    
+        if(simEntity->storageIndex == gameState->cameraFollowingEntity.index &&
+            storage->generation == gameState->cameraFollowingEntity.generation)
+        {
+            world_position newCameraPos = gameState->cameraPos;
+            newCameraPos.chunkZ = storage->pos.chunkZ;    
+
+            // real32 camZOffset = newCameraPos.offset_.z;
+            newCameraPos = storage->pos;
+            // newCameraPos.offset_.z = camZOffset;
+            gameState->cameraPos = newCameraPos;
+        }
+    }
+
+    END_TIMED_BLOCK(EndSim);
+}
+
+// NOTE : Tests the four walls of the minkowski box at once, one wall per SIMD lane.
+// Every volume pair between two entities is added to the same lanes, 
+// so that the closest(or the furthest) wall of all of them is picked only once in EndWallTest.
+/*
+    t : the t we already have. Only the walls that are closer(or further, if fromInside) than this are tested.
+    fromInside : false if we want the first wall the entity will hit(tMin, solid ones),
+                 true if we want the last wall the entity will go through(tMax, traversable ones)
+*/
+inline void
+BeginWallTest(wall_test *test, real32 t, bool32 fromInside)
+{
+    test->fromInside = fromInside;
+    test->t_4x = _mm_set1_ps(t);
+    // Put infinity(or -infinity) to the walls we didn't hit, so that they are never picked
+    test->best_4x = _mm_set1_ps(fromInside ? -Real32Max : Real32Max);
+    test->hitLanes = 0;
+}
+
+/*
+    minCorner, maxCorner : minkowski box relative to the entity we are testing against
+    rel : entity position relative to the entity we are testing against
+    entityDelta : how much the entity wants to move. t = 1.0f is the destination.
+*/
+internal void
+AddWallTest(wall_test *test, v3 minCorner, v3 maxCorner, v3 rel, v3 entityDelta)
+{
+    // Same order as the walls that we had, so that the ties are resolved in the same way.
+    // Each lane is one wall :
+    //  0 : x = maxCorner.x, normal(1, 0, 0)
+    //  1 : x = minCorner.x, normal(-1, 0, 0)
+    //  2 : y = minCorner.y, normal(0, 1, 0)
+    //  3 : y = maxCorner.y, normal(0, -1, 0)
+    __m128 wallX_4x = _mm_setr_ps(maxCorner.x, minCorner.x, minCorner.y, maxCorner.y);
+    __m128 relX_4x = _mm_setr_ps(rel.x, rel.x, rel.y, rel.y);
+    __m128 relY_4x = _mm_setr_ps(rel.y, rel.y, rel.x, rel.x);
+    __m128 deltaX_4x = _mm_setr_ps(entityDelta.x, entityDelta.x, entityDelta.y, entityDelta.y);
+    __m128 deltaY_4x = _mm_setr_ps(entityDelta.y, entityDelta.y, entityDelta.x, entityDelta.x);
+    __m128 minY_4x = _mm_setr_ps(minCorner.y, minCorner.y, minCorner.x, minCorner.x);
+    __m128 maxY_4x = _mm_setr_ps(maxCorner.y, maxCorner.y, maxCorner.x, maxCorner.x);
+    __m128 zero_4x = _mm_set1_ps(0.0f);
+
+    //Equation : p0x(formal player position x) + t * dx(player delta x) = wx(Wall x)
+    // NOTE : The lanes that has 0 delta will have garbage here, but they are masked out below
+    __m128 tResult_4x = _mm_div_ps(_mm_sub_ps(wallX_4x, relX_4x), deltaX_4x);
+    // y value of the new player position 
+    __m128 y_4x = _mm_add_ps(relY_4x, _mm_mul_ps(tResult_4x, deltaY_4x));
+
+    // We also need to check the tResult because if it's less than 0, 
+    // it means the player have to go backward to hit the wall - which we don't care.
+    // And the y should be inside the bound(minY ~ maxY), 
+    // which means the player is going to collide with this certain wall
+    __m128 hitMask_4x = _mm_and_ps(_mm_cmpneq_ps(deltaX_4x, zero_4x), 
+                                    _mm_cmpge_ps(tResult_4x, zero_4x));
+    hitMask_4x = _mm_and_ps(hitMask_4x, _mm_and_ps(_mm_cmpge_ps(y_4x, minY_4x), 
+                                                    _mm_cmple_ps(y_4x, maxY_4x)));
+
+    // NOTE : The walls that we didn't hit keep what they had from the other volume pairs
+    if(test->fromInside)
+    {
+        hitMask_4x = _mm_and_ps(hitMask_4x, _mm_cmpgt_ps(tResult_4x, test->t_4x));
+        __m128 masked_4x = _mm_or_ps(_mm_and_ps(hitMask_4x, tResult_4x),
+                                    _mm_andnot_ps(hitMask_4x, test->best_4x));
+        test->best_4x = _mm_max_ps(test->best_4x, masked_4x);
+    }
+    else
+    {
+        hitMask_4x = _mm_and_ps(hitMask_4x, _mm_cmplt_ps(tResult_4x, test->t_4x));
+        __m128 masked_4x = _mm_or_ps(_mm_and_ps(hitMask_4x, tResult_4x),
+                                    _mm_andnot_ps(hitMask_4x, test->best_4x));
+        test->best_4x = _mm_min_ps(test->best_4x, masked_4x);
+    }
+
+    test->hitLanes |= _mm_movemask_ps(hitMask_4x);
+}
+
+// If the entity hits any wall, t becomes the new t and the normal of that wall is returned
+internal bool32
+EndWallTest(wall_test *test, real32 *t, v3 *wallNormal)
+{
+    bool32 hit = false;
+    if(test->hitLanes)
+    {
+        // Spread the min(or max) to every lane
+        __m128 best_4x = test->best_4x;
+        if(test->fromInside)
+        {
+            best_4x = _mm_max_ps(best_4x, _mm_shuffle_ps(best_4x, best_4x, _MM_SHUFFLE(2, 3, 0, 1)));
+            best_4x = _mm_max_ps(best_4x, _mm_shuffle_ps(best_4x, best_4x, _MM_SHUFFLE(1, 0, 3, 2)));
+        }
+        else
+        {
+            best_4x = _mm_min_ps(best_4x, _mm_shuffle_ps(best_4x, best_4x, _MM_SHUFFLE(2, 3, 0, 1)));
+            best_4x = _mm_min_ps(best_4x, _mm_shuffle_ps(best_4x, best_4x, _MM_SHUFFLE(1, 0, 3, 2)));
+        }
+
+        // If multiple walls have the same t, the first wall wins
+        uint32 bestLanes = test->hitLanes & _mm_movemask_ps(_mm_cmpeq_ps(test->best_4x, best_4x));
+        bit_scan_result bestWall = FindLeastSignificantSetBit(bestLanes);
+        Assert(bestWall.found);
+
+        v3 normals[] = 
+        {
+            V3(1, 0, 0),
+            V3(-1, 0, 0),
+            V3(0, 1, 0),
+            V3(0, -1, 0),
+        };
+
+        real32 tEpsilon = 0.001f;
+        // Always clamp to 0
+        // because if the tresult is too small, it can be negative value
+        *t = Maximum(0.0f, _mm_cvtss_f32(best_4x) - tEpsilon);
+        *wallNormal = normals[bestWall.index];
+        hit = true;
+    }
+
+    return hit;
+}
+
+#if FOX_TEST
+// NOTE : The wall test that MoveEntity had before the SIMD one, wall by wall and in the same order.
+// Only the tests use this, to check the SIMD one against it.
+struct test_wall
+{
+    real32 x;
+    real32 relX; 
+    real32 relY; 
+    real32 deltaX; 
+    real32 deltaY;
+    real32 minY; 
+    real32 maxY;
+    v3 normal;
+};
+
+internal bool32
+TestWallsScalar(v3 minCorner, v3 maxCorner, v3 rel, v3 entityDelta, bool32 fromInside, 
+                real32 *t, v3 *wallNormal)
+{
+    test_wall walls[] = 
+    {
+        {maxCorner.x, rel.x, rel.y, entityDelta.x, entityDelta.y, minCorner.y, maxCorner.y, V3(1, 0, 0)},
+        {minCorner.x, rel.x, rel.y, entityDelta.x, entityDelta.y, minCorner.y, maxCorner.y, V3(-1, 0, 0)},
+        {minCorner.y, rel.y, rel.x, entityDelta.y, entityDelta.x, minCorner.x, maxCorner.x, V3(0, 1, 0)},
+        {maxCorner.y, rel.y, rel.x, entityDelta.y, entityDelta.x, minCorner.x, maxCorner.x, V3(0, -1, 0)}
+    };
+
+    bool32 hit = false;
+    for(uint32 wallIndex = 0;
+        wallIndex < ArrayCount(walls);
+        wallIndex++)
+    {
+        test_wall *wall = walls + wallIndex;
+
+        real32 tEpsilon = 0.001f;
+        if(wall->deltaX != 0.0f)
+        {
+            //Equation : p0x(formal player position x) + t * dx(player delta x) = wx(Wall x)
+            real32 tResult = (wall->x - wall->relX) / wall->deltaX;
+            // y value of the new player position 
+            real32 y = wall->relY + tResult * wall->deltaY;
+
+            bool32 isBetter = fromInside ? (*t < tResult) : (*t > tResult);
+            if(tResult >= 0 && isBetter)
+            {
+                if(y >= wall->minY && y <= wall->maxY)
+                {
+                    *t = Maximum(0.0f, tResult - tEpsilon);
+                    *wallNormal = wall->normal;
+                    hit = true;
+                }
+            }
+        }
+    }
+
+    return hit;
+}
+#endif
+
+#define INITIAL_COLLISION_RULE_COUNT 256
+#define INITIAL_COLLISION_RULE_ENTITY_COUNT 256
+
+struct collision_rule_links
+{
+    uint32 *prev;
+    uint32 *next;
+};
+
+// Get the list links of the rule for the entity, because one rule is
+// in the list of both entities.
+inline collision_rule_links
+GetCollisionRuleLinks(pairwise_collision_rule *rule, uint32 storageIndex)
+{
+    collision_rule_links result;
+
+    if(rule->storageIndexA == storageIndex)
+    {
+        result.prev = &rule->prevInA;
+        result.next = &rule->nextInA;
+    }
+    else
+    {
+        Assert(rule->storageIndexB == storageIndex);
+        result.prev = &rule->prevInB;
+        result.next = &rule->nextInB;
+    }
+
+    return result;
+}
+
+inline uint32
+GetCollisionRuleHomeSlot(collision_rule_table *table, uint32 storageIndexA, uint32 storageIndexB)
+{
+    uint32 result = HashUInt32Pair(storageIndexA, storageIndexB) & (table->ruleMaxCount - 1);
+    return result;
+}
+
+inline uint32
+GetCollisionRuleEntityHomeSlot(collision_rule_table *table, uint32 storageIndex)
+{
+    uint32 result = HashUInt32(storageIndex) & (table->entityMaxCount - 1);
+    return result;
+}
+
+// NOTE : Returns true if the entry whose home slot is homeSlot
+// can NOT be moved to emptySlot, because it's between the empty slot and itself.
+// This is for the backward shift deletion of the linear probing.
+inline bool32
+ShouldStayInSlot(uint32 emptySlot, uint32 slot, uint32 homeSlot)
+{
+    bool32 result;
+    if(emptySlot <= slot)
+    {
+        result = (emptySlot < homeSlot) && (homeSlot <= slot);
+    }
+    else
+    {
+        result = (emptySlot < homeSlot) || (homeSlot <= slot);
+    }
+
+    return result;
+}
+
+internal void
+AllocateCollisionRuleTable(collision_rule_table *table, memory_arena *arena, 
+                            uint32 ruleMaxCount, uint32 entityMaxCount)
+{
+    table->ruleCount = 0;
+    table->ruleMaxCount = ruleMaxCount;
+    table->rules = PushArrayZeroed(arena, table->ruleMaxCount, pairwise_collision_rule);
+
+    table->entityCount = 0;
+    table->entityMaxCount = entityMaxCount;
+    table->entities = PushArrayZeroed(arena, table->entityMaxCount, collision_rule_entity);
+}
+
+internal void
+InitializeCollisionRules(collision_rule_table *table, memory_arena *arena)
+{
+    SubArena(&table->arenas[0], arena, COLLISION_RULE_ARENA_SIZE);
+    SubArena(&table->arenas[1], arena, COLLISION_RULE_ARENA_SIZE);
+    table->currentArena = 0;
+
+    AllocateCollisionRuleTable(table, &table->arenas[table->currentArena], 
+                                INITIAL_COLLISION_RULE_COUNT, 
+                                INITIAL_COLLISION_RULE_ENTITY_COUNT);
+}
+
+// Get the head of the rule list of the entity.
+// If shouldAdd is true, make a new one when there is no head for this entity.
+internal collision_rule_entity *
+GetCollisionRuleEntity(collision_rule_table *table, uint32 storageIndex, bool32 shouldAdd = false)
 {
     Assert(storageIndex);
 
-    sim_entity_hash *result = 0;
+    collision_rule_entity *result = 0;
+
+    uint32 hashMask = table->entityMaxCount - 1;
+    uint32 slot = GetCollisionRuleEntityHomeSlot(table, storageIndex);
+    for(;;)
+    {
+        collision_rule_entity *entry = table->entities + slot;
+        if(entry->storageIndex == storageIndex)
+        {
+            result = entry;
+            break;
+        }
+        else if(entry->storageIndex == 0)
+        {
+            if(shouldAdd)
+            {
+                // NOTE : AddCollisionRule grows the table before it gets here
+                Assert(table->entityCount < table->entityMaxCount - 1);
+                entry->storageIndex = storageIndex;
+                entry->firstRule = 0;
+                ++table->entityCount;
+                result = entry;
+            }
+            break;
+        }
+
+        slot = (slot + 1) & hashMask;
+    }
+
+    return result;
+}
 
-    uint32 hashValue = storageIndex;
-    // Internal hash search
-    for(uint32 offset = 0;
-        offset < ArrayCount(simRegion->hash);
-        ++offset)
-    {
-        // & ArrayCount is for getting only the low bits 
-        // because 
-        uint32 hashMask = (ArrayCount(simRegion->hash) - 1);
-        uint32 hashIndex = ((hashValue + offset) & hashMask);
-        sim_entity_hash *entry = simRegion->hash + hashIndex;
+internal void
+RemoveCollisionRuleEntity(collision_rule_table *table, uint32 storageIndex)
+{
+    collision_rule_entity *entry = GetCollisionRuleEntity(table, storageIndex);
+    Assert(entry && entry->firstRule == 0);
 
-        // if entry->index == 0, we found a empty hash before finding a hash that has corret index
-        // which means this index was never stored
-        // if entry->index == index, we found a hash that has same index, so we return it 
-        if(entry->index == 0 || entry->index == storageIndex)
+    uint32 hashMask = table->entityMaxCount - 1;
+    uint32 emptySlot = (uint32)(entry - table->entities);
+    uint32 slot = emptySlot;
+    for(;;)
+    {
+        slot = (slot + 1) & hashMask;
+        collision_rule_entity *test = table->entities + slot;
+        if(test->storageIndex == 0)
         {
-            result = entry;
             break;
         }
+
+        uint32 homeSlot = GetCollisionRuleEntityHomeSlot(table, test->storageIndex);
+        if(!ShouldStayInSlot(emptySlot, slot, homeSlot))
+        {
+            table->entities[emptySlot] = *test;
+            emptySlot = slot;
+        }
     }
-    return result;
+
+    table->entities[emptySlot].storageIndex = 0;
+    table->entities[emptySlot].firstRule = 0;
+    --table->entityCount;
 }
 
-inline void
-StoreEntityReference(entity_reference *ref)
+// Put the rule in front of the rule list of the entity
+internal void
+LinkCollisionRule(collision_rule_table *table, uint32 ruleSlot, uint32 storageIndex)
 {
-    if(ref->ptr != 0)
+    collision_rule_entity *entity = GetCollisionRuleEntity(table, storageIndex, true);
+
+    collision_rule_links links = GetCollisionRuleLinks(table->rules + ruleSlot, storageIndex);
+    *links.prev = 0;
+    *links.next = entity->firstRule;
+    if(entity->firstRule)
     {
-        ref->index = ref->ptr->storageIndex;
+        pairwise_collision_rule *first = table->rules + (entity->firstRule - 1);
+        *GetCollisionRuleLinks(first, storageIndex).prev = ruleSlot + 1;
     }
+    entity->firstRule = ruleSlot + 1;
 }
 
-inline sim_entity *
-GetEntityByStorageIndex(sim_region *simRegion, uint32 storageIndex)
+internal void
+UnlinkCollisionRule(collision_rule_table *table, uint32 ruleSlot, uint32 storageIndex)
 {
-    sim_entity_hash *entry = GetHashFromStorageIndex(simRegion, storageIndex);
-    sim_entity *result = entry->ptr;
-    return result;
+    collision_rule_links links = GetCollisionRuleLinks(table->rules + ruleSlot, storageIndex);
+    uint32 prev = *links.prev;
+    uint32 next = *links.next;
+
+    if(next)
+    {
+        *GetCollisionRuleLinks(table->rules + (next - 1), storageIndex).prev = prev;
+    }
+
+    if(prev)
+    {
+        *GetCollisionRuleLinks(table->rules + (prev - 1), storageIndex).next = next;
+    }
+    else
+    {
+        collision_rule_entity *entity = GetCollisionRuleEntity(table, storageIndex);
+        Assert(entity && entity->firstRule == ruleSlot + 1);
+        entity->firstRule = next;
+        if(entity->firstRule == 0)
+        {
+            // NOTE : This entity does not have any rules left
+            RemoveCollisionRuleEntity(table, storageIndex);
+        }
+    }
 }
 
-internal sim_entity *
-AddEntityToSimRegion(game_state *gameState, sim_region *region, uint32 storageIndex, low_entity *source, v3 *simPos);
-inline void
-LoadEntityReference(game_state *gameState, sim_region *simRegion, entity_reference *ref)
+// Move the rule to the other slot, and fix every link that was pointing to it
+internal void
+MoveCollisionRule(collision_rule_table *table, uint32 fromSlot, uint32 toSlot)
 {
-    // Check whether the added entity has entity reference 
-    // that also needed to be loaded
-    // if the index was 0, it means there are no entity referenced
-    if(ref->index)
+    pairwise_collision_rule *rule = table->rules + toSlot;
+    *rule = table->rules[fromSlot];
+
+    uint32 storageIndices[] = {rule->storageIndexA, rule->storageIndexB};
+    for(uint32 endIndex = 0;
+        endIndex < ArrayCount(storageIndices);
+        ++endIndex)
     {
-        sim_entity_hash *entry = GetHashFromStorageIndex(simRegion, ref->index);
+        uint32 storageIndex = storageIndices[endIndex];
+        collision_rule_links links = GetCollisionRuleLinks(rule, storageIndex);
 
-        if(entry->ptr == 0)
+        if(*links.prev)
         {
-            low_entity *low = gameState->lowEntities + ref->index;
-            entry->index = ref->index;
-            v3 simSpacePos = GetSimSpacePos(simRegion, low);            
-            // The reference was not in there yet
-            entry->ptr = AddEntityToSimRegion(gameState, simRegion, ref->index, low, &simSpacePos);
+            *GetCollisionRuleLinks(table->rules + (*links.prev - 1), storageIndex).next = toSlot + 1;
+        }
+        else
+        {
+            GetCollisionRuleEntity(table, storageIndex)->firstRule = toSlot + 1;
         }
 
-        ref->ptr = entry->ptr;
+        if(*links.next)
+        {
+            *GetCollisionRuleLinks(table->rules + (*links.next - 1), storageIndex).prev = toSlot + 1;
+        }
     }
 }
 
-internal sim_entity *
-AddEntityToSimRegionRaw(game_state *gameState, sim_region *simRegion, uint32 storageIndex, low_entity *source)
+internal pairwise_collision_rule *
+FindCollisionRule(collision_rule_table *table, uint32 storageIndexA, uint32 storageIndexB)
 {
-    Assert(storageIndex);
+    Assert(storageIndexA < storageIndexB);
 
-    sim_entity *entity = 0;
+    pairwise_collision_rule *result = 0;
 
-    sim_entity_hash *entry = GetHashFromStorageIndex(simRegion, storageIndex);
-    if(entry->ptr == 0)
+    uint32 hashMask = table->ruleMaxCount - 1;
+    uint32 slot = GetCollisionRuleHomeSlot(table, storageIndexA, storageIndexB);
+    for(;;)
     {
-        if(simRegion->entityCount < simRegion->maxEntityCount)
+        pairwise_collision_rule *rule = table->rules + slot;
+        if(rule->storageIndexA == 0)
+        {
+            break;
+        }
+        else if(rule->storageIndexA == storageIndexA &&
+                rule->storageIndexB == storageIndexB)
         {
-            entity = simRegion->entities + simRegion->entityCount++;
+            result = rule;
+            break;
+        }
 
-            // MapStorageIndexToHash 
-            Assert(entry->index == 0 || entry->index == storageIndex);
-            // If the entry hash was already set, this process is unnecassirly but doesn't matter
-            // however, if the entry->index == 0, it means the hash is not set, so we have to set it
-            // This is basically overkill XD
-            entry->index = storageIndex;
-            entry->ptr = entity;
+        slot = (slot + 1) & hashMask;
+    }
 
-            if(source)
-            {
-                // TODO : This should really be a decompression step, not a copy!
-                *entity = source->sim;
+    return result;
+}
 
-                // Load Entity Reference that this sim entity has, which is sword for now.
-                // This has to be here because if we did not do the copy, 
-                // the sim does not have reference to the sowrd - it's empty!
-                LoadEntityReference(gameState, simRegion, &entity->sword);
-            }
+// Put the rule into an empty slot and link it to the list of both entities
+internal pairwise_collision_rule *
+InsertCollisionRule(collision_rule_table *table, uint32 storageIndexA, uint32 storageIndexB)
+{
+    uint32 hashMask = table->ruleMaxCount - 1;
+    uint32 slot = GetCollisionRuleHomeSlot(table, storageIndexA, storageIndexB);
+    while(table->rules[slot].storageIndexA)
+    {
+        slot = (slot + 1) & hashMask;
+    }
 
-            entity->storageIndex = storageIndex;
-            entity->updatable = false;
+    pairwise_collision_rule *rule = table->rules + slot;
+    *rule = {};
+    rule->storageIndexA = storageIndexA;
+    rule->storageIndexB = storageIndexB;
+    ++table->ruleCount;
+
+    LinkCollisionRule(table, slot, storageIndexA);
+    LinkCollisionRule(table, slot, storageIndexB);
+
+    return rule;
+}
+
+internal void
+RemoveCollisionRule(collision_rule_table *table, uint32 ruleSlot)
+{
+    pairwise_collision_rule *rule = table->rules + ruleSlot;
+    UnlinkCollisionRule(table, ruleSlot, rule->storageIndexA);
+    UnlinkCollisionRule(table, ruleSlot, rule->storageIndexB);
+
+    // NOTE : Backward shift deletion, so that we don't need any tombstones
+    // and the probes never get longer because of the removed rules.
+    uint32 hashMask = table->ruleMaxCount - 1;
+    uint32 emptySlot = ruleSlot;
+    uint32 slot = ruleSlot;
+    for(;;)
+    {
+        slot = (slot + 1) & hashMask;
+        pairwise_collision_rule *test = table->rules + slot;
+        if(test->storageIndexA == 0)
+        {
+            break;
         }
-        else
+
+        uint32 homeSlot = GetCollisionRuleHomeSlot(table, test->storageIndexA, test->storageIndexB);
+        if(!ShouldStayInSlot(emptySlot, slot, homeSlot))
         {
-            InvalidCodePath;
+            MoveCollisionRule(table, slot, emptySlot);
+            emptySlot = slot;
         }
     }
 
-    return entity;
+    table->rules[emptySlot] = {};
+    --table->ruleCount;
 }
 
-// We get the stored entity and make it to simulation entity
-internal sim_entity *
-AddEntityToSimRegion(game_state *gameState, sim_region *simRegion, uint32 storageIndex, low_entity *source, v3 *simPos)
+// NOTE : Keep the load of both tables under 3/4 so that the probes stay short.
+// One rule can add two entities.
+inline bool32
+ShouldGrowCollisionRules(collision_rule_table *table)
 {
-    sim_entity *dest = AddEntityToSimRegionRaw(gameState, simRegion, storageIndex, source);
-    if(dest)
+    bool32 result = ((table->ruleCount + 1)*4 > table->ruleMaxCount*3 ||
+                    (table->entityCount + 2)*4 > table->entityMaxCount*3);
+    return result;
+}
+
+// NOTE : Makes the new tables in the other arena and puts every rule in them again,
+// and then the old arena is reset. The entity table is built again from the rules.
+internal void
+GrowCollisionRules(collision_rule_table *table)
+{
+    collision_rule_table oldTable = *table;
+
+    uint32 ruleMaxCount = oldTable.ruleMaxCount;
+    if((oldTable.ruleCount + 1)*4 > ruleMaxCount*3)
     {
-        // TODO : Convert the stored entity to a simulation entity
-        if(simPos)
-        {
-           // Assert(IsCanonical(simRegion->world, *simPos));
-            dest->pos = *simPos;
-            dest->updatable = EntityOverlapsRectangle(dest->pos, dest->collision->totalVolume, simRegion->updatableBounds);
-        }
-        else
+        ruleMaxCount *= 2;
+    }
+    uint32 entityMaxCount = oldTable.entityMaxCount;
+    if((oldTable.entityCount + 2)*4 > entityMaxCount*3)
+    {
+        entityMaxCount *= 2;
+    }
+
+    uint32 newArenaIndex = 1 - oldTable.currentArena;
+    memory_arena *newArena = &table->arenas[newArenaIndex];
+    newArena->used = 0;
+    AllocateCollisionRuleTable(table, newArena, ruleMaxCount, entityMaxCount);
+    table->currentArena = newArenaIndex;
+
+    for(uint32 oldSlot = 0;
+        oldSlot < oldTable.ruleMaxCount;
+        ++oldSlot)
+    {
+        pairwise_collision_rule *oldRule = oldTable.rules + oldSlot;
+        if(oldRule->storageIndexA)
         {
-            dest->pos = GetSimSpacePos(simRegion, source);
+            pairwise_collision_rule *rule = 
+                InsertCollisionRule(table, oldRule->storageIndexA, oldRule->storageIndexB);
+            rule->canCollide = oldRule->canCollide;
         }
     }
 
-    return dest;
+    table->arenas[oldTable.currentArena].used = 0;
 }
 
-// start the simulation to update the entities
-internal sim_region *
-BeginSim(memory_arena *simArena, game_state *gameState, world *world, 
-        world_position regionCenter, rect3 regionBounds,
-        real32 dt)
+#define MIN_SIM_COLLISION_RULE_COUNT 64
+
+inline uint32
+GetSimCollisionRuleHomeSlot(sim_region *simRegion, uint32 storageIndexA, uint32 storageIndexB)
 {
-    // TODO : Maybe don't take a gameState here, and make the low entities stored in the world?
-    // For now, we need gameState to get the stored entites
-    sim_region *simRegion = PushStruct(simArena, sim_region);
-    ZeroStruct(simRegion->hash);
+    uint32 result = HashUInt32Pair(storageIndexA, storageIndexB) & (simRegion->collisionRuleMaxCount - 1);
+    return result;
+}
 
-    // TODO : Try to make these get enforced more precisely
-    simRegion->maxEntityRadius = 5.0f;
-    simRegion->maxEntityVelocity = 30.0f;
-    // See how far can the entity go in one frame
-    real32 updateSafetyMargin = simRegion->maxEntityRadius + dt*simRegion->maxEntityVelocity; 
-    real32 updateSafetyMarginZ = 1.0f;
+// NOTE : Returns the rule of the pair, or the empty slot where the rule should go
+internal sim_collision_rule *
+FindSimCollisionRule(sim_region *simRegion, uint32 storageIndexA, uint32 storageIndexB)
+{
+    Assert(storageIndexA < storageIndexB);
 
-    simRegion->world = world;
-    simRegion->origin = regionCenter;
-    simRegion->updatableBounds = 
-        AddRadiusToRect(regionBounds, V3(simRegion->maxEntityRadius, simRegion->maxEntityRadius, 0.0f));
-    simRegion->bounds = 
-        AddRadiusToRect(simRegion->updatableBounds, V3(updateSafetyMargin, updateSafetyMargin, updateSafetyMarginZ));
+    sim_collision_rule *result = 0;
 
-    // TODO : Need to be more specific about maxEntityCounts
-    simRegion->maxEntityCount = 4096;
-    simRegion->entityCount = 0;
-    simRegion->entities = PushArray(simArena, simRegion->maxEntityCount, sim_entity);
+    uint32 hashMask = simRegion->collisionRuleMaxCount - 1;
+    uint32 slot = GetSimCollisionRuleHomeSlot(simRegion, storageIndexA, storageIndexB);
+    for(;;)
+    {
+        sim_collision_rule *rule = simRegion->collisionRules + slot;
+        if(rule->storageIndexA == 0 ||
+            (rule->storageIndexA == storageIndexA && rule->storageIndexB == storageIndexB))
+        {
+            result = rule;
+            break;
+        }
+
+        slot = (slot + 1) & hashMask;
+    }
+
+    return result;
+}
 
-    world_position minChunkPos = MapIntoChunkSpace(world, simRegion->origin, GetMinCorner(simRegion->bounds));
-    world_position maxChunkPos = MapIntoChunkSpace(world, simRegion->origin, GetMaxCorner(simRegion->bounds));
+internal void
+AllocateSimCollisionRules(sim_region *simRegion, uint32 maxCount)
+{
+    simRegion->collisionRuleCount = 0;
+    simRegion->collisionRuleMaxCount = maxCount;
+    simRegion->collisionRules = PushArrayZeroed(simRegion->arena, maxCount, sim_collision_rule);
+}
 
-    for(int32 chunkZ = minChunkPos.chunkZ;
-        chunkZ <= maxChunkPos.chunkZ;
-        ++chunkZ)
+internal void
+SetSimCollisionRule(sim_region *simRegion, uint32 storageIndexA, uint32 storageIndexB, bool32 canCollide)
+{
+    sim_collision_rule *rule = FindSimCollisionRule(simRegion, storageIndexA, storageIndexB);
+    if(rule->storageIndexA == 0)
     {
-        for(int32 chunkY = minChunkPos.chunkY;
-            chunkY <= maxChunkPos.chunkY;
-            ++chunkY)
+        // Keep the load under 3/4 so that the probes stay short
+        if((simRegion->collisionRuleCount + 1)*4 > simRegion->collisionRuleMaxCount*3)
         {
-            for(int32 chunkX = minChunkPos.chunkX;
-                chunkX <= maxChunkPos.chunkX;
-                ++chunkX)
+            // NOTE : The old rules are in the sim arena, so they will be gone in EndSim anyway
+            sim_collision_rule *oldRules = simRegion->collisionRules;
+            uint32 oldMaxCount = simRegion->collisionRuleMaxCount;
+            AllocateSimCollisionRules(simRegion, 2*oldMaxCount);
+
+            for(uint32 oldSlot = 0;
+                oldSlot < oldMaxCount;
+                ++oldSlot)
             {
-                world_chunk *chunk = GetWorldChunk(world, chunkX, chunkY, chunkZ);
-
-                // There is a possibility that we don't get the chunk
-                if(chunk)
+                sim_collision_rule *oldRule = oldRules + oldSlot;
+                if(oldRule->storageIndexA)
                 {
-                    for(world_entity_block *block = &chunk->firstBlock;
-                        block;
-                        block = block->next)
-                    {
-                        for(uint32 entityIndexIndex = 0;
-                            entityIndexIndex < block->entityCount;
-                            ++entityIndexIndex)
-                        {
-                            uint32 storedEntityIndex = block->lowEntityIndexes[entityIndexIndex];
-                            low_entity *stored = gameState->lowEntities + storedEntityIndex;
-
-                            if(!IsSet(&stored->sim, EntityFlag_Nonspatial))
-                            {
-                                // Get the simspacepos so that when we add entity to the sim region,
-                                // we can also set the position of that entity
-                                v3 simSpacePos = GetSimSpacePos(simRegion, stored);
-                                if(EntityOverlapsRectangle(simSpacePos, stored->sim.collision->totalVolume, simRegion->bounds))
-                                {
-                                    // TODO : Check a second rectangle to set the entity
-                                    // to be movable or not?
-                                    // Get the stored entity and add entity ot the sim region 
-                                    // so we can process it.
-                                    AddEntityToSimRegion(gameState, simRegion, storedEntityIndex, stored, &simSpacePos);
-                                }
-                            }
-                        }
-                    }
+                    *FindSimCollisionRule(simRegion, oldRule->storageIndexA, oldRule->storageIndexB) = *oldRule;
+                    ++simRegion->collisionRuleCount;
                 }
-            }    
+            }
+
+            rule = FindSimCollisionRule(simRegion, storageIndexA, storageIndexB);
         }
+
+        rule->storageIndexA = storageIndexA;
+        rule->storageIndexB = storageIndexB;
+        ++simRegion->collisionRuleCount;
     }
 
-    return simRegion;
+    rule->canCollide = canCollide;
 }
 
-// After the entites(in past, this was high entities) are processed, 
-// move all the entities inside the region to the low space
 internal void
-EndSim(sim_region *simRegion, game_state *gameState)
+RemoveSimCollisionRule(sim_region *simRegion, uint32 storageIndexA, uint32 storageIndexB)
 {
-    // TODO : Maybe don't take a gameState here, low entities shold be stored in the world?
-    // For now, we need gameState to get the stored entites
-    sim_entity *simEntity = simRegion->entities;
-    for(uint32 entityIndex = 0;
-        entityIndex < simRegion->entityCount;
-        ++entityIndex, ++simEntity)
+    sim_collision_rule *rule = FindSimCollisionRule(simRegion, storageIndexA, storageIndexB);
+
+    // NOTE : The rule might not be here if the other entity is outside of the region
+    if(rule->storageIndexA)
     {
-        low_entity *storage = gameState->lowEntities + simEntity->storageIndex;
-        
-        // Just block copy the sim ezntity
-        storage->sim = *simEntity;
-        // Store the sword to the low space
-        StoreEntityReference(&storage->sim.sword);
-
-        // If the entityflag_nonspatial was set, it means it should go to the nullposition
-        // if not, map into the chunkspace to store it.
-        world_position newChunkBasedPos = 
-            IsSet(simEntity, EntityFlag_Nonspatial) ? 
-                NullPosition() : 
-                MapIntoChunkSpace(gameState->world, simRegion->origin, simEntity->pos);
-
-        // TODO : Save state back to the stored entity, once high entities
-        // do state decompression, etc.
-        ChangeEntityLocation(&gameState->worldArena, gameState->world, storage, simEntity->storageIndex,   
-                            newChunkBasedPos);
-    
-        if(simEntity->storageIndex == gameState->cameraFollowingEntityIndex)
+        uint32 hashMask = simRegion->collisionRuleMaxCount - 1;
+        uint32 emptySlot = (uint32)(rule - simRegion->collisionRules);
+        uint32 slot = emptySlot;
+        for(;;)
         {
-            world_position newCameraPos = gameState->cameraPos;
-            newCameraPos.chunkZ = storage->pos.chunkZ;    
+            slot = (slot + 1) & hashMask;
+            sim_collision_rule *test = simRegion->collisionRules + slot;
+            if(test->storageIndexA == 0)
+            {
+                break;
+            }
 
-            // real32 camZOffset = newCameraPos.offset_.z;
-            newCameraPos = storage->pos;
-            // newCameraPos.offset_.z = camZOffset;
-            gameState->cameraPos = newCameraPos;
+            uint32 homeSlot = GetSimCollisionRuleHomeSlot(simRegion, test->storageIndexA, test->storageIndexB);
+            if(!ShouldStayInSlot(emptySlot, slot, homeSlot))
+            {
+                simRegion->collisionRules[emptySlot] = *test;
+                emptySlot = slot;
+            }
         }
+
+        simRegion->collisionRules[emptySlot] = {};
+        --simRegion->collisionRuleCount;
     }
 }
 
-// It's just written in one form, but it can used for every situation - don't worry!
-/*
-    real32 wallX, line segment of the wall we are testing 
-    real32 relX, one of the formal player position coord relative to the base position
-    real32 relY, the other formal player position coord
-    real32 entityDeltaX, one of the destination coord. destination means the point when tMin = 1.0f
-    real32 entityDeltaY,
-    real32 *tMin, 
-    real32 minY, 
-    real32 maxY
-*/
-struct test_wall
+// Copy every rule whose both entities are in the sim region
+internal void
+BuildSimCollisionRules(game_state *gameState, sim_region *simRegion)
 {
-    real32 x;
-    real32 relX; 
-    real32 relY; 
-    real32 deltaX; 
-    real32 deltaY;
-    real32 minY; 
-    real32 maxY;
-    v3 normal;
-};
+    collision_rule_table *table = &gameState->collisionRules;
 
-internal bool32
-TestWall(real32 wallX, real32 relX, real32 relY, real32 entityDeltaX, real32 entityDeltaY,
-                real32 minY, real32 maxY, real32 *tMin)
-{
-    bool32 collided = false;
+    // NOTE : Count first so that the cache does not have to grow while we are building it.
+    // Rules between two entities in the region are counted twice, which is fine.
+    uint32 ruleCount = 0;
+    if(table->ruleCount)
+    {
+        for(uint32 entityIndex = 0;
+            entityIndex < simRegion->entityCount;
+            ++entityIndex)
+        {
+            uint32 storageIndex = simRegion->entities[entityIndex].storageIndex;
+            collision_rule_entity *entity = GetCollisionRuleEntity(table, storageIndex);
+            if(entity)
+            {
+                for(uint32 ruleSlot = entity->firstRule;
+                    ruleSlot;
+                    ruleSlot = *GetCollisionRuleLinks(table->rules + (ruleSlot - 1), storageIndex).next)
+                {
+                    ++ruleCount;
+                }
+            }
+        }
+    }
 
-    real32 tEpsilon = 0.001f;
-    if(entityDeltaX != 0.0f)
+    // Leave some room for the rules that will be added in this frame
+    uint32 maxCount = MIN_SIM_COLLISION_RULE_COUNT;
+    while(maxCount*3 < (ruleCount + MIN_SIM_COLLISION_RULE_COUNT/2)*4)
     {
-        //Equation : p0x(formal player position x) + t * dx(player delta x) = wx(Wall x)
-        real32 tResult = (wallX - relX) / entityDeltaX;
-        // y value of the new player position 
-        real32 y = relY + tResult * entityDeltaY;
+        maxCount *= 2;
+    }
+    AllocateSimCollisionRules(simRegion, maxCount);
 
-        // Check whether the tMin is greater than tResult
-        // Which means, the value we computed is the closer collision point
-        // We also need to check the tResult because if it's less than 0, 
-        // it means the player have to go backward to hit the wall - which we don't care.
-        if(tResult >= 0 && *tMin > tResult)
+    if(ruleCount)
+    {
+        for(uint32 entityIndex = 0;
+            entityIndex < simRegion->entityCount;
+            ++entityIndex)
         {
-            // Check whether the y is inside the bound(minY ~ maxY)
-            // Which means, the player is going to collide with this certain wall
-            if(y >= minY && y <= maxY)
+            uint32 storageIndex = simRegion->entities[entityIndex].storageIndex;
+            collision_rule_entity *entity = GetCollisionRuleEntity(table, storageIndex);
+            if(entity)
             {
-                // Always clamp to 0
-                // because if the tresult is too small, it can be negative value
-                *tMin = Maximum(0.0f, tResult - tEpsilon);
-                collided = true;
+                for(uint32 ruleSlot = entity->firstRule;
+                    ruleSlot;
+                    ruleSlot = *GetCollisionRuleLinks(table->rules + (ruleSlot - 1), storageIndex).next)
+                {
+                    pairwise_collision_rule *rule = table->rules + (ruleSlot - 1);
+
+                    // NOTE : Only add the rule from the A side, so that it's added once
+                    if(rule->storageIndexA == storageIndex &&
+                        GetEntityByStorageIndex(simRegion, rule->storageIndexB))
+                    {
+                        SetSimCollisionRule(simRegion, rule->storageIndexA, rule->storageIndexB, rule->canCollide);
+                    }
+                }
             }
         }
     }
-
-    return collided;
 }
 
+// If the sim region was passed, the rules of the region are also removed
 internal void
-ClearCollisionRulesFor(game_state *gameState, uint32 storageIndex)
-{
-    // TODO : NEed to make a better data structure that allows
-    // removal of collision rules without searching the entire table
-    // NOTE : One way to make removal easy would be to always 
-    // add_both_orders of the pairs of storage indices to the
-    // hash table, so no matter which position the entity is in,
-    // you can always find it. Then, when you do your first pass
-    // through for removal, you just remember the original top
-    // of the free list, and when your'e done, do a pass through all
-    // the new things on the free list, and remove the reverse of
-    // those pairs
-    uint32 hashBucket = storageIndex & (ArrayCount(gameState->collisionRules) - 1);
-    for(uint32 hashTableIndex = 0;
-        hashTableIndex < ArrayCount(gameState->collisionRules);
-        ++hashTableIndex)
-    {
-        for(pairwise_collision_rule **rulePtr = &gameState->collisionRules[hashBucket];
-            *rulePtr;
-            )
-        {
-            if((*rulePtr)->storageIndexA == storageIndex ||
-                (*rulePtr)->storageIndexB == storageIndex)
-            {
-                pairwise_collision_rule *removedRule = *rulePtr;
-                *rulePtr = (*rulePtr)->nextInHash;
-
-                // Set the First Free Collision Rule
-                removedRule->nextInHash = gameState->firstFreeCollisionRule;
-                gameState->firstFreeCollisionRule = removedRule;
+ClearCollisionRulesFor(game_state *gameState, sim_region *simRegion, uint32 storageIndex)
+{
+    collision_rule_table *table = &gameState->collisionRules;
 
-                break;            
-            }
+    // NOTE : Every rule of this entity is in its list,
+    // and the head is removed when the list becomes empty.
+    for(collision_rule_entity *entity = GetCollisionRuleEntity(table, storageIndex);
+        entity;
+        entity = GetCollisionRuleEntity(table, storageIndex))
+    {
+        pairwise_collision_rule *rule = table->rules + (entity->firstRule - 1);
+        if(simRegion)
+        {
+            RemoveSimCollisionRule(simRegion, rule->storageIndexA, rule->storageIndexB);
         }
+        RemoveCollisionRule(table, entity->firstRule - 1);
     }
 }
 
+// If the sim region was passed, the rule is also added to the region
+// so that CanCollide can see it in this frame.
 internal void
-AddCollisionRule(game_state *gameState, uint32 storageIndexA, uint32 storageIndexB, 
+AddCollisionRule(game_state *gameState, sim_region *simRegion, uint32 storageIndexA, uint32 storageIndexB, 
                 bool32 canCollide) // Rule we want to add
 {
+    collision_rule_table *table = &gameState->collisionRules;
+
     // So that it can be pairwise!
     if(storageIndexA > storageIndexB)
     {
@@ -417,53 +1638,30 @@ AddCollisionRule(game_state *gameState, uint32 storageIndexA, uint32 storageInde
         storageIndexA = storageIndexB;
         storageIndexB = temp;
     }
+    Assert(storageIndexA && storageIndexA != storageIndexB);
 
-    pairwise_collision_rule *found = 0;
-    // TODO : Better Hash Function .... LOL
-    uint32 hashBucket = storageIndexA & (ArrayCount(gameState->collisionRules) - 1);
-    for(pairwise_collision_rule *rule = gameState->collisionRules[hashBucket];
-        rule;
-        rule = rule->nextInHash)
-    {
-        if(rule->storageIndexA == storageIndexA && 
-            rule->storageIndexB == storageIndexB)
-        {
-            found = rule;
-            break;            
-        }
-    }
-
+    pairwise_collision_rule *found = FindCollisionRule(table, storageIndexA, storageIndexB);
     if(!found)
     {
-        // If we could not find it, check the first free collision rule
-        found = gameState->firstFreeCollisionRule;
-
-        if(found)
-        {
-            // Because now this place is full, set it to the nextinhash
-            gameState->firstFreeCollisionRule = found->nextInHash;
-        }
-        else
+        if(ShouldGrowCollisionRules(table))
         {
-            // If we could not found it, make new one
-            found = PushStruct(&gameState->worldArena, pairwise_collision_rule);
+            GrowCollisionRules(table);
         }
-        // Now we insert this to between the pointer and the thing that was pointed; 
-        found->nextInHash = gameState->collisionRules[hashBucket];
-        gameState->collisionRules[hashBucket] = found;
+
+        found = InsertCollisionRule(table, storageIndexA, storageIndexB);
     }
 
-    if(found)
+    found->canCollide = canCollide;
+
+    if(simRegion)
     {
-        found->storageIndexA = storageIndexA;
-        found->storageIndexB = storageIndexB;
-        found->canCollide = canCollide;
+        SetSimCollisionRule(simRegion, storageIndexA, storageIndexB, canCollide);
     }
 }
 
 // This function has nothing to do with the flag_collide
 internal bool32
-CanCollide(game_state *gameState, sim_entity *a, sim_entity *b)
+CanCollide(game_state *gameState, sim_region *simRegion, sim_entity *a, sim_entity *b)
 {
     bool32 result = false;
 
@@ -487,22 +1685,15 @@ CanCollide(game_state *gameState, sim_entity *a, sim_entity *b)
                 result = true;
             }                
 
-            // TODO : Better Hash Function .... LOL
-            // We always find the rule based on the first entity(which has smaller entitytype)
-            // which means, this hash table is arragned from smaller entity type to bigger entity type
-            uint32 hashBucket = a->storageIndex & (ArrayCount(gameState->collisionRules) - 1);
-
-            for(pairwise_collision_rule *rule = gameState->collisionRules[hashBucket];
-                rule;
-                rule = rule->nextInHash)
+            // result will not change if there are no rules!
+            if(simRegion->collisionRuleCount)
             {
-                // result will not change if there are no rules!
-                if(rule->storageIndexA == a->storageIndex && 
-                    rule->storageIndexB == b->storageIndex)
+                sim_collision_rule *rule = 
+                    FindSimCollisionRule(simRegion, a->storageIndex, b->storageIndex);
+                if(rule->storageIndexA)
                 {
                     // For now, we have only 1 rule
                     result = rule->canCollide;
-                    break;            
                 }
             }
         }
@@ -512,14 +1703,17 @@ CanCollide(game_state *gameState, sim_entity *a, sim_entity *b)
 }
 
 internal bool32
-HandleCollision(game_state *gameState, sim_entity *entity, sim_entity *hitEntity)
+HandleCollision(game_state *gameState, sim_region *simRegion, sim_entity *entity, sim_entity *hitEntity)
 {
     // TODO : More logic here!
     bool32 stopsOnCollision = false;
 
+    // NOTE : Whoever got hit might have to do something about it
+    WakeEntity(hitEntity);
+
     if(entity->type == EntityType_Sword)
     {
-        AddCollisionRule(gameState, entity->storageIndex, hitEntity->storageIndex, false);        
+        AddCollisionRule(gameState, simRegion, entity->storageIndex, hitEntity->storageIndex, false);        
         stopsOnCollision = false;
     }
     else
@@ -543,6 +1737,7 @@ HandleCollision(game_state *gameState, sim_entity *entity, sim_entity *hitEntity
         if(a->hitPointMax > 0)
         {
             --a->hitPointMax;
+            a->dirty = true;
         }
         MakeEntityNonSpatial(b);
     }
@@ -647,13 +1842,22 @@ SpeculativeCollide(sim_entity *mover, sim_entity *region)
     return result;
 }
 
+// If the entity is slower than this while resting on the ground, it goes to sleep
+#define ENTITY_SLEEP_SPEED 0.01f
+
 // This is the actual collision detection for most of the entities
 internal void
 MoveEntity(game_state *gameState, sim_region *simRegion, sim_entity *entity, 
             real32 dtForFrame, move_spec *moveSpec, v3 ddP)
 {
+    BEGIN_TIMED_BLOCK(MoveEntity);
+
+    // Is anyone trying to move this entity in this frame?
+    bool32 isPushed = (LengthSq(ddP) > 0.0f);
+
     // If the entity was nospatial, it should not be come here!
     Assert(!IsSet(entity, EntityFlag_Nonspatial));
+    entity->dirty = true;
     
     world *world = simRegion->world;
 
@@ -753,8 +1957,18 @@ MoveEntity(game_state *gameState, sim_region *simRegion, sim_entity *entity,
                     // 2. two entities can collide
                     if((CanOverlap(gameState, entity, testEntity) && 
                         EntitiesOverlap(entity, testEntity, V3(overlapEpsilon))) ||
-                        CanCollide(gameState, entity, testEntity))                    
+                        CanCollide(gameState, simRegion, entity, testEntity))                    
                     {
+                        bool32 isTraversable = IsSet(testEntity, EntityFlag_Traversable);
+
+                        // NOTE : Every volume pair goes into the same wall test,
+                        // so that we only pick the wall once for this entity
+                        wall_test wallTest;
+                        BeginWallTest(&wallTest, isTraversable ? tMax : tMin, isTraversable);
+
+                        // Coordinates relative of the entity we are testing against
+                        v3 rel = entity->pos - testEntity->pos;
+
                         for(uint32 entityVolumeIndex = 0;
                             entityVolumeIndex < entity->collision->volumeCount;
                             ++entityVolumeIndex)
@@ -782,124 +1996,45 @@ MoveEntity(game_state *gameState, sim_region *simRegion, sim_entity *entity,
                                 v3 minCorner = -0.5f*minkowskiDiameter;
                                 v3 maxCorner = 0.5f*minkowskiDiameter;
 
-                                // Coordinates relative of the entity we are testing against
-                                v3 rel = entity->pos - testEntity->pos;
-                                
                                 // NOTE : We should start checking collision
                                 // _ONLY IF_ the Z is in the bound 
                                 if(rel.z >= minCorner.z && rel.z < maxCorner.z)
                                 {
-                                    test_wall walls[] = 
-                                    {
-                                        {maxCorner.x, rel.x, rel.y, entityDelta.x, entityDelta.y, minCorner.y, maxCorner.y, V3(1, 0, 0)},                    
-                                        {minCorner.x, rel.x, rel.y, entityDelta.x, entityDelta.y, minCorner.y, maxCorner.y, V3(-1, 0, 0)},
-                                        {minCorner.y, rel.y, rel.x, entityDelta.y, entityDelta.x, minCorner.x, maxCorner.x, V3(0, 1, 0)},
-                                        {maxCorner.y, rel.y, rel.x, entityDelta.y, entityDelta.x, minCorner.x, maxCorner.x, V3(0, -1, 0)}                    
-                                    };
-
-                                    if(IsSet(testEntity, EntityFlag_Traversable))
-                                    {
-                                        // NOTE : We are only checking this 
-                                        // against the one that the entity is overlapping!
-
-                                        v3 testWallNormal = {};
-                                        real32 tMaxTest = tMax;                                    
-                                        bool32 hitThis = false;
-                                
-                                        for(uint32 wallIndex = 0;
-                                            wallIndex < ArrayCount(walls);
-                                            wallIndex++)
-                                        {
-                                            test_wall *wall = walls + wallIndex;
-
-                                            real32 tEpsilon = 0.001f;
-                                            if(wall->deltaX != 0.0f)
-                                            {
-                                                //Equation : p0x(formal player position x) + t * dx(player delta x) = wx(Wall x)
-                                                real32 tResult = (wall->x - wall->relX) / wall->deltaX;
-                                                // y value of the new player position 
-                                                real32 y = wall->relY + tResult * wall->deltaY;
-                                        
-                                                // Check whether the tMin is greater than tResult
-                                                // Which means, the value we computed is the closer collision point
-                                                // We also need to check the tResult because if it's less than 0, 
-                                                // it means the player have to go backward to hit the wall - which we don't care.
-                                                if(tResult >= 0 && tMaxTest < tResult)
-                                                {
-                                                    // Check whether the y is inside the bound(minY ~ maxY)
-                                                    // Which means, the player is going to collide with this certain wall
-                                                    if(y >= wall->minY && y <= wall->maxY)
-                                                    {
-                                                        tMaxTest = Maximum(0.0f, tResult - tEpsilon);
-                                                        testWallNormal = wall->normal;
-                                                        hitThis = true;
-                                                    }
-                                                }
-                                            }
-                                        }
-
-                                        if(hitThis)
-                                        {
-                                            tMax = tMaxTest;
-                                            wallNormalMax = testWallNormal;
-                                            hitEntityMax = testEntity;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        v3 testWallNormal = {};
-                                        real32 tMinTest = tMin;                                    
-                                        bool32 hitThis = false;
-
-                                        for(uint32 wallIndex = 0;
-                                            wallIndex < ArrayCount(walls);
-                                            wallIndex++)
-                                        {
-                                            test_wall *wall = walls + wallIndex;
-
-                                            real32 tEpsilon = 0.001f;
-                                            if(wall->deltaX != 0.0f)
-                                            {
-                                                //Equation : p0x(formal player position x) + t * dx(player delta x) = wx(Wall x)
-                                                real32 tResult = (wall->x - wall->relX) / wall->deltaX;
-                                                // y value of the new player position 
-                                                real32 y = wall->relY + tResult * wall->deltaY;
-                                        
-                                                // Check whether the tMin is greater than tResult
-                                                // Which means, the value we computed is the closer collision point
-                                                // We also need to check the tResult because if it's less than 0, 
-                                                // it means the player have to go backward to hit the wall - which we don't care.
-                                                if(tResult >= 0 && tMinTest > tResult)
-                                                {
-                                                    // Check whether the y is inside the bound(minY ~ maxY)
-                                                    // Which means, the player is going to collide with this certain wall
-                                                    if(y >= wall->minY && y <= wall->maxY)
-                                                    {
-                                                        // Always clamp to 0
-                                                        // because if the tresult is too small, it can be negative value
-                                                        tMinTest = Maximum(0.0f, tResult - tEpsilon);
-                                                        testWallNormal = wall->normal;
-                                                        hitThis = true;
-                                                    }
-                                                }
-                                            }
-                                        }
-
-                                        // Before passing to the actual collision test below
-                                        // Do the speculative collide first!
-                                        if(hitThis)
-                                        {
-                                            // Position that the entity would end up in this collision iteration
-                                            v3 testPos = entity->pos + tMinTest * entityDelta;
-                                            // Test this position and if passes, make this to permanent ones
-                                            if(SpeculativeCollide(entity, testEntity))
-                                            {
-                                                tMin = tMinTest;
-                                                wallNormalMin = testWallNormal;
-                                                hitEntityMin = testEntity;
-                                            }
-                                        }
-                                    }
+                                    AddWallTest(&wallTest, minCorner, maxCorner, rel, entityDelta);
+                                }
+                            }
+                        }
+
+                        v3 testWallNormal = {};
+                        if(isTraversable)
+                        {
+                            // NOTE : We are only checking this 
+                            // against the one that the entity is overlapping!
+                            real32 tMaxTest = tMax;
+                            if(EndWallTest(&wallTest, &tMaxTest, &testWallNormal))
+                            {
+                                tMax = tMaxTest;
+                                wallNormalMax = testWallNormal;
+                                hitEntityMax = testEntity;
+                            }
+                        }
+                        else
+                        {
+                            real32 tMinTest = tMin;
+                            bool32 hitThis = EndWallTest(&wallTest, &tMinTest, &testWallNormal);
+
+                            // Before passing to the actual collision test below
+                            // Do the speculative collide first!
+                            if(hitThis)
+                            {
+                                // Position that the entity would end up in this collision iteration
+                                v3 testPos = entity->pos + tMinTest * entityDelta;
+                                // Test this position and if passes, make this to permanent ones
+                                if(SpeculativeCollide(entity, testEntity))
+                                {
+                                    tMin = tMinTest;
+                                    wallNormalMin = testWallNormal;
+                                    hitEntityMin = testEntity;
                                 }
                             }
                         }
@@ -931,7 +2066,7 @@ MoveEntity(game_state *gameState, sim_region *simRegion, sim_entity *entity,
             if(hitEntity)
             {   
                 entityDelta = desiredPosition - entity->pos;
-                bool32 stopsOnCollision = HandleCollision(gameState, entity, hitEntity);
+                bool32 stopsOnCollision = HandleCollision(gameState, simRegion, entity, hitEntity);
                 if(stopsOnCollision)
                 {
                     // Recalculate the delta as much as it moved
@@ -1025,4 +2160,16 @@ MoveEntity(game_state *gameState, sim_region *simRegion, sim_entity *entity,
             entity->facingDirection = 3;
         }
     }
+
+    // NOTE : If nothing is pushing the entity and it's almost stopped on the ground,
+    // stop it completely and put it to sleep so that we don't have to move it every frame.
+    if(!isPushed &&
+        IsSet(entity, EntityFlag_ZSupported) &&
+        LengthSq(entity->dPos) < Square(ENTITY_SLEEP_SPEED))
+    {
+        entity->dPos = V3(0, 0, 0);
+        AddFlags(entity, EntityFlag_Sleeping);
+    }
+
+    END_TIMED_BLOCK(MoveEntity);
 }
\ No newline at end of file
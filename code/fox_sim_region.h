@@ -23,6 +23,8 @@ enum entity_type
     EntityType_Monster,
     EntityType_Sword,    
     EntityType_Stairwell,    
+
+    EntityType_Count,
 };
 
 #define HIT_POINT_SUB_COUNT 4
@@ -33,10 +35,20 @@ struct hit_point
     uint8 filledAmount;
 };
 
+// NOTE : Storage index of the low entity, and the generation of that slot when we got it.
+// Slots are reused when the entity is deleted, and the generation goes up every time,
+// so the handle that is pointing to the old entity does not match anymore.
+// 0 in index is the null handle.
+struct low_entity_handle
+{
+    uint32 index;
+    uint32 generation;
+};
+
 struct sim_entity;
 union entity_reference
 {
-    uint32 index;
+    low_entity_handle handle;
     sim_entity *ptr;  
 };
 
@@ -49,6 +61,11 @@ enum sim_entity_flags
     // Whether the entity is on the ground or not
     EntityFlag_ZSupported = (1 << 3),
     EntityFlag_Traversable = (1 << 4),    
+    // NOTE : Resting on the ground with nothing pushing it, so MoveEntity skips this one
+    // until something wakes it up
+    EntityFlag_Sleeping = (1 << 5),
+    // NOTE : EndSim deletes the low entity of this one instead of storing it back
+    EntityFlag_Deleted = (1 << 6),
 };
 
 struct sim_entity_collision_volume
@@ -73,20 +90,26 @@ struct sim_entity
 {
     uint32 storageIndex;
     bool32 updatable;
+    // NOTE : Set by whatever changes something that is stored in the low entity,
+    // so that EndSim only compresses the entities that changed
+    bool32 dirty;
 
     // This is now relative to the simulation position
     // This is now the ground point, NOT the center of the entity! 
     v3 pos;
+    // NOTE : Position when this entity was gathered,
+    // so that EndSim can tell whether it moved or not
+    v3 gatheredPos;
 
     v3 dPos;
+    // NOTE : Acceleration that was requested for this step(by the controller, for now)
+    v3 ddP;
 
     entity_type type;
     uint32 flags;
     
     // TODO 
     sim_entity_collision_volume_group *collision;
-    // What the hell is this var?
-    int32 dAbsTileZ;
 
     // TODO : should hitpoints themsleves be entities?
     uint32 hitPointMax;
@@ -108,17 +131,81 @@ struct sim_entity
     real32 walkableHeight;
 
     v2 walkableDim;
+
+    // NOTE : How long this entity moves in this step(see per-entity clocking in BeginSim).
+    // 0 if this step is not its turn.
+    real32 dt;
+};
+
+// NOTE : Four walls of the minkowski boxes, one wall per lane(see BeginWallTest)
+struct wall_test
+{
+    bool32 fromInside;
+    // The t we already have
+    __m128 t_4x;
+    // Closest(or furthest) t of each wall, out of every volume pair that was added
+    __m128 best_4x;
+    int32 hitLanes;
 };
 
+// NOTE : Copy of one collision rule between two entities of the sim region
+struct sim_collision_rule
+{
+    // storageIndexA is always smaller than storageIndexB,
+    // and 0 in storageIndexA means this slot is empty
+    uint32 storageIndexA;
+    uint32 storageIndexB;
+    bool32 canCollide;
+};
+
+// NOTE : The entry is only valid when the generation is same as the generation of the table,
+// so that we don't have to clear the table every time we begin the sim.
 struct sim_entity_hash
 {
     sim_entity *ptr;
     uint32 index;
+    uint32 generation;
+};
+
+// This is to get the sim entity based on the storage index
+// because now, the storgae entity does not know about sim entity.
+// This lives across the frames, and every BeginSim just starts a new generation.
+// TODO : If we want multiple sim regions at the same time, each of them needs its own table!
+struct sim_entity_hash_table
+{
+    // NOTE : The entries are the only thing in this arena,
+    // so that we can throw them away and get bigger ones when the table grows.
+    memory_arena arena;
+
+    uint32 generation;
+    uint32 count;
+    // NOTE : This must be power of two!
+    uint32 maxCount;
+    uint32 hashShift;
+    sim_entity_hash *entries;
 };
 
+// NOTE : Updatable entities of one type, pointing into the entities of the sim region
+struct sim_entity_list
+{
+    uint32 count;
+    sim_entity **entities;
+};
+
+// NOTE : Per-entity clocking. The movable entities that we can't see run every few steps,
+// and move by all the time they skipped when it's their turn. 
+// This must be power of two.
+#define SIM_MAX_CLOCK_INTERVAL 4
+// NOTE : The entities closer than this to the edge of the updatable bounds run at the slowest rate
+#define SIM_CLOCK_EDGE_BAND 5.0f
+
+// TODO : Try to make these get enforced more precisely
+#define SIM_MAX_ENTITY_RADIUS 5.0f
+#define SIM_MAX_ENTITY_VELOCITY 30.0f
+
 struct sim_region
 {
-    world *world;
+    struct world *world;
 
     real32 maxEntityRadius;
     real32 maxEntityVelocity;
@@ -128,17 +215,35 @@ struct sim_region
     // bounds of this sim_region
     rect3 bounds;
     rect3 updatableBounds;
+    // NOTE : Everything that can move in here runs every step
+    rect3 fullRateBounds;
+
+    // The step that this region is simulating, and how long one step is
+    uint32 stepIndex;
+    real32 dt;
 
     uint32 maxEntityCount;
     uint32 entityCount;
     sim_entity *entities;
 
-    // This is to get the sim entity based on the storage index
-    // because now, the storgae entity does not know about sim entity
-    // So if someone want to get the sim entity with storageindex,
+    // NOTE : These are built at the end of BeginSim, so that each system
+    // can go through only the entities that it cares about.
+    // Entities that were added after that are not in here!
+    sim_entity_list typeLists[EntityType_Count];
+
+    // If someone want to get the sim entity with storageindex,
     // you have to come to hash using the storageIndex, get the hash,
     // and then get the pointer to the sim entity
-    sim_entity_hash hash[4096];
+    sim_entity_hash_table *hash;
+
+    // NOTE : Every collision rule between the entities in this region,
+    // gathered in BeginSim so that CanCollide can find the rule with one probe
+    // instead of going through the rule lists of the game state.
+    // This must be power of two!
+    memory_arena *arena;
+    uint32 collisionRuleCount;
+    uint32 collisionRuleMaxCount;
+    sim_collision_rule *collisionRules;
 };
 
 #define FOX_SIM_REGION_H
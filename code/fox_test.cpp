@@ -0,0 +1,1131 @@
+/******************************************************************************
+File:   fox_test.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    Tests for the game code. The whole game is included here, the same way fox.so is built,
+    so the tests can call anything inside. The memory, the work queue and the files
+    come from the linux platform layer.
+
+    Every test is in the table at the bottom. Expect only counts the failure and goes on,
+    and the asserts are on, so the game code asserting is a failure too.
+*****/
+
+#include "fox.cpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "linux_fox.h"
+#include "linux_fox_memory.cpp"
+#include "linux_fox_queue.cpp"
+#include "linux_fox_file.cpp"
+
+global_variable uint32 globalExpectFailCount;
+
+#define Expect(expression) if(!(expression)) {TestExpectFailed(__FILE__, __LINE__, #expression);}
+
+internal void
+TestExpectFailed(char *fileName, int line, char *expression)
+{
+    printf("  %s(%d) : %s\n", fileName, line, expression);
+    ++globalExpectFailCount;
+}
+
+// NOTE : The game memory that every test gets. Reserved like the platform layer does,
+// so the arenas go through the same commit and decommit as in the game.
+struct test_memory
+{
+    game_memory gameMemory;
+    thread_context thread;
+};
+
+internal void
+BeginTestMemory(test_memory *memory, memory_index permanentSize, memory_index transientSize)
+{
+    *memory = {};
+    memory->gameMemory.permanentStorageSize = permanentSize;
+    memory->gameMemory.transientStorageSize = transientSize;
+    memory->gameMemory.debugPlatformFreeFileMemory = DEBUGPlatformFreeFileMemory;
+    memory->gameMemory.debugPlatformReadEntireFile = DEBUGPlatformReadEntireFile;
+    memory->gameMemory.debugPlatformWriteEntireFile = DEBUGPlatformWriteEntireFile;
+
+    bool32 reserved = LinuxReserveGameMemory(&memory->gameMemory, 0, Kilobytes(64));
+    Assert(reserved);
+    bool32 initialized = LinuxInitializeThreadContext(&memory->thread, LINUX_SCRATCH_ARENA_SIZE);
+    Assert(initialized);
+
+#if FOX_DEBUG
+    debugGlobalMemory = &memory->gameMemory;
+#endif
+}
+
+internal void
+EndTestMemory(test_memory *memory)
+{
+    game_memory *gameMemory = &memory->gameMemory;
+    munmap(gameMemory->permanentStorage,
+            (uint8 *)gameMemory->transientStorage - (uint8 *)gameMemory->permanentStorage +
+            gameMemory->transientStorageSize + Kilobytes(64));
+    munmap(memory->thread.scratchArena.base, memory->thread.scratchArena.size);
+
+#if FOX_DEBUG
+    debugGlobalMemory = 0;
+#endif
+}
+
+// NOTE : The game state without the assets, initialized like GameUpdateAndRender does.
+// The world gen only knows the tiles, and nothing is generated.
+internal game_state *
+BeginTestGameState(test_memory *memory)
+{
+    game_memory *gameMemory = &memory->gameMemory;
+    gameMemory->platformCommitMemory(gameMemory->permanentStorage, sizeof(game_state));
+    game_state *gameState = (game_state *)gameMemory->permanentStorage;
+    InitializeArena(&gameState->worldArena,
+                    (memory_index)(gameMemory->permanentStorageSize - sizeof(game_state)),
+                    (uint8 *)gameMemory->permanentStorage + sizeof(game_state),
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    gameState->world = PushStruct(&gameState->worldArena, world);
+    InitializeCollisionRules(&gameState->collisionRules, &gameState->worldArena);
+    gameState->typicalFloorHeight = 3.0f;
+    gameState->simStepDt = 1.0f / 30.0f;
+    InitializeWorld(gameState->world, &gameState->worldArena,
+                    V3(256.0f / 42.0f, 256.0f / 42.0f, gameState->typicalFloorHeight));
+    // NOTE : Only for the tile positions, the same tiles as the game
+    InitializeWorldGen(&gameState->worldGen, gameState->world, 321, 10, 10, 1.4f, 3.0f);
+    InitializeMoveSpecs(gameState);
+
+    // NOTE : Slot 0 is the null entity
+    AddLowEntity(gameState, EntityType_Null, NullPosition(), 0);
+    gameState->lowEntities.count = 1;
+
+    return gameState;
+}
+
+// NOTE : The worker threads never stop, so every test shares this one queue.
+// If each test made its own on the stack, the threads would still be looking at it after the test is gone.
+global_variable bool32 globalTestWorkQueueIsMade;
+global_variable platform_work_queue globalTestWorkQueue;
+global_variable linux_thread_startup globalTestThreadStartups[3];
+
+internal platform_work_queue *
+GetTestWorkQueue()
+{
+    if(!globalTestWorkQueueIsMade)
+    {
+        LinuxMakeQueue(&globalTestWorkQueue, ArrayCount(globalTestThreadStartups), globalTestThreadStartups);
+        globalTestWorkQueueIsMade = true;
+    }
+    platformAddEntry = LinuxAddEntry;
+    platformCompleteAllWork = LinuxCompleteAllWork;
+
+    return &globalTestWorkQueue;
+}
+
+//
+// NOTE : Tests
+//
+
+// NOTE : The same numbers every run
+struct test_series
+{
+    uint32 index;
+};
+
+inline uint32
+NextTestRandom(test_series *series)
+{
+    uint32 result = HashUInt32(series->index++);
+    return result;
+}
+
+inline real32
+TestRandomBetween(test_series *series, real32 min, real32 max)
+{
+    real32 result = min + (max - min)*((real32)(NextTestRandom(series) & 0xFFFFFF) / (real32)0xFFFFFF);
+    return result;
+}
+
+
+// NOTE : The arena should only commit what it hands out, and give it back
+// when the temporary memory ends with a lot committed after it.
+internal void
+TestArenaCommitAndDecommit()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Megabytes(1), Gigabytes(1));
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena arena;
+    InitializeArena(&arena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    Expect(arena.committed == 0);
+
+    uint8 *first = (uint8 *)PushSize(&arena, 100);
+    first[99] = 1;
+    Expect(arena.committed == ARENA_COMMIT_SIZE);
+
+    temporary_memory tempMemory = BeginTemporaryMemory(&arena);
+    memory_index bigSize = 2*ARENA_DECOMMIT_THRESHOLD;
+    uint8 *big = (uint8 *)PushSize(&arena, bigSize);
+    big[0] = 1;
+    big[bigSize - 1] = 1;
+    Expect(arena.committed >= arena.used);
+    EndTemporaryMemory(tempMemory);
+    Expect(arena.committed == ARENA_COMMIT_SIZE);
+
+    // NOTE : The memory that was given back comes back as zero
+    uint8 *again = (uint8 *)PushSizeZeroed(&arena, bigSize);
+    Expect(again == big);
+    Expect(again[0] == 0 && again[bigSize - 1] == 0);
+    Expect(first[99] == 1);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : The whole game with the platform functions of linux, without the assets
+internal void
+TestGameRunsOnReservedMemory()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(4));
+
+    game_memory *gameMemory = &memory.gameMemory;
+    gameMemory->workQueue = GetTestWorkQueue();
+    gameMemory->platformAddEntry = LinuxAddEntry;
+    gameMemory->platformCompleteAllWork = LinuxCompleteAllWork;
+    gameMemory->platformOpenPageFile = LinuxOpenPageFile;
+    gameMemory->platformReadPageFile = LinuxReadPageFile;
+    gameMemory->platformWritePageFile = LinuxWritePageFile;
+
+    game_offscreen_buffer buffer = {};
+    buffer.width = 320;
+    buffer.height = 180;
+    buffer.bytesPerPixel = 4;
+    buffer.pitch = buffer.width*buffer.bytesPerPixel;
+    buffer.memory = calloc(1, buffer.pitch*buffer.height);
+
+    for(uint32 frameIndex = 0;
+        frameIndex < 60;
+        ++frameIndex)
+    {
+        game_input input = {};
+        input.dtForFrame = 1.0f / 30.0f;
+        input.controllers[0].start.endedDown = (frameIndex == 1);
+        input.controllers[0].moveRight.endedDown = true;
+        GameUpdateAndRender(&memory.thread, gameMemory, &buffer, &input);
+    }
+
+    game_state *gameState = (game_state *)gameMemory->permanentStorage;
+    Expect(IsValid(gameState, gameState->controlledHeroes[0].entity));
+    Expect(gameState->simStepIndex > 0);
+
+    free(buffer.memory);
+    // NOTE : The world gen jobs that went ahead of time are still on the queue
+    LinuxCompleteAllWork(&memory.thread, gameMemory->workQueue);
+    EndTestMemory(&memory);
+}
+
+// NOTE : The rules should all be there after the tables grew,
+// and the tables that were thrown away should not take any memory.
+internal void
+TestCollisionRulesGrow()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Megabytes(1));
+
+    game_memory *gameMemory = &memory.gameMemory;
+    game_state *gameState = (game_state *)gameMemory->permanentStorage;
+    gameMemory->platformCommitMemory(gameState, sizeof(game_state));
+    InitializeArena(&gameState->worldArena,
+                    (memory_index)(gameMemory->permanentStorageSize - sizeof(game_state)),
+                    (uint8 *)gameMemory->permanentStorage + sizeof(game_state),
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    collision_rule_table *table = &gameState->collisionRules;
+    InitializeCollisionRules(table, &gameState->worldArena);
+    memory_index worldArenaUsed = gameState->worldArena.used;
+
+    // NOTE : Entity 1 to 200 each have a rule with the 50 entities after them
+    uint32 entityCount = 200;
+    uint32 rulesPerEntity = 50;
+    for(uint32 a = 1;
+        a <= entityCount;
+        ++a)
+    {
+        for(uint32 offset = 1;
+            offset <= rulesPerEntity;
+            ++offset)
+        {
+            AddCollisionRule(gameState, 0, a, a + offset, (a + offset) & 1);
+        }
+    }
+    Expect(table->ruleCount == entityCount*rulesPerEntity);
+    Expect(table->ruleMaxCount > INITIAL_COLLISION_RULE_COUNT);
+    Expect(table->entityMaxCount > INITIAL_COLLISION_RULE_ENTITY_COUNT);
+
+    bool32 allFound = true;
+    for(uint32 a = 1;
+        a <= entityCount;
+        ++a)
+    {
+        for(uint32 offset = 1;
+            offset <= rulesPerEntity;
+            ++offset)
+        {
+            pairwise_collision_rule *rule = FindCollisionRule(table, a, a + offset);
+            allFound &= (rule && rule->canCollide == (bool32)((a + offset) & 1));
+        }
+    }
+    Expect(allFound);
+
+    // NOTE : Every rule of the even entities goes away, and the odd ones only keep
+    // the rules with the other odd entities
+    for(uint32 a = 2;
+        a <= entityCount + rulesPerEntity;
+        a += 2)
+    {
+        ClearCollisionRulesFor(gameState, 0, a);
+    }
+    uint32 oddRuleCount = 0;
+    for(uint32 a = 1;
+        a <= entityCount;
+        a += 2)
+    {
+        for(uint32 offset = 2;
+            offset <= rulesPerEntity;
+            offset += 2)
+        {
+            Expect(FindCollisionRule(table, a, a + offset));
+            ++oddRuleCount;
+        }
+    }
+    Expect(table->ruleCount == oddRuleCount);
+
+    memory_index tableSize = table->ruleMaxCount*sizeof(pairwise_collision_rule) +
+                            table->entityMaxCount*sizeof(collision_rule_entity);
+    Expect(table->arenas[table->currentArena].used <= tableSize + 64);
+    Expect(table->arenas[1 - table->currentArena].used == 0);
+    Expect(gameState->worldArena.used == worldArenaUsed);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : The hash should grow for a dense region(even the ones denser than 65536 slots), shrink back for a sparse one,
+// and find every entity of the region in both.
+internal void
+TestSimEntityHashResizes()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Megabytes(1), Gigabytes(1));
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena arena;
+    InitializeArena(&arena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    sim_entity_hash_table hash = {};
+    InitializeSimEntityHash(&hash, &arena);
+
+    sim_region simRegion = {};
+    simRegion.hash = &hash;
+    simRegion.entities = PushArray(&arena, 100000, sim_entity);
+
+    // NOTE : 100000 entities need more than 65536 slots
+    uint32 regionCounts[] = {3000, 20, 3000, 20, 100000, 20};
+    uint32 tableCounts[] = {4096, INITIAL_SIM_ENTITY_HASH_COUNT, 4096, INITIAL_SIM_ENTITY_HASH_COUNT, 
+                            262144, INITIAL_SIM_ENTITY_HASH_COUNT};
+    for(uint32 regionIndex = 0;
+        regionIndex < ArrayCount(regionCounts);
+        ++regionIndex)
+    {
+        uint32 count = regionCounts[regionIndex];
+        BeginSimEntityHash(&hash);
+        ReserveSimEntityHash(&hash, count);
+        Expect(hash.maxCount == tableCounts[regionIndex]);
+
+        bool32 allInserted = true;
+        for(uint32 entityIndex = 0;
+            entityIndex < count;
+            ++entityIndex)
+        {
+            sim_entity *entity = simRegion.entities + entityIndex;
+            entity->storageIndex = 7*entityIndex + 1;
+            allInserted &= (FindOrInsertSimEntityHash(&hash, entity->storageIndex, entity) == entity);
+            // NOTE : The second one should find the first one
+            allInserted &= (FindOrInsertSimEntityHash(&hash, entity->storageIndex, entity + 1) == entity);
+        }
+        Expect(allInserted);
+        Expect(hash.count == count);
+
+        bool32 allFound = true;
+        for(uint32 entityIndex = 0;
+            entityIndex < count;
+            ++entityIndex)
+        {
+            sim_entity *entity = simRegion.entities + entityIndex;
+            allFound &= (GetEntityByStorageIndex(&simRegion, entity->storageIndex) == entity);
+            allFound &= (GetEntityByStorageIndex(&simRegion, entity->storageIndex + 1) == 0);
+        }
+        Expect(allFound);
+    }
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : The SIMD wall test against the scalar one that it replaced, on random boxes and moves
+// with one to three volume pairs. Every third case is on a grid, so that the walls are hit
+// at the same t and right at the corners.
+// The scalar one moves t back by the epsilon after every wall, so it can keep a wall that is not 
+// actually the first one when two walls are hit within the epsilon. 
+// That's the only difference that we allow.
+internal void
+TestWallTestMatchesScalar()
+{
+    real32 tEpsilon = 0.001f;
+    test_series series = {1234};
+
+    uint32 caseCount = 300000;
+    uint32 hitCount = 0;
+    uint32 sameCount = 0;
+    uint32 mismatchCount = 0;
+    for(uint32 caseIndex = 0;
+        caseIndex < caseCount;
+        ++caseIndex)
+    {
+        bool32 onGrid = (caseIndex % 3) == 0;
+        real32 grid = 0.25f;
+
+        bool32 fromInside = NextTestRandom(&series) & 1;
+        real32 t = fromInside ? 0.0f : 1.0f;
+        if((NextTestRandom(&series) & 3) == 0)
+        {
+            t = TestRandomBetween(&series, 0.0f, 1.0f);
+        }
+
+        v3 rel = V3(TestRandomBetween(&series, -3.0f, 3.0f), TestRandomBetween(&series, -3.0f, 3.0f), 0.0f);
+        v3 entityDelta = V3(TestRandomBetween(&series, -6.0f, 6.0f), TestRandomBetween(&series, -6.0f, 6.0f), 0.0f);
+        uint32 zeroDelta = NextTestRandom(&series) & 7;
+        if(zeroDelta == 0)
+        {
+            entityDelta.x = 0.0f;
+        }
+        else if(zeroDelta == 1)
+        {
+            entityDelta.y = 0.0f;
+        }
+        if(onGrid)
+        {
+            rel.x = grid*RoundReal32ToInt32(rel.x / grid);
+            rel.y = grid*RoundReal32ToInt32(rel.y / grid);
+            entityDelta.x = grid*RoundReal32ToInt32(entityDelta.x / grid);
+            entityDelta.y = grid*RoundReal32ToInt32(entityDelta.y / grid);
+        }
+
+        wall_test wallTest;
+        BeginWallTest(&wallTest, t, fromInside);
+        real32 scalarT = t;
+        v3 scalarNormal = {};
+        bool32 scalarHit = false;
+
+        uint32 pairCount = 1 + NextTestRandom(&series) % 3;
+        for(uint32 pairIndex = 0;
+            pairIndex < pairCount;
+            ++pairIndex)
+        {
+            v3 diameter = V3(TestRandomBetween(&series, 0.25f, 4.0f), TestRandomBetween(&series, 0.25f, 4.0f), 1.0f);
+            if(onGrid)
+            {
+                diameter.x = 2.0f*grid*CeilReal32ToInt32(diameter.x / (2.0f*grid));
+                diameter.y = 2.0f*grid*CeilReal32ToInt32(diameter.y / (2.0f*grid));
+            }
+            v3 minCorner = -0.5f*diameter;
+            v3 maxCorner = 0.5f*diameter;
+
+            AddWallTest(&wallTest, minCorner, maxCorner, rel, entityDelta);
+            scalarHit |= TestWallsScalar(minCorner, maxCorner, rel, entityDelta, fromInside, &scalarT, &scalarNormal);
+        }
+
+        real32 simdT = t;
+        v3 simdNormal = {};
+        bool32 simdHit = EndWallTest(&wallTest, &simdT, &simdNormal);
+
+        if(simdHit != scalarHit)
+        {
+            ++mismatchCount;
+        }
+        else if(simdHit)
+        {
+            ++hitCount;
+            if(simdT == scalarT && 
+                simdNormal.x == scalarNormal.x && simdNormal.y == scalarNormal.y)
+            {
+                ++sameCount;
+            }
+            else if(AbsoluteValue(simdT - scalarT) > tEpsilon + 0.00001f)
+            {
+                ++mismatchCount;
+            }
+        }
+    }
+
+    Expect(mismatchCount == 0);
+    // NOTE : Most of them should be exactly the same, otherwise the two are not solving the same thing
+    Expect(hitCount > caseCount / 4);
+    Expect(sameCount > hitCount - hitCount / 50);
+}
+
+// NOTE : The sleeping monster should still be in the region for the others to hit,
+// but no system should see it and EndSim should leave it alone, until the sword wakes it up.
+internal void
+TestSleepingEntitiesAreLeftOut()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    gameState->monsterCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.5f);
+    gameState->swordCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.1f);
+    gameState->standardRoomCollision = MakeSimpleGroundedCollision(gameState, 14.0f, 14.0f, 2.7f);
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena tranArena;
+    InitializeArena(&tranArena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    sim_entity_hash_table hash = {};
+    InitializeSimEntityHash(&hash, &tranArena);
+
+    // NOTE : Nothing moves outside of the rooms
+    AddStandardSpace(gameState, 0, 0, 0);
+    add_low_entity_result monster = AddMonster(gameState, 0, 0, 0);
+    AddFlags(monster.low, EntityFlag_Movable|EntityFlag_ZSupported|EntityFlag_Sleeping);
+    low_entity before = *monster.low;
+
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+    // NOTE : Same floors as the camera bounds of the game
+    rect3 bounds = RectMinMax(V3(-10.0f, -10.0f, -9.0f), V3(10.0f, 10.0f, 3.0f));
+
+    temporary_memory simMemory = BeginTemporaryMemory(&tranArena);
+    sim_region *simRegion = BeginSim(&tranArena, &hash, gameState, gameState->world,
+                                    origin, bounds, bounds, gameState->simStepDt);
+    sim_entity *monsterEntity = GetEntityByStorageIndex(simRegion, monster.lowIndex);
+    Expect(simRegion->entityCount == 2);
+    Expect(monsterEntity && monsterEntity->updatable && monsterEntity->dt > 0.0f);
+    Expect(simRegion->typeLists[EntityType_Monster].count == 0);
+    EndSim(simRegion, gameState);
+    EndTemporaryMemory(simMemory);
+    Expect(AreBytesEqual(sizeof(before), &before, monster.low));
+
+    // NOTE : The sword flies into the sleeping monster
+    add_low_entity_result sword = AddSword(gameState);
+    AddFlags(sword.low, EntityFlag_Movable|EntityFlag_CanCollide);
+    ChangeEntityLocation(gameState->world, &gameState->lowEntities, sword.lowIndex, 
+                        TilePositionToChunkPosition(&gameState->worldGen, -1, 0, 0));
+
+    simMemory = BeginTemporaryMemory(&tranArena);
+    simRegion = BeginSim(&tranArena, &hash, gameState, gameState->world,
+                        origin, bounds, bounds, gameState->simStepDt);
+    sim_entity *swordEntity = GetEntityByStorageIndex(simRegion, sword.lowIndex);
+    Expect(swordEntity != 0);
+    if(swordEntity)
+    {
+        swordEntity->distanceLimit = 5.0f;
+        swordEntity->dPos = V3(20.0f, 0.0f, 0.0f);
+        move_spec moveSpec = DefaultMoveSpec();
+        MoveEntity(gameState, simRegion, swordEntity, gameState->simStepDt, &moveSpec, V3(0, 0, 0));
+    }
+    EndSim(simRegion, gameState);
+    EndTemporaryMemory(simMemory);
+
+    Expect(!IsSet(monster.low, EntityFlag_Sleeping));
+    Expect(monster.low->hitPointMax == before.hitPointMax - 1);
+
+    simMemory = BeginTemporaryMemory(&tranArena);
+    simRegion = BeginSim(&tranArena, &hash, gameState, gameState->world,
+                        origin, bounds, bounds, gameState->simStepDt);
+    Expect(simRegion->typeLists[EntityType_Monster].count == 1);
+    EndTemporaryMemory(simMemory);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : Entities that are added after something else was pushed to the sim arena
+// move the entities array, and every pointer to the entities should follow it.
+internal void
+TestSimEntitiesMoveWhenGrown()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+    gameState->swordCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.1f);
+    gameState->playerCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 1.2f);
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena tranArena;
+    InitializeArena(&tranArena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    sim_entity_hash_table hash = {};
+    InitializeSimEntityHash(&hash, &tranArena);
+
+    AddWall(gameState, 0, 0, 0);
+    AddWall(gameState, 1, 0, 0);
+
+    // NOTE : These are all outside of the region, so the gather does not count them
+    uint32 outsideCount = 200;
+    uint32 firstOutside = gameState->lowEntities.count;
+    for(uint32 outsideIndex = 0;
+        outsideIndex < outsideCount;
+        ++outsideIndex)
+    {
+        AddWall(gameState, 100 + outsideIndex, 100, 0);
+    }
+    add_low_entity_result hero = 
+        AddGroundedLowEntity(gameState, EntityType_Hero, TilePositionToChunkPosition(&gameState->worldGen, 100, 102, 0),
+                            gameState->playerCollision);
+    add_low_entity_result sword = AddSword(gameState);
+    ChangeEntityLocation(gameState->world, &gameState->lowEntities, sword.lowIndex, 
+                        TilePositionToChunkPosition(&gameState->worldGen, 100, 104, 0));
+    hero.low->payload.hero.sword = sword.handle;
+
+    world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+    rect3 bounds = RectMinMax(V3(-10.0f, -10.0f, -9.0f), V3(10.0f, 10.0f, 3.0f));
+
+    temporary_memory simMemory = BeginTemporaryMemory(&tranArena);
+    sim_region *simRegion = BeginSim(&tranArena, &hash, gameState, gameState->world,
+                                    origin, bounds, bounds, gameState->simStepDt);
+    Expect(simRegion->entityCount == 2);
+
+    // NOTE : Anything after the entities array
+    PushStruct(&tranArena, sim_region);
+
+    for(uint32 outsideIndex = 0;
+        outsideIndex < outsideCount;
+        ++outsideIndex)
+    {
+        uint32 lowIndex = firstOutside + outsideIndex;
+        low_entity *low = GetLowEntity(gameState, lowIndex);
+        v3 simPos = GetSimSpacePos(simRegion, low);
+        AddEntityToSimRegion(gameState, simRegion, lowIndex, low, &simPos);
+    }
+    v3 heroPos = GetSimSpacePos(simRegion, hero.low);
+    sim_entity *heroEntity = AddEntityToSimRegion(gameState, simRegion, hero.lowIndex, hero.low, &heroPos);
+    Expect(simRegion->entityCount == outsideCount + 4);
+
+    bool32 allFound = true;
+    for(uint32 lowIndex = 1;
+        lowIndex < gameState->lowEntities.count;
+        ++lowIndex)
+    {
+        sim_entity *entity = GetEntityByStorageIndex(simRegion, lowIndex);
+        allFound &= (entity && entity->storageIndex == lowIndex &&
+                    entity >= simRegion->entities && entity < simRegion->entities + simRegion->entityCount);
+    }
+    Expect(allFound);
+    Expect(heroEntity == GetEntityByStorageIndex(simRegion, hero.lowIndex));
+    Expect(heroEntity->sword.ptr && heroEntity->sword.ptr == GetEntityByStorageIndex(simRegion, sword.lowIndex));
+
+    EndSim(simRegion, gameState);
+    EndTemporaryMemory(simMemory);
+    Expect(hero.low->payload.hero.sword.index == sword.lowIndex);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : The bounds in the entity blocks should follow the entities through every add, move and delete,
+// and the cull from them should never throw out an entity that the exact test keeps.
+internal void
+TestEntityBoundsCullIsConservative()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    world *world_ = gameState->world;
+    sim_entity_collision_volume_group *collisions[] =
+    {
+        MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f),
+        MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.1f),
+        MakeSimpleGroundedCollision(gameState, 14.0f, 14.0f, 2.7f),
+        // NOTE : Too big for the quantized radius
+        MakeSimpleGroundedCollision(gameState, 40.0f, 1.0f, 1.0f),
+    };
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena tranArena;
+    InitializeArena(&tranArena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+
+    test_series series = {77};
+    uint32 addCount = 2000;
+    uint32 firstIndex = gameState->lowEntities.count;
+    for(uint32 addIndex = 0;
+        addIndex < addCount;
+        ++addIndex)
+    {
+        int32 tileX = (int32)(NextTestRandom(&series) % 60) - 30;
+        int32 tileY = (int32)(NextTestRandom(&series) % 60) - 30;
+        int32 tileZ = (int32)(NextTestRandom(&series) % 3) - 1;
+        AddGroundedLowEntity(gameState, EntityType_Wall,
+                            TilePositionToChunkPosition(&gameState->worldGen, tileX, tileY, tileZ),
+                            collisions[NextTestRandom(&series) % ArrayCount(collisions)]);
+    }
+
+    // NOTE : Small moves mostly stay in the same chunk, and the big ones cross into the others.
+    // Every fourth one is deleted, which moves the other slots around.
+    for(uint32 addIndex = 0;
+        addIndex < addCount;
+        ++addIndex)
+    {
+        uint32 lowIndex = firstIndex + addIndex;
+        low_entity *low = GetLowEntity(gameState, lowIndex);
+        uint32 choice = NextTestRandom(&series) % 4;
+        if(choice == 0)
+        {
+            DeleteLowEntity(gameState, 0, lowIndex);
+        }
+        else
+        {
+            real32 range = (choice == 1) ? 10.0f : 0.5f;
+            v3 delta = V3(TestRandomBetween(&series, -range, range), TestRandomBetween(&series, -range, range), 0.0f);
+            ChangeEntityLocation(world_, &gameState->lowEntities, lowIndex, MapIntoChunkSpace(world_, low->pos, delta));
+        }
+    }
+
+    uint32 candidateCount = 0;
+    uint32 culledCount = 0;
+    uint32 staleCount = 0;
+    uint32 wrongCullCount = 0;
+    for(uint32 queryIndex = 0;
+        queryIndex < 50;
+        ++queryIndex)
+    {
+        world_position origin = 
+            MapIntoChunkSpace(world_, TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0),
+                            V3(TestRandomBetween(&series, -20.0f, 20.0f), TestRandomBetween(&series, -20.0f, 20.0f), 0.0f));
+        v3 radius = V3(TestRandomBetween(&series, 1.0f, 15.0f), TestRandomBetween(&series, 1.0f, 15.0f), 
+                        TestRandomBetween(&series, 0.5f, 4.0f));
+        rect3 bounds = RectCenterDim(V3(0, 0, 0), 2.0f*radius);
+
+        temporary_memory queryMemory = BeginTemporaryMemory(&tranArena);
+        world_query query = BeginWorldQuery(world_, &tranArena, origin, bounds);
+        world_chunk *testChunk = 0;
+        world_entity_bounds_test boundsTest = {};
+        for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+            IsValid(&iter);
+            Advance(&iter))
+        {
+            if(iter.chunk != testChunk)
+            {
+                testChunk = iter.chunk;
+                boundsTest = GetEntityBoundsTest(world_, testChunk, origin, bounds);
+            }
+
+            low_entity *low = GetLowEntity(gameState, iter.lowEntityIndex);
+            world_entity_block expected;
+            StoreEntityBlockBounds(&expected, 0, &low->pos, low->collision);
+            staleCount += (iter.block->boundsX[iter.entitySlot] != expected.boundsX[0] ||
+                            iter.block->boundsY[iter.entitySlot] != expected.boundsY[0] ||
+                            iter.block->boundsZ[iter.entitySlot] != expected.boundsZ[0] ||
+                            iter.block->boundsRadius[iter.entitySlot] != expected.boundsRadius[0]);
+
+            bool32 mightOverlap = EntityBoundsMightOverlap(iter.block, iter.entitySlot, &boundsTest);
+            v3 pos = SubstractTwoWMP(world_, &low->pos, &origin);
+            if(EntityOverlapsRectangle(pos, low->collision->totalVolume, bounds) && !mightOverlap)
+            {
+                ++wrongCullCount;
+            }
+            culledCount += !mightOverlap;
+            ++candidateCount;
+        }
+        EndTemporaryMemory(queryMemory);
+    }
+    Expect(staleCount == 0);
+    Expect(wrongCullCount == 0);
+    Expect(candidateCount > 0 && culledCount > 0);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : Any number of ranges of a query should go through the entities of the whole query together,
+// each of them exactly once.
+internal void
+TestWorldQueryRangesCoverQuery()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    world *world_ = gameState->world;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+
+    game_memory *gameMemory = &memory.gameMemory;
+    memory_arena tranArena;
+    InitializeArena(&tranArena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+
+    // NOTE : Packed in the middle, and a few far away so that the query also takes the occupied list
+    test_series series = {1234};
+    for(uint32 wallIndex = 0;
+        wallIndex < 3000;
+        ++wallIndex)
+    {
+        int32 tileRadius = (wallIndex % 10) ? 40 : 2000;
+        int32 tileX = (int32)(NextTestRandom(&series) % (uint32)(2*tileRadius)) - tileRadius;
+        int32 tileY = (int32)(NextTestRandom(&series) % (uint32)(2*tileRadius)) - tileRadius;
+        int32 tileZ = (int32)(NextTestRandom(&series) % 3) - 1;
+        AddWall(gameState, tileX, tileY, tileZ);
+    }
+
+    uint32 lowEntityCount = gameState->lowEntities.count;
+    uint32 *wholeCounts = PushArray(&tranArena, lowEntityCount, uint32);
+    uint32 *rangeCounts = PushArray(&tranArena, lowEntityCount, uint32);
+    uint32 queryEntityCount = 0;
+    uint32 wrongCount = 0;
+    for(uint32 queryIndex = 0;
+        queryIndex < 40;
+        ++queryIndex)
+    {
+        world_position origin = TilePositionToChunkPosition(&gameState->worldGen, 0, 0, 0);
+        real32 radius = (queryIndex & 1) ? TestRandomBetween(&series, 5.0f, 80.0f) : TestRandomBetween(&series, 500.0f, 3000.0f);
+        rect3 bounds = RectCenterDim(V3(TestRandomBetween(&series, -30.0f, 30.0f), TestRandomBetween(&series, -30.0f, 30.0f), 0.0f),
+                                    V3(2.0f*radius, 2.0f*radius, TestRandomBetween(&series, 1.0f, 12.0f)));
+
+        temporary_memory queryMemory = BeginTemporaryMemory(&tranArena);
+        world_query query = BeginWorldQuery(world_, &tranArena, origin, bounds);
+        ZeroSize(lowEntityCount*sizeof(uint32), wholeCounts);
+        for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query));
+            IsValid(&iter);
+            Advance(&iter))
+        {
+            ++wholeCounts[iter.lowEntityIndex];
+            ++queryEntityCount;
+        }
+
+        uint32 rangeCount = 1 + queryIndex % 7;
+        ZeroSize(lowEntityCount*sizeof(uint32), rangeCounts);
+        for(uint32 rangeIndex = 0;
+            rangeIndex < rangeCount;
+            ++rangeIndex)
+        {
+            for(world_query_iterator iter = IterateWorldQuery(&query, GetWorldQueryRange(&query, rangeIndex, rangeCount));
+                IsValid(&iter);
+                Advance(&iter))
+            {
+                ++rangeCounts[iter.lowEntityIndex];
+            }
+        }
+
+        for(uint32 lowIndex = 0;
+            lowIndex < lowEntityCount;
+            ++lowIndex)
+        {
+            wrongCount += (wholeCounts[lowIndex] > 1 || rangeCounts[lowIndex] != wholeCounts[lowIndex]);
+        }
+        EndTemporaryMemory(queryMemory);
+    }
+    Expect(queryEntityCount > 0);
+    Expect(wrongCount == 0);
+
+    EndTestMemory(&memory);
+}
+
+// NOTE : Count and the sum of the hashes of the walls that are in memory and inside the bounds,
+// so that the same walls give the same sum in any slots and in any order.
+struct test_wall_sum
+{
+    uint32 count;
+    uint64 sum;
+};
+
+internal test_wall_sum
+SumTestWalls(game_state *gameState, world_position origin, rect3 bounds)
+{
+    test_wall_sum result = {};
+    for(uint32 lowIndex = 1;
+        lowIndex < gameState->lowEntities.count;
+        ++lowIndex)
+    {
+        low_entity *low = GetLowEntity(gameState, lowIndex);
+        if(low->type == EntityType_Wall && low->block)
+        {
+            v3 pos = SubstractTwoWMP(gameState->world, &low->pos, &origin);
+            if(IsInRectangle(bounds, pos))
+            {
+                uint32 values[] =
+                {
+                    (uint32)low->pos.chunkX, (uint32)low->pos.chunkY, (uint32)low->pos.chunkZ,
+                    *(uint32 *)&low->pos.offset_.x, *(uint32 *)&low->pos.offset_.y, *(uint32 *)&low->pos.offset_.z,
+                };
+                uint64 hash = 0xcbf29ce484222325ull;
+                for(uint32 valueIndex = 0;
+                    valueIndex < ArrayCount(values);
+                    ++valueIndex)
+                {
+                    hash ^= values[valueIndex];
+                    hash *= 0x100000001b3ull;
+                }
+
+                ++result.count;
+                result.sum += hash;
+            }
+        }
+    }
+
+    return result;
+}
+
+// NOTE : The hero walks to the far end of a long row of walls and back, with the streaming on the work queue.
+// The walls are added just ahead of the hero on the way out, like the world gen does,
+// so the world ends up much bigger than what the world arena is allowed to commit.
+// Everything behind the hero should go out of memory, and come back the same when the hero does.
+// The streaming should never have to wait for the page jobs once the walk is going,
+// because the prefetch had started them frames before.
+internal void
+TestHeroWalkPagesChunks()
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    world *world_ = gameState->world;
+    gameState->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+    gameState->swordCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 0.1f);
+    gameState->playerCollision = MakeSimpleGroundedCollision(gameState, 1.0f, 0.5f, 1.2f);
+
+    platform_work_queue *workQueue = GetTestWorkQueue();
+
+    platform_file_handle pageFile = LinuxOpenPageFile(&memory.thread, "fox_test.page");
+    Expect(pageFile.noErrors);
+    InitializeWorldStreaming(world_, pageFile, LinuxReadPageFile, LinuxWritePageFile);
+    memory_index emptyCommitted = gameState->worldArena.committed;
+
+    // NOTE : The walls behind and ahead of the start, which are compared after the walk
+    int32 wallCountX = 2000;
+    int32 wallCountY = 4;
+    int32 addedCountX = 0;
+    int32 addAheadCountX = 50;
+    for(;
+        addedCountX < addAheadCountX;
+        ++addedCountX)
+    {
+        for(int32 tileY = 0;
+            tileY < wallCountY;
+            ++tileY)
+        {
+            AddWall(gameState, addedCountX, tileY, 0);
+        }
+    }
+
+    gameState->cameraPos = TilePositionToChunkPosition(&gameState->worldGen, 0, 6, 0);
+    add_low_entity_result hero = AddPlayer(gameState);
+
+    // NOTE : Same bounds as the streaming of the game, with the 960x540 screen
+    rect3 streamBounds = RectCenterDim(V3(0, 0, 0), V3(960.0f / 42.0f, 540.0f / 42.0f, 0.0f));
+    streamBounds.min.z = -3.0f*gameState->typicalFloorHeight;
+    streamBounds.max.z = 1.0f*gameState->typicalFloorHeight;
+    streamBounds = GetSimRegionGatherBounds(AddRadiusToRect(streamBounds, V3(15.0f, 15.0f, 0.0f)), 
+                                            gameState->simStepDt);
+
+    world_position start = hero.low->pos;
+    rect3 startBounds = RectMinMax(V3(-10.0f, -20.0f, -1.0f), V3(60.0f, 20.0f, 1.0f));
+    test_wall_sum startWalls = SumTestWalls(gameState, start, startBounds);
+
+    // NOTE : What the world arena can commit on top of the empty world, 
+    // for the chunks around the hero and the page records of the whole strip.
+    // The walls of the whole strip don't fit in this.
+    memory_index committedBudget = Kilobytes(512);
+    Expect((memory_index)wallCountX*wallCountY*sizeof(low_entity) > committedBudget);
+    memory_index maxCommitted = 0;
+
+    // NOTE : Enough steps for the streaming to page in everything around the start
+    uint32 warmStepCount = 20;
+    uint32 warmWaitCount = 0;
+
+    real32 walkDistance = 1.4f*(real32)wallCountX;
+    uint32 stepCount = (uint32)walkDistance;
+    for(uint32 stepIndex = 0;
+        stepIndex < 2*stepCount;
+        ++stepIndex)
+    {
+        real32 stepX = (stepIndex < stepCount) ? 1.0f : -1.0f;
+        ChangeEntityLocation(world_, &gameState->lowEntities, hero.lowIndex,
+                            MapIntoChunkSpace(world_, hero.low->pos, V3(stepX, 0.0f, 0.0f)));
+        if(stepIndex < stepCount)
+        {
+            int32 heroTileX = (int32)((real32)(stepIndex + 1) / 1.4f);
+            for(;
+                addedCountX < Minimum(heroTileX + addAheadCountX, wallCountX);
+                ++addedCountX)
+            {
+                for(int32 tileY = 0;
+                    tileY < wallCountY;
+                    ++tileY)
+                {
+                    AddWall(gameState, addedCountX, tileY, 0);
+                }
+            }
+        }
+        UpdateWorldStreaming(&memory.thread, gameState, workQueue, hero.low->pos, streamBounds);
+
+        // NOTE : The rest of the frame, which is always long enough for the jobs that were started
+        LinuxCompleteAllWork(&memory.thread, workQueue);
+
+        if(stepIndex == warmStepCount)
+        {
+            warmWaitCount = world_->blockingPageWaitCount;
+        }
+        maxCommitted = Maximum(maxCommitted, gameState->worldArena.committed - emptyCommitted);
+
+        if(stepIndex == stepCount - 1)
+        {
+            // NOTE : Only the walls around the hero are in memory, in the slots that the others gave back
+            Expect(addedCountX == wallCountX);
+            Expect(world_->pagedOutChunkCount > 0);
+            Expect(SumTestWalls(gameState, start, startBounds).count == 0);
+            Expect(gameState->lowEntities.firstFree != 0);
+        }
+    }
+    LinuxCompleteAllWork(&memory.thread, workQueue);
+    FinishWorldPageJobs(gameState);
+
+    Expect(world_->blockingPageWaitCount == warmWaitCount);
+    Expect(maxCommitted < committedBudget);
+
+    test_wall_sum endWalls = SumTestWalls(gameState, start, startBounds);
+    Expect(endWalls.count == startWalls.count);
+    Expect(endWalls.sum == startWalls.sum);
+    Expect(world_->pagedOutChunkCount > 0);
+    Expect(IsValid(gameState, hero.handle));
+    Expect(IsValid(gameState, hero.low->payload.hero.sword));
+
+    EndTestMemory(&memory);
+}
+
+struct test_world_gen_result
+{
+    uint64 checksum;
+    // NOTE : Over every frame, so that it also catches the regions going in at the other frame
+    uint64 worldChecksum;
+    uint32 lowEntityCount;
+};
+
+// NOTE : Generates the rooms around the center like the game does, for a few frames while the center moves.
+// Nothing waits for the jobs between the frames, so with the queue they get done whenever the workers get to them.
+internal test_world_gen_result
+GenerateTestWorld(platform_work_queue *queue)
+{
+    test_memory memory;
+    BeginTestMemory(&memory, Gigabytes(1), Gigabytes(1));
+    game_state *gameState = BeginTestGameState(&memory);
+    game_memory *gameMemory = &memory.gameMemory;
+
+    memory_arena tranArena;
+    InitializeArena(&tranArena, (memory_index)gameMemory->transientStorageSize, gameMemory->transientStorage,
+                    gameMemory->platformCommitMemory, gameMemory->platformDecommitMemory);
+    transient_state *tranState = PushStruct(&tranArena, transient_state);
+
+    world_gen *gen = &gameState->worldGen;
+    gen->wallCollision = MakeSimpleGroundedCollision(gameState, 1.4f, 1.4f, 1.5f);
+    gen->standardRoomCollision = MakeSimpleGroundedCollision(gameState, 14.0f, 14.0f, 2.7f);
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(tranState->worldGenJobs);
+        ++jobIndex)
+    {
+        world_gen_job *job = tranState->worldGenJobs + jobIndex;
+        InitializeWorldGenRegion(gen, &job->region, &tranArena);
+    }
+
+    test_world_gen_result result = {};
+    world_position center = TilePositionToChunkPosition(gen, 0, 0, 0);
+    rect3 bounds = RectCenterDim(V3(0, 0, 0), V3(300.0f, 300.0f, 0.0f));
+    uint32 frameCount = 12;
+    for(uint32 frameIndex = 0;
+        frameIndex < frameCount;
+        ++frameIndex)
+    {
+        UpdateWorldGen(&memory.thread, gameState, tranState, queue, center, bounds);
+        result.worldChecksum = 
+            31*result.worldChecksum + GetWorldChecksum(gameState->world, &gameState->lowEntities);
+        center = MapIntoChunkSpace(gameState->world, center, V3(60.0f, 25.0f, 0.0f));
+    }
+    FinishWorldGenJobs(&memory.thread, gameState, tranState, queue);
+    result.worldChecksum = 31*result.worldChecksum + GetWorldChecksum(gameState->world, &gameState->lowEntities);
+
+    result.checksum = gen->checksum;
+    result.lowEntityCount = gameState->lowEntities.count;
+
+    EndTestMemory(&memory);
+
+    return result;
+}
+
+// NOTE : The world should come out the same whether the regions were made on this thread or on the workers,
+// down to the slots of the entities.
+internal void
+TestWorldGenSameOnWorkQueue()
+{
+    test_world_gen_result single = GenerateTestWorld(0);
+    test_world_gen_result queued = GenerateTestWorld(GetTestWorkQueue());
+
+    Expect(single.checksum != 0);
+    Expect(single.lowEntityCount > 1);
+    Expect(queued.checksum == single.checksum);
+    Expect(queued.worldChecksum == single.worldChecksum);
+    Expect(queued.lowEntityCount == single.lowEntityCount);
+}
+
+//
+// NOTE : Runner
+//
+
+typedef void test_function();
+struct test_case
+{
+    char *name;
+    test_function *function;
+};
+
+#define TEST_CASE(function) {#function, function}
+global_variable test_case testCases[] =
+{
+    TEST_CASE(TestArenaCommitAndDecommit),
+    TEST_CASE(TestGameRunsOnReservedMemory),
+    TEST_CASE(TestCollisionRulesGrow),
+    TEST_CASE(TestSimEntityHashResizes),
+    TEST_CASE(TestWallTestMatchesScalar),
+    TEST_CASE(TestSleepingEntitiesAreLeftOut),
+    TEST_CASE(TestSimEntitiesMoveWhenGrown),
+    TEST_CASE(TestEntityBoundsCullIsConservative),
+    TEST_CASE(TestWorldQueryRangesCoverQuery),
+    TEST_CASE(TestHeroWalkPagesChunks),
+    TEST_CASE(TestWorldGenSameOnWorkQueue),
+};
+
+int
+main(int argc, char **argv)
+{
+    uint32 failedTestCount = 0;
+    for(uint32 testIndex = 0;
+        testIndex < ArrayCount(testCases);
+        ++testIndex)
+    {
+        test_case *test = testCases + testIndex;
+        // NOTE : Only run the tests that have the argument in their name
+        if(argc > 1 && !strstr(test->name, argv[1]))
+        {
+            continue;
+        }
+
+        uint32 oldFailCount = globalExpectFailCount;
+        test->function();
+        bool32 passed = (globalExpectFailCount == oldFailCount);
+        printf("%s %s\n", passed ? "PASSED" : "FAILED", test->name);
+        if(!passed)
+        {
+            ++failedTestCount;
+        }
+    }
+
+    return (failedTestCount == 0) ? 0 : 1;
+}
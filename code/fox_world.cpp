@@ -101,7 +101,96 @@ MapIntoChunkSpace(world *world, world_position basePos, v3 offset)
     return result;
 }
 
+#define INITIAL_WORLD_CHUNK_HASH_COUNT 4096
+
+inline uint32
+GetWorldChunkHashHomeSlot(world *world_, int32 chunkX, int32 chunkY, int32 chunkZ)
+{
+    uint32 result = HashUInt32Triple((uint32)chunkX, (uint32)chunkY, (uint32)chunkZ) & (world_->chunkHashMaxCount - 1);
+    return result;
+}
+
+// NOTE : The chunk should not be in the table already!
+internal void
+InsertWorldChunkHash(world *world_, world_chunk *chunk)
+{
+    uint32 hashMask = world_->chunkHashMaxCount - 1;
+    uint32 slot = GetWorldChunkHashHomeSlot(world_, chunk->chunkX, chunk->chunkY, chunk->chunkZ);
+    while(world_->chunkHash[slot].chunk)
+    {
+        slot = (slot + 1) & hashMask;
+    }
+
+    world_chunk_hash_slot *entry = world_->chunkHash + slot;
+    entry->chunkX = chunk->chunkX;
+    entry->chunkY = chunk->chunkY;
+    entry->chunkZ = chunk->chunkZ;
+    entry->chunk = chunk;
+}
+
+// NOTE : Linear probing can't just empty the slot of the chunk, 
+// because the chunks after it would not be found anymore.
+// So the ones that can go back into the hole are moved there, until we hit the empty slot.
+internal void
+RemoveWorldChunkHash(world *world_, world_chunk *chunk)
+{
+    uint32 hashMask = world_->chunkHashMaxCount - 1;
+    uint32 slot = GetWorldChunkHashHomeSlot(world_, chunk->chunkX, chunk->chunkY, chunk->chunkZ);
+    while(world_->chunkHash[slot].chunk != chunk)
+    {
+        Assert(world_->chunkHash[slot].chunk);
+        slot = (slot + 1) & hashMask;
+    }
+
+    uint32 holeSlot = slot;
+    for(;;)
+    {
+        slot = (slot + 1) & hashMask;
+        world_chunk_hash_slot *entry = world_->chunkHash + slot;
+        if(!entry->chunk)
+        {
+            break;
+        }
+
+        // NOTE : The entry can only go back to the hole if the hole is not before its home slot
+        uint32 homeSlot = GetWorldChunkHashHomeSlot(world_, entry->chunkX, entry->chunkY, entry->chunkZ);
+        if(((slot - homeSlot) & hashMask) >= ((slot - holeSlot) & hashMask))
+        {
+            world_->chunkHash[holeSlot] = *entry;
+            holeSlot = slot;
+        }
+    }
+
+    world_->chunkHash[holeSlot].chunk = 0;
+}
+
+// NOTE : Throws away the old table and puts every chunk in the world into the new one.
+// The tables come from the same arena as the chunks, because the world only gets bigger.
+// Nobody looks at the old table again, so its pages go back to the platform.
+internal void
+AllocateWorldChunkHash(world *world_, memory_arena *arena, uint32 maxCount)
+{
+    world_chunk_hash_slot *oldHash = world_->chunkHash;
+    memory_index oldSize = world_->chunkHashMaxCount*sizeof(world_chunk_hash_slot);
+
+    world_->chunkHashMaxCount = maxCount;
+    world_->chunkHash = PushArrayZeroed(arena, world_->chunkHashMaxCount, world_chunk_hash_slot);
+    if(oldHash && arena->decommitMemory)
+    {
+        // NOTE : The platform only decommits the pages that are entirely inside
+        arena->decommitMemory(oldHash, oldSize);
+    }
+
+    for(world_chunk *chunk = world_->firstChunk;
+        chunk;
+        chunk = chunk->next)
+    {
+        InsertWorldChunkHash(world_, chunk);
+    }
+}
+
 //Get the chunk
+// If the arena was passed and we don't have the chunk, make a new one.
 internal world_chunk *
 GetWorldChunk(world *world_, int32 chunkX, int32 chunkY, int32 chunkZ,
               memory_arena *arena = 0)
@@ -115,57 +204,74 @@ GetWorldChunk(world *world_, int32 chunkX, int32 chunkY, int32 chunkZ,
     Assert(chunkY < TILE_CHUNK_SAFE_MARGIN);
     Assert(chunkZ < TILE_CHUNK_SAFE_MARGIN);
 
-    // This is our hash function which is totally crappy XD
-    // TODO : Better Hash Function!
-    uint32 hashValue = 19 * chunkX + 7 * chunkY + 3 * chunkZ;
-    // We have to mask it with arraycount so that we can always get number within arraycount boundary
-    uint32 hashSlot = hashValue & (ArrayCount(world_->chunkHash) - 1);
-    Assert(hashSlot < ArrayCount(world_->chunkHash));
+    world_chunk *chunk = 0;
 
-    world_chunk *chunk = world_->chunkHash + hashSlot;
-    do
+    uint32 hashMask = world_->chunkHashMaxCount - 1;
+    uint32 slot = GetWorldChunkHashHomeSlot(world_, chunkX, chunkY, chunkZ);
+    for(;;)
     {
-        if (chunkX == chunk->chunkX &&
-            chunkY == chunk->chunkY &&
-            chunkZ == chunk->chunkZ)
+        world_chunk_hash_slot *entry = world_->chunkHash + slot;
+        if(!entry->chunk)
         {
+            // NOTE : Empty slot, so the chunk is not in here
+            break;
+        }
+        else if(entry->chunkX == chunkX &&
+                entry->chunkY == chunkY &&
+                entry->chunkZ == chunkZ)
+        {
+            chunk = entry->chunk;
             break;
         }
 
-        // This means the hash slot is not initiallized
-        // because rememeber : the game doesn't allow position that is
-        // smaller than TILE_CHUNK_SAFE_MARGIN
+        slot = (slot + 1) & hashMask;
+    }
 
-        // The slot is occupied, but the nextinhash is empty
-        // So we need to create new one
-        if (arena && chunk->chunkX != TILE_CHUNK_UNINITIALIZED && !chunk->nextInHash)
+    if(!chunk && arena)
+    {
+        chunk = world_->firstFreeChunk;
+        if(chunk)
         {
-            chunk->nextInHash = PushStruct(arena, world_chunk);
-            chunk = chunk->nextInHash;
-            // The tile chunk that we newly created should be 0
-            // So that we can know that it's not initialized
-            chunk->chunkX = TILE_CHUNK_UNINITIALIZED;
+            world_->firstFreeChunk = chunk->next;
         }
-
-        // If we have created a new chunk on the upper side,
-        // this if statement must be excuted
-        // This if statements means we have new tile chunk
-        // but it's not initialized
-        if (arena && chunk->chunkX == TILE_CHUNK_UNINITIALIZED)
+        else
         {
-            // Store the coordinates
-            chunk->chunkX = chunkX;
-            chunk->chunkY = chunkY;
-            chunk->chunkZ = chunkZ;
-
-            chunk->nextInHash = 0;
+            chunk = PushStruct(arena, world_chunk);
+        }
+        chunk->chunkX = chunkX;
+        chunk->chunkY = chunkY;
+        chunk->chunkZ = chunkZ;
+        chunk->firstBlock = 0;
+        chunk->nextOccupied = 0;
+        chunk->prevOccupied = 0;
+        chunk->isLowSimQueued = false;
+        chunk->nextLowSim = 0;
 
-            break;
+        chunk->prev = 0;
+        chunk->next = world_->firstChunk;
+        if(chunk->next)
+        {
+            chunk->next->prev = chunk;
         }
+        world_->firstChunk = chunk;
+        ++world_->chunkCount;
 
-        // If all of those if fails, just check the next one in hash
-        chunk = chunk->nextInHash;
-    } while (chunk);
+        // Keep the load under 1/2, because most of the lookups are for the chunks 
+        // that are not there(empty space around the camera), which have to probe until the empty slot.
+        if(world_->chunkCount*2 > world_->chunkHashMaxCount)
+        {
+            AllocateWorldChunkHash(world_, arena, 2*world_->chunkHashMaxCount);
+        }
+        else
+        {
+            // NOTE : slot is the empty slot where the search has ended
+            world_chunk_hash_slot *entry = world_->chunkHash + slot;
+            entry->chunkX = chunkX;
+            entry->chunkY = chunkY;
+            entry->chunkZ = chunkZ;
+            entry->chunk = chunk;
+        }
+    }
 
     return chunk;
 }
@@ -205,19 +311,58 @@ CenteredChunkPoint(world_chunk *chunk)
 
 
 internal void
-InitializeWorld(world *world, v3 chunkDimInMeters)
+InitializeWorld(world *world, memory_arena *arena, v3 chunkDimInMeters)
 {
+    world->arena = arena;
     world->chunkDimInMeters = chunkDimInMeters;
     // Because we don't have any entity block
     world->firstFree = 0;
 
-    for (uint32 chunkIndex = 0;
-         chunkIndex < ArrayCount(world->chunkHash);
-         ++chunkIndex)
+    world->chunkCount = 0;
+    world->firstChunk = 0;
+    world->firstFreeChunk = 0;
+    world->occupiedChunkCount = 0;
+    world->firstOccupiedChunk = 0;
+    ZeroSize(sizeof(world->occupancyHash), world->occupancyHash);
+    world->chunkHash = 0;
+    world->chunkHashMaxCount = 0;
+    AllocateWorldChunkHash(world, arena, INITIAL_WORLD_CHUNK_HASH_COUNT);
+
+    world->pageFile = {};
+    world->readPageFile = 0;
+    world->writePageFile = 0;
+    world->pageFileSize = 0;
+    ZeroSize(sizeof(world->pageHash), world->pageHash);
+    ZeroSize(sizeof(world->freeHoles), world->freeHoles);
+    world->firstFreeHole = 0;
+    world->pagedOutChunkCount = 0;
+    world->blockingPageWaitCount = 0;
+    ZeroSize(sizeof(world->pageJobs), world->pageJobs);
+    world->streamCenter = NullPosition();
+    world->hasPendingPageIns = false;
+    world->evictCursor = 0;
+
+    world->lowSimChunkCount = 0;
+    world->firstLowSimChunk = 0;
+    world->lastLowSimChunk = 0;
+}
+
+internal void
+InitializeWorldStreaming(world *world, platform_file_handle pageFile,
+                        platform_read_page_file *readPageFile, platform_write_page_file *writePageFile)
+{
+    world->pageFile = pageFile;
+    world->readPageFile = readPageFile;
+    world->writePageFile = writePageFile;
+
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(world->pageJobs);
+        ++jobIndex)
     {
-        world_chunk *chunk = world->chunkHash + chunkIndex;
-        chunk->chunkX = TILE_CHUNK_UNINITIALIZED;
-        chunk->firstBlock.entityCount = 0;
+        world_page_job *job = world->pageJobs + jobIndex;
+        job->world = world;
+        job->page = 0;
+        job->memory = (uint8 *)PushSizeAligned(world->arena, (memory_index)1 << WORLD_PAGE_MAX_SIZE_SHIFT, 8);
     }
 }
 
@@ -231,18 +376,335 @@ InitializeWorld(world *world, v3 chunkDimInMeters)
 // TODO : If this moves an entity into the camera bounds, 
 // should it automatically go into the high set immdeiately?
 // because for now, the changed entity will go into the high set in next frame, not this frame
+// NOTE : Every low entity remembers where it is in the entity blocks,
+// so that we don't have to search the whole chunk to remove it.
+// Whenever an index moves inside or between the blocks, this should be called.
+inline void
+StoreEntityBlockSlot(low_entity_storage *lowEntities, world_entity_block *block, uint32 slot)
+{
+    low_entity *low = GetLowEntity(lowEntities, block->lowEntityIndexes[slot]);
+    low->block = block;
+    low->blockSlot = (uint8)slot;
+}
+
+// NOTE : pos is where the entity will be, which might not be in the low entity yet.
+inline void
+StoreEntityBlockBounds(world_entity_block *block, uint32 slot, 
+                        world_position *pos, sim_entity_collision_volume_group *collision)
+{
+    sim_entity_collision_volume volume = collision->totalVolume;
+    v3 center = WORLD_ENTITY_BOUNDS_POS_SCALE*(pos->offset_ + volume.offset);
+    real32 radius = WORLD_ENTITY_BOUNDS_RADIUS_SCALE*0.5f*Maximum(Maximum(volume.dim.x, volume.dim.y), volume.dim.z);
+
+    block->boundsX[slot] = 0;
+    block->boundsY[slot] = 0;
+    block->boundsZ[slot] = 0;
+    block->boundsRadius[slot] = WORLD_ENTITY_BOUNDS_UNKNOWN_RADIUS;
+    if(AbsoluteValue(center.x) < 32767.0f && 
+        AbsoluteValue(center.y) < 32767.0f && 
+        AbsoluteValue(center.z) < 32767.0f &&
+        radius < (real32)WORLD_ENTITY_BOUNDS_UNKNOWN_RADIUS)
+    {
+        block->boundsX[slot] = (int16)RoundReal32ToInt32(center.x);
+        block->boundsY[slot] = (int16)RoundReal32ToInt32(center.y);
+        block->boundsZ[slot] = (int16)RoundReal32ToInt32(center.z);
+        block->boundsRadius[slot] = (uint8)CeilReal32ToInt32(radius);
+    }
+}
+
+// NOTE : Moves the index and the bounds together. 
+// The low entity of the moved index should be told with StoreEntityBlockSlot.
+inline void
+CopyEntityBlockSlot(world_entity_block *dest, uint32 destSlot, world_entity_block *source, uint32 sourceSlot)
+{
+    dest->lowEntityIndexes[destSlot] = source->lowEntityIndexes[sourceSlot];
+    dest->boundsX[destSlot] = source->boundsX[sourceSlot];
+    dest->boundsY[destSlot] = source->boundsY[sourceSlot];
+    dest->boundsZ[destSlot] = source->boundsZ[sourceSlot];
+    dest->boundsRadius[destSlot] = source->boundsRadius[sourceSlot];
+}
+
+// NOTE : The query bounds are relative to origin, and the test is relative to the center of the chunk.
+// The test is grown by two quanta on each side, one for the truncation and one for the rounding,
+// so it never throws out an entity that EntityOverlapsRectangle would keep.
+internal world_entity_bounds_test
+GetEntityBoundsTest(world *world_, world_chunk *chunk, world_position origin, rect3 bounds)
+{
+    world_position chunkCenter = CenteredChunkPoint(chunk->chunkX, chunk->chunkY, chunk->chunkZ);
+    v3 chunkDelta = SubstractTwoWMP(world_, &chunkCenter, &origin);
+    v3 min = WORLD_ENTITY_BOUNDS_POS_SCALE*(bounds.min - chunkDelta);
+    v3 max = WORLD_ENTITY_BOUNDS_POS_SCALE*(bounds.max - chunkDelta);
+
+    world_entity_bounds_test result;
+    result.minX = TruncateReal32ToInt32(min.x) - 2;
+    result.minY = TruncateReal32ToInt32(min.y) - 2;
+    result.minZ = TruncateReal32ToInt32(min.z) - 2;
+    result.maxX = TruncateReal32ToInt32(max.x) + 2;
+    result.maxY = TruncateReal32ToInt32(max.y) + 2;
+    result.maxZ = TruncateReal32ToInt32(max.z) + 2;
+
+    return result;
+}
+
+// NOTE : If this is false, the entity is surely out. If it's true, it still needs the exact test.
+inline bool32
+EntityBoundsMightOverlap(world_entity_block *block, uint32 slot, world_entity_bounds_test *test)
+{
+    bool32 result = true;
+    uint32 radius = block->boundsRadius[slot];
+    if(radius != WORLD_ENTITY_BOUNDS_UNKNOWN_RADIUS)
+    {
+        int32 grow = (int32)radius*(WORLD_ENTITY_BOUNDS_POS_SCALE / WORLD_ENTITY_BOUNDS_RADIUS_SCALE);
+        int32 x = block->boundsX[slot];
+        int32 y = block->boundsY[slot];
+        int32 z = block->boundsZ[slot];
+        result = (x >= test->minX - grow && x <= test->maxX + grow &&
+                    y >= test->minY - grow && y <= test->maxY + grow &&
+                    z >= test->minZ - grow && z <= test->maxZ + grow);
+    }
+
+    return result;
+}
+
+// If the arena was passed and we don't have the block, make a new one.
+internal world_occupancy_block *
+GetWorldOccupancyBlock(world *world_, int32 blockX, int32 blockY, int32 chunkZ,
+                        memory_arena *arena = 0)
+{
+    uint32 hashSlot = HashUInt32Triple((uint32)blockX, (uint32)blockY, (uint32)chunkZ) & 
+                        (ArrayCount(world_->occupancyHash) - 1);
+
+    world_occupancy_block *block = 0;
+    for(world_occupancy_block *test = world_->occupancyHash[hashSlot];
+        test;
+        test = test->nextInHash)
+    {
+        if(test->blockX == blockX && test->blockY == blockY && test->chunkZ == chunkZ)
+        {
+            block = test;
+            break;
+        }
+    }
+
+    if(!block && arena)
+    {
+        block = PushStructZeroed(arena, world_occupancy_block);
+        block->blockX = blockX;
+        block->blockY = blockY;
+        block->chunkZ = chunkZ;
+
+        block->nextInHash = world_->occupancyHash[hashSlot];
+        world_->occupancyHash[hashSlot] = block;
+    }
+
+    return block;
+}
+
+// NOTE : The arena is only needed when the chunk becomes occupied.
+internal void
+SetChunkOccupancy(world *world_, world_chunk *chunk, bool32 occupied, memory_arena *arena = 0)
+{
+    world_occupancy_block *block = 
+        GetWorldOccupancyBlock(world_, 
+                                chunk->chunkX >> WORLD_OCCUPANCY_BLOCK_SHIFT,
+                                chunk->chunkY >> WORLD_OCCUPANCY_BLOCK_SHIFT,
+                                chunk->chunkZ, arena);
+    Assert(block);
+
+    uint32 localX = (uint32)chunk->chunkX & WORLD_OCCUPANCY_BLOCK_MASK;
+    uint32 localY = (uint32)chunk->chunkY & WORLD_OCCUPANCY_BLOCK_MASK;
+    uint32 wordIndex = 8*(localY >> 3) + (localX >> 3);
+    uint64 bit = (uint64)1 << (8*(localY & 7) + (localX & 7));
+
+    uint64 *word = block->words + wordIndex;
+    if(occupied)
+    {
+        *word |= bit;
+        block->summary |= ((uint64)1 << wordIndex);
+    }
+    else
+    {
+        *word &= ~bit;
+        if(*word == 0)
+        {
+            block->summary &= ~((uint64)1 << wordIndex);
+        }
+    }
+}
+
+// NOTE : These should be called when the first entity comes into the chunk,
+// and when the last entity leaves the chunk.
+inline void
+MarkChunkOccupied(world *world_, world_chunk *chunk, memory_arena *arena)
+{
+    Assert(!chunk->prevOccupied && world_->firstOccupiedChunk != chunk);
+
+    SetChunkOccupancy(world_, chunk, true, arena);
+
+    chunk->prevOccupied = 0;
+    chunk->nextOccupied = world_->firstOccupiedChunk;
+    if(chunk->nextOccupied)
+    {
+        chunk->nextOccupied->prevOccupied = chunk;
+    }
+    world_->firstOccupiedChunk = chunk;
+    ++world_->occupiedChunkCount;
+}
+
+inline void
+MarkChunkEmpty(world *world_, world_chunk *chunk)
+{
+    Assert(chunk->prevOccupied || world_->firstOccupiedChunk == chunk);
+
+    SetChunkOccupancy(world_, chunk, false);
+
+    if(chunk->prevOccupied)
+    {
+        chunk->prevOccupied->nextOccupied = chunk->nextOccupied;
+    }
+    else
+    {
+        world_->firstOccupiedChunk = chunk->nextOccupied;
+    }
+
+    if(chunk->nextOccupied)
+    {
+        chunk->nextOccupied->prevOccupied = chunk->prevOccupied;
+    }
+
+    chunk->nextOccupied = 0;
+    chunk->prevOccupied = 0;
+    --world_->occupiedChunkCount;
+}
+
+// NOTE : Awake entities outside the sim region are moved by the low frequency update.
+// Walls and the other things that never move are never awake.
+inline bool32
+IsLowSimAwake(low_entity *low)
+{
+    bool32 result = (IsSet(low, EntityFlag_Movable) && 
+                    !IsSet(low, EntityFlag_Sleeping) && 
+                    !IsSet(low, EntityFlag_Nonspatial));
+    return result;
+}
+
 inline void
-ChangeEntityLocationRaw(memory_arena *arena, world *world_, uint32 lowEntityIndex,
+QueueChunkForLowSim(world *world_, world_chunk *chunk)
+{
+    if(!chunk->isLowSimQueued)
+    {
+        chunk->isLowSimQueued = true;
+        chunk->nextLowSim = 0;
+        if(world_->lastLowSimChunk)
+        {
+            world_->lastLowSimChunk->nextLowSim = chunk;
+        }
+        else
+        {
+            world_->firstLowSimChunk = chunk;
+        }
+        world_->lastLowSimChunk = chunk;
+        ++world_->lowSimChunkCount;
+    }
+}
+
+inline world_chunk *
+PopLowSimChunk(world *world_)
+{
+    world_chunk *chunk = world_->firstLowSimChunk;
+    if(chunk)
+    {
+        world_->firstLowSimChunk = chunk->nextLowSim;
+        if(!world_->firstLowSimChunk)
+        {
+            world_->lastLowSimChunk = 0;
+        }
+
+        chunk->isLowSimQueued = false;
+        chunk->nextLowSim = 0;
+        --world_->lowSimChunkCount;
+    }
+
+    return chunk;
+}
+
+// NOTE : The new block is empty, and points at nothing.
+internal world_entity_block *
+AllocateEntityBlock(world *world_)
+{
+    world_entity_block *block = world_->firstFree;
+    if (block)
+    {
+        // If there was a firstfree block,
+        //  make the firstfree to the next because we're about to use this block
+        world_->firstFree = block->next;
+    }
+    else
+    {
+        // If there was not firstfree block,
+        // make a new one
+        block = PushStruct(world_->arena, world_entity_block);
+    }
+    block->entityCount = 0;
+    block->next = 0;
+
+    return block;
+}
+
+inline void
+FreeEntityBlock(world *world_, world_entity_block *block)
+{
+    block->next = world_->firstFree;
+    world_->firstFree = block;
+}
+
+// NOTE : pos should be inside this chunk.
+// This does not touch the pos of the low entity, that's up to the caller.
+internal void
+InsertEntityIntoChunk(world *world_, low_entity_storage *lowEntities, world_chunk *chunk, 
+                    uint32 lowEntityIndex, world_position *pos)
+{
+    Assert(pos->chunkX == chunk->chunkX && pos->chunkY == chunk->chunkY && pos->chunkZ == chunk->chunkZ);
+
+    world_entity_block *firstBlock = chunk->firstBlock;
+    if(!firstBlock)
+    {
+        MarkChunkOccupied(world_, chunk, world_->arena);
+        firstBlock = chunk->firstBlock = AllocateEntityBlock(world_);
+    }
+    else if (firstBlock->entityCount == ArrayCount(firstBlock->lowEntityIndexes))
+    {
+        // NOTE : We're out of room, put a new block in front of the full one,
+        // so that the full one and the slots in it stay where they are.
+        world_entity_block *newBlock = AllocateEntityBlock(world_);
+        newBlock->next = firstBlock;
+        firstBlock = chunk->firstBlock = newBlock;
+    }
+
+    Assert(firstBlock->entityCount < ArrayCount(firstBlock->lowEntityIndexes));
+    uint32 slot = firstBlock->entityCount++;
+    firstBlock->lowEntityIndexes[slot] = lowEntityIndex;
+    StoreEntityBlockBounds(firstBlock, slot, pos, GetLowEntity(lowEntities, lowEntityIndex)->collision);
+    StoreEntityBlockSlot(lowEntities, firstBlock, slot);
+}
+
+inline void
+ChangeEntityLocationRaw(world *world_, low_entity_storage *lowEntities, uint32 lowEntityIndex,
                      world_position *oldPos, world_position *newPos)
 {
     Assert(!oldPos || IsValid(*oldPos));
     Assert(!newPos || IsValid(*newPos));    
 
+    memory_arena *arena = world_->arena;
+
     // 
     if (oldPos && newPos && AreInSameChunk(world_, oldPos, newPos))
     {
         // Leave entity where it is
-        // because they are in same chunk! no need to change it
+        // because they are in same chunk! Only the bounds in the block need to change
+        low_entity *low = GetLowEntity(lowEntities, lowEntityIndex);
+        Assert(low->block && low->block->lowEntityIndexes[low->blockSlot] == lowEntityIndex);
+        StoreEntityBlockBounds(low->block, low->blockSlot, newPos, low->collision);
     }
     else
     {
@@ -262,51 +724,36 @@ ChangeEntityLocationRaw(memory_arena *arena, world *world_, uint32 lowEntityInde
             
             if (oldChunk)
             {
-                // This variable is for double loop break
-                bool32 notFound = true;
+                low_entity *low = GetLowEntity(lowEntities, lowEntityIndex);
+                world_entity_block *block = low->block;
+                uint32 slot = low->blockSlot;
+                Assert(block && block->lowEntityIndexes[slot] == lowEntityIndex);
 
-                // NOTE : Start finding the entity, starting from the firstBlock of the chunk
+                world_entity_block *firstBlock = oldChunk->firstBlock;
 
-                world_entity_block *firstBlock = &oldChunk->firstBlock;
+                // copy the last entity of the first block to the location
+                // where we are about to delete
+                // so that the firstblock has free space
+                CopyEntityBlockSlot(block, slot, firstBlock, --firstBlock->entityCount);
+                if(block->lowEntityIndexes[slot] != lowEntityIndex)
+                {
+                    StoreEntityBlockSlot(lowEntities, block, slot);
+                }
 
-                for (world_entity_block *block = &oldChunk->firstBlock;
-                     block && notFound;
-                     block = block->next)
+                // If there is no entity left in the first block,
+                // the next block(which is full) becomes the first one, and this one is freed.
+                if (firstBlock->entityCount == 0)
                 {
-                    for (uint32 index = 0;
-                         index < block->entityCount && notFound;
-                         ++index)
+                    oldChunk->firstBlock = firstBlock->next;
+                    FreeEntityBlock(world_, firstBlock);
+                    if(!oldChunk->firstBlock)
                     {
-                        // If we find it,
-                        if (block->lowEntityIndexes[index] == lowEntityIndex)
-                        {
-                            // copy the last entity of the first block to the location
-                            // where we are about to delete
-                            // so that the firstblock has free space
-                            block->lowEntityIndexes[index] =
-                                firstBlock->lowEntityIndexes[--firstBlock->entityCount];
-
-                            // If there is no entity left in the first block,
-                            if (firstBlock->entityCount == 0)
-                            {
-                                // if there was nextBlock, copy that to the firstBlock
-                                // and mark the nextBlock to be free
-                                if (firstBlock->next)
-                                {
-                                    world_entity_block *nextBlock = firstBlock->next;
-                                    *firstBlock = *nextBlock;
-
-                                    nextBlock->next = world_->firstFree;
-                                    world_->firstFree = nextBlock;
-                                }
-                            }
-
-                            notFound = false;
-                        }
-
-                        // If we couldn't find it, move to the next entity block
+                        MarkChunkEmpty(world_, oldChunk);
                     }
                 }
+
+                low->block = 0;
+                low->blockSlot = 0;
             }
         }
 
@@ -315,37 +762,7 @@ ChangeEntityLocationRaw(memory_arena *arena, world *world_, uint32 lowEntityInde
         {
             world_chunk *newChunk =
                 GetWorldChunk(world_, newPos->chunkX, newPos->chunkY, newPos->chunkZ, arena);
-            world_entity_block *firstBlock = &newChunk->firstBlock;
-
-            // Check whether the firstBlock of the chunk has room for new entity
-            if (firstBlock->entityCount == ArrayCount(firstBlock->lowEntityIndexes))
-            {
-                // NOTE : We're out of room, get a new block!
-
-                world_entity_block *oldBlock = world_->firstFree;
-                if (oldBlock)
-                {
-                    // If there was a firstfree block,
-                    //  make the firstfree to the next because we're about to use this block
-                    world_->firstFree = oldBlock->next;
-                }
-                else
-                {
-                    // If there was not firstfree block,
-                    // make a new one
-                    oldBlock = PushStruct(arena, world_entity_block);
-                }
-
-                // Make a copy of the first block,
-                // point to it(that's why it's name is oldBlock, not newblock)
-                // and then make the entityCount to 0 so that the firstBlock can accept new entites
-                *oldBlock = *firstBlock;
-                firstBlock->next = oldBlock;
-                firstBlock->entityCount = 0;
-            }
-
-            Assert(firstBlock->entityCount < ArrayCount(firstBlock->lowEntityIndexes));
-            firstBlock->lowEntityIndexes[firstBlock->entityCount++] = lowEntityIndex;
+            InsertEntityIntoChunk(world_, lowEntities, newChunk, lowEntityIndex, newPos);
         }
     }
 }
@@ -353,13 +770,15 @@ ChangeEntityLocationRaw(memory_arena *arena, world *world_, uint32 lowEntityInde
 // This change the block location AND
 // it also moves the position, too.
 internal void
-ChangeEntityLocation(memory_arena *arena, world *world_, low_entity *lowEntity, uint32 lowEntityIndex,
+ChangeEntityLocation(world *world_, low_entity_storage *lowEntities, uint32 lowEntityIndex, 
                     world_position newPosInit)
 {
+    low_entity *lowEntity = GetLowEntity(lowEntities, lowEntityIndex);
+
     world_position *oldPos = 0; 
     world_position *newPos = 0;
     
-    if(!IsSet(&lowEntity->sim, EntityFlag_Nonspatial) && IsValid(lowEntity->pos))
+    if(!IsSet(lowEntity, EntityFlag_Nonspatial) && IsValid(lowEntity->pos))
     {
         oldPos = &lowEntity->pos;
     }
@@ -369,16 +788,585 @@ ChangeEntityLocation(memory_arena *arena, world *world_, low_entity *lowEntity,
         newPos = &newPosInit;
     }
 
-    ChangeEntityLocationRaw(arena, world_, lowEntityIndex, oldPos, newPos);
+    ChangeEntityLocationRaw(world_, lowEntities, lowEntityIndex, oldPos, newPos);
 
     if(newPos)
     {
         lowEntity->pos = *newPos;
-        ClearFlags(&lowEntity->sim, EntityFlag_Nonspatial);
+        ClearFlags(lowEntity, EntityFlag_Nonspatial);
     }
     else
     {
         lowEntity->pos = NullPosition();
-        AddFlags(&lowEntity->sim, EntityFlag_Nonspatial);        
+        AddFlags(lowEntity, EntityFlag_Nonspatial);        
     }
-}
\ No newline at end of file
+}
+
+inline uint32
+GetChunkEntityCount(world_chunk *chunk)
+{
+    uint32 result = 0;
+    for(world_entity_block *block = chunk->firstBlock;
+        block;
+        block = block->next)
+    {
+        result += block->entityCount;
+    }
+
+    return result;
+}
+
+// NOTE : FNV-1a over every chunk in the order of the chunk list, and every slot in the order of the blocks.
+// Unlike the checksum of the world gen, this changes if the same entities went into the other slots,
+// so two worlds only match if they were put together in the same order.
+internal uint64
+GetWorldChecksum(world *world_, low_entity_storage *lowEntities)
+{
+    uint64 checksum = 0xcbf29ce484222325ull;
+    for(world_chunk *chunk = world_->firstChunk;
+        chunk;
+        chunk = chunk->next)
+    {
+        uint32 chunkValues[] = {(uint32)chunk->chunkX, (uint32)chunk->chunkY, (uint32)chunk->chunkZ};
+        for(uint32 valueIndex = 0;
+            valueIndex < ArrayCount(chunkValues);
+            ++valueIndex)
+        {
+            checksum ^= chunkValues[valueIndex];
+            checksum *= 0x100000001b3ull;
+        }
+
+        for(world_entity_block *block = chunk->firstBlock;
+            block;
+            block = block->next)
+        {
+            for(uint32 slot = 0;
+                slot < block->entityCount;
+                ++slot)
+            {
+                uint32 lowIndex = block->lowEntityIndexes[slot];
+                low_entity *low = GetLowEntity(lowEntities, lowIndex);
+                uint32 values[] = 
+                {
+                    lowIndex, low->generation, low->type, low->flags,
+                    *(uint32 *)&low->pos.offset_.x, *(uint32 *)&low->pos.offset_.y, *(uint32 *)&low->pos.offset_.z,
+                };
+                for(uint32 valueIndex = 0;
+                    valueIndex < ArrayCount(values);
+                    ++valueIndex)
+                {
+                    checksum ^= values[valueIndex];
+                    checksum *= 0x100000001b3ull;
+                }
+            }
+        }
+    }
+
+    return checksum;
+}
+
+inline bool32
+IsChunkInRange(int32 chunkX, int32 chunkY, int32 chunkZ, 
+                world_position minChunkPos, world_position maxChunkPos, int32 radius)
+{
+    bool32 result = (chunkX >= minChunkPos.chunkX - radius && chunkX <= maxChunkPos.chunkX + radius &&
+                    chunkY >= minChunkPos.chunkY - radius && chunkY <= maxChunkPos.chunkY + radius &&
+                    chunkZ >= minChunkPos.chunkZ - radius && chunkZ <= maxChunkPos.chunkZ + radius);
+    return result;
+}
+
+inline bool32
+IsChunkInRange(world_chunk *chunk, world_position minChunkPos, world_position maxChunkPos, int32 radius)
+{
+    bool32 result = IsChunkInRange(chunk->chunkX, chunk->chunkY, chunk->chunkZ, minChunkPos, maxChunkPos, radius);
+    return result;
+}
+
+//
+// NOTE : World query
+//
+
+inline void
+AddWorldQueryChunk(world_query *query, world_chunk *chunk)
+{
+    query->chunks[query->chunkCount++] = chunk;
+    query->maxEntityCount += GetChunkEntityCount(chunk);
+}
+
+// NOTE : Bits from the first to the last(inclusive) of one byte
+inline uint32
+GetByteBitRangeMask(uint32 first, uint32 last)
+{
+    Assert(first <= last && last < 8);
+    uint32 result = (0xFF << first) & (0xFF >> (7 - last));
+    return result;
+}
+
+inline bool32
+IsWorldQueryChunkBefore(world_chunk *chunkA, world_chunk *chunkB)
+{
+    bool32 result = (chunkA->chunkZ < chunkB->chunkZ ||
+                    (chunkA->chunkZ == chunkB->chunkZ && 
+                        (chunkA->chunkY < chunkB->chunkY ||
+                        (chunkA->chunkY == chunkB->chunkY && chunkA->chunkX < chunkB->chunkX))));
+    return result;
+}
+
+// NOTE : Bottom up merge sort, so that the chunks from the occupancy list
+// come out in the same order as the ones that we looked up one by one
+internal void
+SortWorldQueryChunks(memory_arena *tempArena, world_chunk **chunks, uint32 count)
+{
+    temporary_memory sortMemory = BeginTemporaryMemory(tempArena);
+
+    world_chunk **source = chunks;
+    world_chunk **dest = PushArray(tempArena, count, world_chunk *);
+    for(uint32 width = 1;
+        width < count;
+        width *= 2)
+    {
+        for(uint32 first = 0;
+            first < count;
+            first += 2*width)
+        {
+            uint32 middle = Minimum(first + width, count);
+            uint32 onePastLast = Minimum(first + 2*width, count);
+
+            uint32 readA = first;
+            uint32 readB = middle;
+            for(uint32 writeIndex = first;
+                writeIndex < onePastLast;
+                ++writeIndex)
+            {
+                if(readB >= onePastLast ||
+                    (readA < middle && !IsWorldQueryChunkBefore(source[readB], source[readA])))
+                {
+                    dest[writeIndex] = source[readA++];
+                }
+                else
+                {
+                    dest[writeIndex] = source[readB++];
+                }
+            }
+        }
+
+        world_chunk **temp = source;
+        source = dest;
+        dest = temp;
+    }
+
+    if(source != chunks)
+    {
+        for(uint32 chunkIndex = 0;
+            chunkIndex < count;
+            ++chunkIndex)
+        {
+            chunks[chunkIndex] = source[chunkIndex];
+        }
+    }
+
+    EndTemporaryMemory(sortMemory);
+}
+
+inline uint64
+GetChunkCellCount(world_position minChunkPos, world_position maxChunkPos)
+{
+    uint64 result = (uint64)(maxChunkPos.chunkX - minChunkPos.chunkX + 1) *
+                    (uint64)(maxChunkPos.chunkY - minChunkPos.chunkY + 1) *
+                    (uint64)(maxChunkPos.chunkZ - minChunkPos.chunkZ + 1);
+    return result;
+}
+
+// NOTE : The chunks of the query that go through the bitmap row by row, 
+// which also keeps the chunks in z, y, x order.
+internal void
+AddWorldQueryChunksFromBitmap(world_query *query, memory_arena *arena, 
+                            world_position minChunkPos, world_position maxChunkPos)
+{
+    world *world_ = query->world;
+    int32 minBlockX = minChunkPos.chunkX >> WORLD_OCCUPANCY_BLOCK_SHIFT;
+    int32 maxBlockX = maxChunkPos.chunkX >> WORLD_OCCUPANCY_BLOCK_SHIFT;
+    uint32 blockCountX = (uint32)(maxBlockX - minBlockX + 1);
+    uint64 cellCount = GetChunkCellCount(minChunkPos, maxChunkPos);
+    query->chunks = PushArray(arena, (uint32)Minimum(cellCount, (uint64)world_->occupiedChunkCount), 
+                            world_chunk *);
+
+    temporary_memory blockMemory = BeginTemporaryMemory(arena);
+    world_occupancy_block **blocks = PushArray(arena, blockCountX, world_occupancy_block *);
+    for(int32 chunkZ = minChunkPos.chunkZ;
+        chunkZ <= maxChunkPos.chunkZ;
+        ++chunkZ)
+    {
+        for(int32 chunkY = minChunkPos.chunkY;
+            chunkY <= maxChunkPos.chunkY;
+            ++chunkY)
+        {
+            int32 blockY = chunkY >> WORLD_OCCUPANCY_BLOCK_SHIFT;
+            uint32 localY = (uint32)chunkY & WORLD_OCCUPANCY_BLOCK_MASK;
+            if(chunkY == minChunkPos.chunkY || localY == 0)
+            {
+                // NOTE : Only look up the blocks when we go into the new row of blocks
+                for(uint32 blockIndex = 0;
+                    blockIndex < blockCountX;
+                    ++blockIndex)
+                {
+                    blocks[blockIndex] = 
+                        GetWorldOccupancyBlock(world_, minBlockX + (int32)blockIndex, blockY, chunkZ);
+                }
+            }
+
+            uint32 wordRowShift = 8*(localY >> 3);
+            uint32 bitRowShift = 8*(localY & 7);
+            for(uint32 blockIndex = 0;
+                blockIndex < blockCountX;
+                ++blockIndex)
+            {
+                world_occupancy_block *block = blocks[blockIndex];
+                if(block)
+                {
+                    int32 blockMinChunkX = (minBlockX + (int32)blockIndex) << WORLD_OCCUPANCY_BLOCK_SHIFT;
+                    uint32 localMinX = (uint32)(Maximum(minChunkPos.chunkX, blockMinChunkX) - blockMinChunkX);
+                    uint32 localMaxX = (uint32)(Minimum(maxChunkPos.chunkX, 
+                                                blockMinChunkX + WORLD_OCCUPANCY_BLOCK_MASK) - blockMinChunkX);
+
+                    uint32 wordMask = (uint32)(block->summary >> wordRowShift) & 
+                                        GetByteBitRangeMask(localMinX >> 3, localMaxX >> 3);
+                    while(wordMask)
+                    {
+                        uint32 wordX = FindLeastSignificantSetBit(wordMask).index;
+                        wordMask &= wordMask - 1;
+
+                        uint32 firstX = wordX*8;
+                        uint32 bitMask = (uint32)(block->words[8*(localY >> 3) + wordX] >> bitRowShift) &
+                                        GetByteBitRangeMask((localMinX > firstX) ? (localMinX - firstX) : 0,
+                                                            Minimum(localMaxX - firstX, 7));
+                        while(bitMask)
+                        {
+                            uint32 bitX = FindLeastSignificantSetBit(bitMask).index;
+                            bitMask &= bitMask - 1;
+
+                            int32 chunkX = blockMinChunkX + (int32)(firstX + bitX);
+                            world_chunk *chunk = GetWorldChunk(world_, chunkX, chunkY, chunkZ);
+                            Assert(chunk && chunk->firstBlock);
+                            AddWorldQueryChunk(query, chunk);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    EndTemporaryMemory(blockMemory);
+}
+
+// NOTE : The chunks of the query that go through the list of the occupied chunks,
+// and get sorted to the same z, y, x order as the bitmap.
+internal void
+AddWorldQueryChunksFromOccupiedList(world_query *query, memory_arena *arena, 
+                                    world_position minChunkPos, world_position maxChunkPos)
+{
+    world *world_ = query->world;
+    query->chunks = PushArray(arena, world_->occupiedChunkCount, world_chunk *);
+    for(world_chunk *chunk = world_->firstOccupiedChunk;
+        chunk;
+        chunk = chunk->nextOccupied)
+    {
+        if(IsChunkInRange(chunk, minChunkPos, maxChunkPos, 0))
+        {
+            AddWorldQueryChunk(query, chunk);
+        }
+    }
+
+    SortWorldQueryChunks(arena, query->chunks, query->chunkCount);
+}
+
+// NOTE : Finds every chunk that has entities inside the bounds(relative to the origin).
+// The chunks array is pushed to the arena, so it should live as long as the query.
+internal world_query
+BeginWorldQuery(world *world_, memory_arena *arena, world_position origin, rect3 bounds)
+{
+    world_query query = {};
+    query.world = world_;
+    query.origin = origin;
+    query.bounds = bounds;
+
+    world_position minChunkPos = MapIntoChunkSpace(world_, origin, GetMinCorner(bounds));
+    world_position maxChunkPos = MapIntoChunkSpace(world_, origin, GetMaxCorner(bounds));
+    int32 minBlockX = minChunkPos.chunkX >> WORLD_OCCUPANCY_BLOCK_SHIFT;
+    int32 maxBlockX = maxChunkPos.chunkX >> WORLD_OCCUPANCY_BLOCK_SHIFT;
+    // NOTE : The bitmap has to look at every row of every block in the bounds
+    uint64 rowCount = (uint64)(maxBlockX - minBlockX + 1) *
+                        (uint64)(maxChunkPos.chunkY - minChunkPos.chunkY + 1) *
+                        (uint64)(maxChunkPos.chunkZ - minChunkPos.chunkZ + 1);
+
+    if(rowCount <= world_->occupiedChunkCount)
+    {
+        // NOTE : The bounds are smaller than the occupied part of the world
+        AddWorldQueryChunksFromBitmap(&query, arena, minChunkPos, maxChunkPos);
+    }
+    else
+    {
+        // NOTE : Most of the bounds are empty, so only go through the chunks that have entities
+        AddWorldQueryChunksFromOccupiedList(&query, arena, minChunkPos, maxChunkPos);
+    }
+
+    return query;
+}
+
+// NOTE : Splits the chunks of the query into rangeCount ranges, and gets one of them.
+// Without the range arguments, this is the whole query.
+inline world_query_range
+GetWorldQueryRange(world_query *query, uint32 rangeIndex = 0, uint32 rangeCount = 1)
+{
+    Assert(rangeIndex < rangeCount);
+
+    world_query_range result;
+    result.firstChunk = (uint32)(((uint64)query->chunkCount*rangeIndex) / rangeCount);
+    result.onePastLastChunk = (uint32)(((uint64)query->chunkCount*(rangeIndex + 1)) / rangeCount);
+
+    return result;
+}
+
+// NOTE : Goes to the next entity of the range. 
+// If there is no more entity in the range, lowEntityIndex becomes 0.
+internal void
+Advance(world_query_iterator *iter)
+{
+    world_query *query = iter->query;
+    for(;;)
+    {
+        if(iter->block && iter->slot < iter->block->entityCount)
+        {
+            iter->entitySlot = iter->slot++;
+            iter->lowEntityIndex = iter->block->lowEntityIndexes[iter->entitySlot];
+            break;
+        }
+
+        // NOTE : Next block, or the next chunk
+        iter->block = iter->block ? iter->block->next : 0;
+        iter->slot = 0;
+        if(!iter->block)
+        {
+            if(iter->chunkIndex < iter->range.onePastLastChunk)
+            {
+                iter->chunk = query->chunks[iter->chunkIndex++];
+                iter->block = iter->chunk->firstBlock;
+            }
+            else
+            {
+                iter->lowEntityIndex = 0;
+                break;
+            }
+        }
+    }
+}
+
+inline world_query_iterator
+IterateWorldQuery(world_query *query, world_query_range range)
+{
+    world_query_iterator iter = {};
+    iter.query = query;
+    iter.range = range;
+    iter.chunkIndex = range.firstChunk;
+    Advance(&iter);
+
+    return iter;
+}
+
+inline bool32
+IsValid(world_query_iterator *iter)
+{
+    // NOTE : 0 is the null entity, which never goes into the chunks
+    bool32 result = (iter->lowEntityIndex != 0);
+    return result;
+}
+
+//
+// NOTE : Chunk streaming
+//
+
+// How many chunks around the sim region we page in before anyone needs them
+#define WORLD_STREAM_PREFETCH_CHUNKS 2
+// Chunks that are further than this from the sim region get paged out.
+// This is bigger than the prefetch so that the chunks on the border don't go back and forth.
+#define WORLD_STREAM_KEEP_CHUNKS 4
+// NOTE : Only for the prefetched ones, the chunks that the sim region touches are always paged in
+#define WORLD_STREAM_MAX_PAGE_INS 8
+#define WORLD_STREAM_MAX_PAGE_OUTS 8
+#define WORLD_STREAM_EVICT_SCAN_COUNT 256
+
+inline memory_index
+GetChunkPageEntitiesOffset()
+{
+    // NOTE : Low entities have pointers in them, so keep them 8 byte aligned
+    memory_index result = (sizeof(world_chunk_page_header) + 7) & ~7;
+    return result;
+}
+
+inline uint32
+GetChunkPageSize(uint32 entityCount)
+{
+    uint32 result = (uint32)(GetChunkPageEntitiesOffset() + entityCount*sizeof(low_entity));
+    return result;
+}
+
+// NOTE : Gets the page of the chunk at that position, 0 if it was never paged out.
+// If the arena was passed and we don't have the page, make a new one.
+internal world_chunk_page *
+GetWorldChunkPage(world *world_, int32 chunkX, int32 chunkY, int32 chunkZ, memory_arena *arena = 0)
+{
+    uint32 hashSlot = HashUInt32Triple((uint32)chunkX, (uint32)chunkY, (uint32)chunkZ) & 
+                        (ArrayCount(world_->pageHash) - 1);
+
+    world_chunk_page *result = 0;
+    for(world_chunk_page *page = world_->pageHash[hashSlot];
+        page;
+        page = page->nextInHash)
+    {
+        if(page->chunkX == chunkX && page->chunkY == chunkY && page->chunkZ == chunkZ)
+        {
+            result = page;
+            break;
+        }
+    }
+
+    if(!result && arena)
+    {
+        result = PushStruct(arena, world_chunk_page);
+        *result = {};
+        result->chunkX = chunkX;
+        result->chunkY = chunkY;
+        result->chunkZ = chunkZ;
+        result->nextInHash = world_->pageHash[hashSlot];
+        world_->pageHash[hashSlot] = result;
+    }
+
+    return result;
+}
+
+// NOTE : Finds the place in the page file for the next write of this page.
+// If the page does not fit in its old place anymore, the old place goes to the holes of its size,
+// and the page takes the hole of the new size(or the end of the file, if there is none).
+internal void
+ReserveWorldChunkPage(world *world_, world_chunk_page *page, uint32 size)
+{
+    Assert(size <= ((uint32)1 << WORLD_PAGE_MAX_SIZE_SHIFT));
+
+    uint32 sizeShift = WORLD_PAGE_MIN_SIZE_SHIFT;
+    while(((uint32)1 << sizeShift) < size)
+    {
+        ++sizeShift;
+    }
+
+    if(page->sizeShift < sizeShift)
+    {
+        if(page->sizeShift)
+        {
+            world_page_hole *hole = world_->firstFreeHole;
+            if(hole)
+            {
+                world_->firstFreeHole = hole->next;
+            }
+            else
+            {
+                hole = PushStruct(world_->arena, world_page_hole);
+            }
+            hole->offset = page->offset;
+
+            world_page_hole **holes = world_->freeHoles + (page->sizeShift - WORLD_PAGE_MIN_SIZE_SHIFT);
+            hole->next = *holes;
+            *holes = hole;
+        }
+
+        world_page_hole **holes = world_->freeHoles + (sizeShift - WORLD_PAGE_MIN_SIZE_SHIFT);
+        world_page_hole *hole = *holes;
+        if(hole)
+        {
+            *holes = hole->next;
+            page->offset = hole->offset;
+
+            hole->next = world_->firstFreeHole;
+            world_->firstFreeHole = hole;
+        }
+        else
+        {
+            page->offset = world_->pageFileSize;
+            world_->pageFileSize += (uint64)1 << sizeShift;
+        }
+        page->sizeShift = sizeShift;
+    }
+
+    page->size = size;
+}
+
+internal world_page_job *
+GetFreeWorldPageJob(world *world_)
+{
+    world_page_job *result = 0;
+    for(uint32 jobIndex = 0;
+        jobIndex < ArrayCount(world_->pageJobs);
+        ++jobIndex)
+    {
+        world_page_job *job = world_->pageJobs + jobIndex;
+        if(!job->page)
+        {
+            result = job;
+            break;
+        }
+    }
+
+    return result;
+}
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(DoWorldPageJob)
+{
+    world_page_job *job = (world_page_job *)data;
+    world *world_ = job->world;
+
+    // NOTE : The handle is only written when the platform hits an error, and then it only turns off noErrors
+    if(job->isWrite)
+    {
+        job->succeeded = world_->writePageFile(thread, &world_->pageFile, job->offset, job->size, job->memory);
+    }
+    else
+    {
+        job->succeeded = world_->readPageFile(thread, &world_->pageFile, job->offset, job->size, job->memory);
+    }
+
+    CompletePreviousWritesBeforeFutureWrites;
+    job->isDone = true;
+}
+
+// NOTE : The chunk should be empty, and not in the low sim queue.
+// Nobody should be holding this chunk after this, because it will be reused for the other chunk.
+internal void
+FreeWorldChunk(world *world_, world_chunk *chunk)
+{
+    Assert(!chunk->firstBlock);
+    Assert(!chunk->isLowSimQueued);
+
+    RemoveWorldChunkHash(world_, chunk);
+    --world_->chunkCount;
+
+    if(chunk->prev)
+    {
+        chunk->prev->next = chunk->next;
+    }
+    else
+    {
+        world_->firstChunk = chunk->next;
+    }
+    if(chunk->next)
+    {
+        chunk->next->prev = chunk->prev;
+    }
+
+    if(world_->evictCursor == chunk)
+    {
+        world_->evictCursor = chunk->next;
+    }
+
+    chunk->prev = 0;
+    chunk->next = world_->firstFreeChunk;
+    world_->firstFreeChunk = chunk;
+}
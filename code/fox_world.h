@@ -21,10 +21,26 @@ struct world_position
 // tile chunks per x/y/z
 // This is just a unit that contains lowEntityIndexes.
 // There is nothing to do with the order
+// NOTE : The bounds in the entity blocks are quantized, relative to the center of the chunk.
+// 1/256m for the center of the bounding box, 1/16m for the biggest half dimension(rounded up),
+// so that the gather can throw out the entities that are out without touching the low entities.
+#define WORLD_ENTITY_BOUNDS_POS_SCALE 256
+#define WORLD_ENTITY_BOUNDS_RADIUS_SCALE 16
+// NOTE : For the entities that don't fit in the quantized bounds, which always go to the exact test
+#define WORLD_ENTITY_BOUNDS_UNKNOWN_RADIUS 0xFF
+
 struct world_entity_block
 {
     uint32 entityCount;
     uint32 lowEntityIndexes[16];
+
+    // NOTE : Bounds of each entity, 7 bytes per slot.
+    // InsertEntityIntoChunk and ChangeEntityLocationRaw keep these in sync with the low entities.
+    int16 boundsX[16];
+    int16 boundsY[16];
+    int16 boundsZ[16];
+    uint8 boundsRadius[16];
+
     world_entity_block *next;
 };
 
@@ -34,18 +50,232 @@ struct world_chunk
     int32 chunkY;
     int32 chunkZ;
 
-    world_entity_block firstBlock;
-    
-    world_chunk *nextInHash;
+    // NOTE : 0 while the chunk is empty, so that the empty chunks(most of the world) don't carry a block.
+    // Only the first block can have room, every block after it is full.
+    world_entity_block *firstBlock;
+
+    // NOTE : Every chunk in the world is in this list,
+    // so that the chunk hash can be rebuilt when it grows.
+    // When the chunk is freed, next is the next one in the free list.
+    world_chunk *next;
+    world_chunk *prev;
+
+    // NOTE : Only the chunks that have at least one entity are in this list
+    world_chunk *nextOccupied;
+    world_chunk *prevOccupied;
+
+    // NOTE : Chunks that might have the awake entities outside the sim region,
+    // for the low frequency update
+    bool32 isLowSimQueued;
+    world_chunk *nextLowSim;
+};
+
+// NOTE : Occupancy bitmap of the chunks, so that the query can skip the empty space
+// with the bit scans instead of looking up every chunk in the hash.
+// One block is 64x64 chunks of one z, and one word of the block is 8x8 chunks.
+// Both the words in the block and the bits in the word go row by row,
+// so one byte is one row of 8.
+#define WORLD_OCCUPANCY_BLOCK_SHIFT 6
+#define WORLD_OCCUPANCY_BLOCK_MASK ((1 << WORLD_OCCUPANCY_BLOCK_SHIFT) - 1)
+// NOTE : Must be a power of 2
+#define WORLD_OCCUPANCY_HASH_COUNT 4096
+
+struct world_occupancy_block
+{
+    int32 blockX;
+    int32 blockY;
+    int32 chunkZ;
+
+    // NOTE : Bit i is set if words[i] is not 0
+    uint64 summary;
+    uint64 words[64];
+
+    world_occupancy_block *nextInHash;
+};
+
+// NOTE : Only the key and where the chunk is, 
+// so that the probes don't have to touch the chunks themselves
+struct world_chunk_hash_slot
+{
+    int32 chunkX;
+    int32 chunkY;
+    int32 chunkZ;
+
+    // 0 means this slot is empty
+    world_chunk *chunk;
 };
 
+// NOTE : Where one chunk is in the page file. This is made the first time the chunk is paged out,
+// and never freed, so the chunk goes back to the same place if the page still fits.
+// While the page is out, the chunk itself is freed, and only this knows about it.
+struct world_chunk_page
+{
+    int32 chunkX;
+    int32 chunkY;
+    int32 chunkZ;
+
+    bool32 isPagedOut;
+    // NOTE : The job that is writing or reading this page, 0 if there is none
+    struct world_page_job *job;
+
+    uint64 offset;
+    uint32 size;
+    // The place is (1 << sizeShift) bytes
+    uint32 sizeShift;
+
+    world_chunk_page *nextInHash;
+};
+
+// NOTE : The place of the page that grew out of it, 
+// waiting for the next page of the same size class
+struct world_page_hole
+{
+    uint64 offset;
+    world_page_hole *next;
+};
+
+// NOTE : Reads or writes one page on the work queue.
+// The job slot keeps its memory, and only the page changes when it's reused.
+struct world_page_job
+{
+    struct world *world;
+
+    // 0 if this slot is free
+    world_chunk_page *page;
+    bool32 isWrite;
+    uint64 offset;
+    uint32 size;
+    uint8 *memory;
+
+    bool32 succeeded;
+    // NOTE : Set by the thread that did the job, after everything else was written
+    bool32 volatile isDone;
+};
+
+// NOTE : Must be a power of 2
+#define WORLD_PAGE_HASH_COUNT 4096
+// NOTE : Places in the page file are from 1KB to 32KB, in powers of 2.
+// The chunk that does not fit in the biggest one just stays in memory.
+#define WORLD_PAGE_MIN_SIZE_SHIFT 10
+#define WORLD_PAGE_MAX_SIZE_SHIFT 15
+#define WORLD_PAGE_MAX_JOB_COUNT 16
+
 struct world
 {
+    // NOTE : The chunks, the entity blocks and the chunk hash all come from here
+    memory_arena *arena;
+
     v3 chunkDimInMeters;
 
     world_entity_block *firstFree;
 
-    world_chunk chunkHash[4096];
+    // NOTE : Open addressing with linear probing, and this must be power of two!
+    // Every time the table grows, the new one is pushed to the world arena(see AllocateWorldChunkHash).
+    uint32 chunkCount;
+    uint32 chunkHashMaxCount;
+    world_chunk_hash_slot *chunkHash;
+
+    world_chunk *firstChunk;
+    world_chunk *firstFreeChunk;
+
+    // NOTE : This is the occupancy index of the world.
+    // If the query touches more chunks than this, it walks this list
+    // instead of looking up every chunk in the hash.
+    uint32 occupiedChunkCount;
+    world_chunk *firstOccupiedChunk;
+    // NOTE : Blocks are never freed, because the world only gets bigger.
+    world_occupancy_block *occupancyHash[WORLD_OCCUPANCY_HASH_COUNT];
+
+    // NOTE : Chunk streaming. If the page file could not be opened, 
+    // nothing gets paged out and the whole world stays in memory.
+    platform_file_handle pageFile;
+    platform_read_page_file *readPageFile;
+    platform_write_page_file *writePageFile;
+    uint64 pageFileSize;
+    world_chunk_page *pageHash[WORLD_PAGE_HASH_COUNT];
+    world_page_hole *freeHoles[WORLD_PAGE_MAX_SIZE_SHIFT - WORLD_PAGE_MIN_SIZE_SHIFT + 1];
+    world_page_hole *firstFreeHole;
+    uint32 pagedOutChunkCount;
+    world_page_job pageJobs[WORLD_PAGE_MAX_JOB_COUNT];
+    // NOTE : How many times the streaming stopped to wait for the pages that the sim region touches.
+    // If the prefetch keeps up with the camera, this never goes up.
+    uint32 blockingPageWaitCount;
+
+    // Where the streaming was centered last time, and whether it should look again
+    // because it could not page in everything it wanted.
+    world_position streamCenter;
+    bool32 hasPendingPageIns;
+    // Where the eviction scan has stopped last frame
+    world_chunk *evictCursor;
+
+    // NOTE : Queue of the chunks for the low frequency update.
+    // The update takes a few from the front every frame,
+    // and puts them back to the end if they still have something to do.
+    uint32 lowSimChunkCount;
+    world_chunk *firstLowSimChunk;
+    world_chunk *lastLowSimChunk;
+};
+
+// NOTE : Every entity in the chunks that overlap the bounds.
+// The query does not look at the entities themselves, 
+// so the caller should do the exact test if it needs one.
+struct world_query
+{
+    struct world *world;
+    world_position origin;
+    // Relative to the origin
+    rect3 bounds;
+
+    // NOTE : Only the chunks that have entities, in z, y, x order
+    uint32 chunkCount;
+    world_chunk **chunks;
+    // How many entities are in those chunks, so that the caller can allocate before iterating
+    uint32 maxEntityCount;
+};
+
+// NOTE : Part of the chunks in the query. 
+// Ranges don't share anything, so each of them can go to a different consumer.
+struct world_query_range
+{
+    uint32 firstChunk;
+    uint32 onePastLastChunk;
+};
+
+struct world_query_iterator
+{
+    world_query *query;
+    world_query_range range;
+
+    uint32 chunkIndex;
+    world_entity_block *block;
+    uint32 slot;
+
+    // NOTE : This is the entity that we are at, and where it is in the blocks
+    uint32 lowEntityIndex;
+    world_chunk *chunk;
+    uint32 entitySlot;
+};
+
+// NOTE : The rectangle that the bounds in the blocks of one chunk are tested against,
+// in the same quantized units
+struct world_entity_bounds_test
+{
+    int32 minX;
+    int32 minY;
+    int32 minZ;
+    int32 maxX;
+    int32 maxY;
+    int32 maxZ;
+};
+
+// NOTE : One page of a chunk is this header, then the low entities.
+// The entities get new slots when they come back, so the page does not keep the old ones.
+struct world_chunk_page_header
+{
+    int32 chunkX;
+    int32 chunkY;
+    int32 chunkZ;
+    uint32 entityCount;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "fox_world_gen.h"
+
+internal void
+InitializeWorldGen(world_gen *gen, world *world, uint32 seed,
+                    int32 tilesPerRoomX, int32 tilesPerRoomY,
+                    real32 tileSideInMeters, real32 tileDeptInMeters)
+{
+    *gen = {};
+    gen->world = world;
+    gen->seed = seed;
+    gen->tilesPerRoomX = tilesPerRoomX;
+    gen->tilesPerRoomY = tilesPerRoomY;
+    gen->tileSideInMeters = tileSideInMeters;
+    gen->tileDeptInMeters = tileDeptInMeters;
+}
+
+// TODO : This is only for the world building! Remove it completely later.
+inline world_position
+TilePositionToChunkPosition(world_gen *gen, int32 absTileX, int32 absTileY, int32 absTileZ,
+                            v3 additionalOffset = V3(0, 0, 0))
+{
+    world_position basePos = {};
+
+    v3 tileDim = V3(gen->tileSideInMeters, gen->tileSideInMeters, gen->tileDeptInMeters);
+    v3 offset = Hadamard(tileDim, V3((real32)absTileX, (real32)absTileY, (real32)absTileZ));
+
+    // Recanonicalize this value
+    world_position result = MapIntoChunkSpace(gen->world, basePos, offset + additionalOffset);
+
+    Assert(IsCanonical(gen->world, result.offset_));
+
+    return result;
+}
+
+inline uint32
+GetMaxWorldGenEntitiesPerRoom(world_gen *gen)
+{
+    // NOTE : The room itself, the walls around it, and the pillars
+    uint32 result = 1 + 2*(gen->tilesPerRoomX + gen->tilesPerRoomY) + WORLD_GEN_MAX_PILLARS_PER_ROOM;
+    return result;
+}
+
+// NOTE : Pushes the memory for the biggest region that we can have,
+// so that the job slot can be reused for any region.
+internal void
+InitializeWorldGenRegion(world_gen *gen, world_gen_region *region, memory_arena *arena)
+{
+    *region = {};
+    region->gen = gen;
+
+    // NOTE : Chunks of the region at the origin, plus one more on each axis,
+    // because the other regions can start at the different place in the chunk
+    world_position minChunkPos = TilePositionToChunkPosition(gen, 0, 0, 0);
+    world_position maxChunkPos = 
+        TilePositionToChunkPosition(gen,
+                                    WORLD_GEN_ROOMS_PER_REGION*gen->tilesPerRoomX - 1,
+                                    WORLD_GEN_ROOMS_PER_REGION*gen->tilesPerRoomY - 1,
+                                    0);
+    region->maxChunkCount = (maxChunkPos.chunkX - minChunkPos.chunkX + 2)*
+                            (maxChunkPos.chunkY - minChunkPos.chunkY + 2);
+
+    region->maxEntityCount = 
+        WORLD_GEN_ROOMS_PER_REGION*WORLD_GEN_ROOMS_PER_REGION*GetMaxWorldGenEntitiesPerRoom(gen);
+    region->entities = PushArray(arena, region->maxEntityCount, low_entity);
+}
+
+// NOTE : Should be called on the main thread, before the region goes to the job.
+internal void
+BeginWorldGenRegion(world_gen_region *region, int32 regionX, int32 regionY, int32 regionZ)
+{
+    world_gen *gen = region->gen;
+
+    region->minRoomX = regionX*WORLD_GEN_ROOMS_PER_REGION;
+    region->minRoomY = regionY*WORLD_GEN_ROOMS_PER_REGION;
+    region->roomZ = regionZ;
+    region->roomCountX = WORLD_GEN_ROOMS_PER_REGION;
+    region->roomCountY = WORLD_GEN_ROOMS_PER_REGION;
+
+    // NOTE : Every entity is on one of the tiles of the region,
+    // so the chunks of the first and the last tile are the bounds
+    world_position minChunkPos =
+        TilePositionToChunkPosition(gen,
+                                    region->minRoomX*gen->tilesPerRoomX,
+                                    region->minRoomY*gen->tilesPerRoomY,
+                                    region->roomZ);
+    world_position maxChunkPos =
+        TilePositionToChunkPosition(gen,
+                                    (region->minRoomX + region->roomCountX)*gen->tilesPerRoomX - 1,
+                                    (region->minRoomY + region->roomCountY)*gen->tilesPerRoomY - 1,
+                                    region->roomZ);
+    region->minChunkPos = minChunkPos;
+    region->chunkCountX = maxChunkPos.chunkX - minChunkPos.chunkX + 1;
+    region->chunkCountY = maxChunkPos.chunkY - minChunkPos.chunkY + 1;
+    region->chunkCountZ = maxChunkPos.chunkZ - minChunkPos.chunkZ + 1;
+    Assert(region->chunkCountX*region->chunkCountY*region->chunkCountZ <= region->maxChunkCount);
+
+    region->entityCount = 0;
+    region->checksum = 0;
+}
+
+inline low_entity *
+AddWorldGenEntity(world_gen_region *region, entity_type type,
+                    int32 absTileX, int32 absTileY, int32 absTileZ,
+                    sim_entity_collision_volume_group *collision)
+{
+    Assert(region->entityCount < region->maxEntityCount);
+    low_entity *low = region->unsortedEntities + region->entityCount++;
+
+    *low = {};
+    low->type = (uint8)type;
+    low->pos = TilePositionToChunkPosition(region->gen, absTileX, absTileY, absTileZ);
+    low->collision = collision;
+
+    return low;
+}
+
+internal void
+GenerateRoom(world_gen_region *region, int32 roomX, int32 roomY, int32 roomZ)
+{
+    world_gen *gen = region->gen;
+    random_series series = Seed(HashUInt32Triple((uint32)roomX, (uint32)roomY, (uint32)roomZ) ^ gen->seed);
+
+    int32 tilesPerWidth = gen->tilesPerRoomX;
+    int32 tilesPerHeight = gen->tilesPerRoomY;
+    int32 baseTileX = roomX*tilesPerWidth;
+    int32 baseTileY = roomY*tilesPerHeight;
+
+    // NOTE : Unlike the others, the space is from the center of the room
+    low_entity *space = AddWorldGenEntity(region, EntityType_Space,
+                                        baseTileX + tilesPerWidth/2, baseTileY + tilesPerHeight/2, roomZ,
+                                        gen->standardRoomCollision);
+    AddFlags(space, EntityFlag_Traversable);
+
+    // NOTE : Walls around the room, with the doors in the middle of each side
+    for(int32 tileY = 0;
+        tileY < tilesPerHeight;
+        ++tileY)
+    {
+        for(int32 tileX = 0;
+            tileX < tilesPerWidth;
+            ++tileX)
+        {
+            bool32 shouldBeWall = false;
+            if((tileX == 0 || tileX == tilesPerWidth - 1) && tileY != tilesPerHeight/2)
+            {
+                shouldBeWall = true;
+            }
+
+            if((tileY == 0 || tileY == tilesPerHeight - 1) && tileX != tilesPerWidth/2)
+            {
+                shouldBeWall = true;
+            }
+
+            if(shouldBeWall)
+            {
+                low_entity *wall = AddWorldGenEntity(region, EntityType_Wall,
+                                                    baseTileX + tileX, baseTileY + tileY, roomZ,
+                                                    gen->wallCollision);
+                AddFlags(wall, EntityFlag_CanCollide);
+            }
+        }
+    }
+
+    // NOTE : Few pillars in the room, but not in the room where the player starts
+    if(roomX != 0 || roomY != 0 || roomZ != 0)
+    {
+        uint32 pillarCount = RandomChoice(&series, WORLD_GEN_MAX_PILLARS_PER_ROOM + 1);
+        for(uint32 pillarIndex = 0;
+            pillarIndex < pillarCount;
+            ++pillarIndex)
+        {
+            int32 tileX = 2 + RandomChoice(&series, tilesPerWidth - 4);
+            int32 tileY = 2 + RandomChoice(&series, tilesPerHeight - 4);
+
+            // Don't block the paths between the doors
+            if(tileX != tilesPerWidth/2 && tileY != tilesPerHeight/2)
+            {
+                low_entity *pillar = AddWorldGenEntity(region, EntityType_Wall,
+                                                        baseTileX + tileX, baseTileY + tileY, roomZ,
+                                                        gen->wallCollision);
+                AddFlags(pillar, EntityFlag_CanCollide);
+            }
+        }
+    }
+}
+
+inline uint32
+GetWorldGenChunkIndex(world_gen_region *region, world_position *pos)
+{
+    uint32 x = (uint32)(pos->chunkX - region->minChunkPos.chunkX);
+    uint32 y = (uint32)(pos->chunkY - region->minChunkPos.chunkY);
+    uint32 z = (uint32)(pos->chunkZ - region->minChunkPos.chunkZ);
+    Assert(x < region->chunkCountX && y < region->chunkCountY && z < region->chunkCountZ);
+
+    uint32 result = (z*region->chunkCountY + y)*region->chunkCountX + x;
+    return result;
+}
+
+// NOTE : Counting sort by the chunk, so the entities in the same chunk stay in the order they were made
+internal void
+SortWorldGenRegion(world_gen_region *region)
+{
+    uint32 chunkCount = region->chunkCountX*region->chunkCountY*region->chunkCountZ;
+    ZeroSize(chunkCount*sizeof(uint32), region->chunkCounts);
+
+    for(uint32 entityIndex = 0;
+        entityIndex < region->entityCount;
+        ++entityIndex)
+    {
+        ++region->chunkCounts[GetWorldGenChunkIndex(region, &region->unsortedEntities[entityIndex].pos)];
+    }
+
+    // Now each count becomes where the chunk starts
+    uint32 first = 0;
+    for(uint32 chunkIndex = 0;
+        chunkIndex < chunkCount;
+        ++chunkIndex)
+    {
+        uint32 count = region->chunkCounts[chunkIndex];
+        region->chunkCounts[chunkIndex] = first;
+        first += count;
+    }
+
+    for(uint32 entityIndex = 0;
+        entityIndex < region->entityCount;
+        ++entityIndex)
+    {
+        low_entity *source = region->unsortedEntities + entityIndex;
+        uint32 dest = region->chunkCounts[GetWorldGenChunkIndex(region, &source->pos)]++;
+        region->entities[dest] = *source;
+    }
+}
+
+// NOTE : This can run on any thread, with the scratch arena of that thread.
+internal void
+GenerateWorldRegion(world_gen_region *region, memory_arena *scratchArena)
+{
+    temporary_memory scratchMemory = BeginTemporaryMemory(scratchArena);
+    region->unsortedEntities = PushArray(scratchArena, region->maxEntityCount, low_entity);
+    region->chunkCounts = PushArray(scratchArena, region->maxChunkCount, uint32);
+
+    for(int32 roomY = region->minRoomY;
+        roomY < region->minRoomY + region->roomCountY;
+        ++roomY)
+    {
+        for(int32 roomX = region->minRoomX;
+            roomX < region->minRoomX + region->roomCountX;
+            ++roomX)
+        {
+            GenerateRoom(region, roomX, roomY, region->roomZ);
+        }
+    }
+
+    SortWorldGenRegion(region);
+
+    region->unsortedEntities = 0;
+    region->chunkCounts = 0;
+    EndTemporaryMemory(scratchMemory);
+
+    // NOTE : FNV-1a over what makes the entities, in the sorted order.
+    // The slot indices are left out, because those depend on when the region went in.
+    uint64 checksum = 0xcbf29ce484222325ull;
+    for(uint32 entityIndex = 0;
+        entityIndex < region->entityCount;
+        ++entityIndex)
+    {
+        low_entity *low = region->entities + entityIndex;
+        world_position *pos = &low->pos;
+        uint32 values[] = 
+        {
+            low->type, 
+            low->flags,
+            (uint32)pos->chunkX, (uint32)pos->chunkY, (uint32)pos->chunkZ,
+            *(uint32 *)&pos->offset_.x, *(uint32 *)&pos->offset_.y, *(uint32 *)&pos->offset_.z,
+        };
+        for(uint32 valueIndex = 0;
+            valueIndex < ArrayCount(values);
+            ++valueIndex)
+        {
+            checksum ^= values[valueIndex];
+            checksum *= 0x100000001b3ull;
+        }
+    }
+    region->checksum = checksum;
+}
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(DoWorldGenJob)
+{
+    world_gen_job *job = (world_gen_job *)data;
+    GenerateWorldRegion(&job->region, &thread->scratchArena);
+
+    CompletePreviousWritesBeforeFutureWrites;
+    job->isDone = true;
+}
+
+internal world_gen_region_entry *
+GetWorldGenRegionEntry(world_gen *gen, memory_arena *arena, int32 regionX, int32 regionY, int32 regionZ)
+{
+    uint32 hashSlot = HashUInt32Triple((uint32)regionX, (uint32)regionY, (uint32)regionZ) & 
+                        (ArrayCount(gen->regionHash) - 1);
+
+    world_gen_region_entry *result = 0;
+    for(world_gen_region_entry *entry = gen->regionHash[hashSlot];
+        entry;
+        entry = entry->nextInHash)
+    {
+        if(entry->regionX == regionX && entry->regionY == regionY && entry->regionZ == regionZ)
+        {
+            result = entry;
+            break;
+        }
+    }
+
+    if(!result)
+    {
+        result = PushStruct(arena, world_gen_region_entry);
+        *result = {};
+        result->regionX = regionX;
+        result->regionY = regionY;
+        result->regionZ = regionZ;
+        result->nextInHash = gen->regionHash[hashSlot];
+        gen->regionHash[hashSlot] = result;
+    }
+
+    return result;
+}
+
+// NOTE : Every region that bounds around the center touches, and margin more regions around them.
+internal world_gen_region_range
+GetWorldGenRegionRange(world_gen *gen, world_position center, rect3 bounds, int32 margin)
+{
+    v3 chunkDim = gen->world->chunkDimInMeters;
+    // NOTE : The tiles are centered at the tile coordinates, so the room starts half a tile before
+    real32 halfTile = 0.5f*gen->tileSideInMeters;
+    real32 regionDimX = WORLD_GEN_ROOMS_PER_REGION*gen->tilesPerRoomX*gen->tileSideInMeters;
+    real32 regionDimY = WORLD_GEN_ROOMS_PER_REGION*gen->tilesPerRoomY*gen->tileSideInMeters;
+
+    v2 centerP = V2(center.chunkX*chunkDim.x + center.offset_.x,
+                    center.chunkY*chunkDim.y + center.offset_.y);
+    v3 minCorner = GetMinCorner(bounds);
+    v3 maxCorner = GetMaxCorner(bounds);
+
+    world_gen_region_range result;
+    result.minRegionX = FloorReal32ToInt32((centerP.x + minCorner.x + halfTile) / regionDimX) - margin;
+    result.minRegionY = FloorReal32ToInt32((centerP.y + minCorner.y + halfTile) / regionDimY) - margin;
+    result.maxRegionX = FloorReal32ToInt32((centerP.x + maxCorner.x + halfTile) / regionDimX) + margin;
+    result.maxRegionY = FloorReal32ToInt32((centerP.y + maxCorner.y + halfTile) / regionDimY) + margin;
+
+    return result;
+}
@@ -0,0 +1,110 @@
+#ifndef FOX_WORLD_GEN_H
+#define FOX_WORLD_GEN_H
+
+// NOTE : World is made of rooms, and the rooms are generated region by region
+// when the sim first gets close to them, so the world has no end.
+// Each room gets its own random series from its coordinates,
+// so the room comes out the same no matter which region or thread made it.
+#define WORLD_GEN_ROOMS_PER_REGION 8
+#define WORLD_GEN_MAX_PILLARS_PER_ROOM 2
+// NOTE : How many regions around the sim bounds we generate ahead of time
+#define WORLD_GEN_LOOKAHEAD_REGIONS 1
+// NOTE : How many regions can be generated at once
+#define WORLD_GEN_MAX_JOB_COUNT 16
+// NOTE : Must be a power of 2
+#define WORLD_GEN_REGION_HASH_COUNT 4096
+
+// NOTE : One for every region that was ever asked for, so that it's never generated twice.
+// These live in the world arena with the entities that they made.
+struct world_gen_region_entry
+{
+    int32 regionX;
+    int32 regionY;
+    int32 regionZ;
+
+    bool32 isQueued;
+    bool32 isGenerated;
+
+    world_gen_region_entry *nextInHash;
+};
+
+// NOTE : Everything that the region jobs need to know.
+// The jobs only read from this, so every thread can share it.
+struct world_gen
+{
+    struct world *world;
+    uint32 seed;
+
+    int32 tilesPerRoomX;
+    int32 tilesPerRoomY;
+    real32 tileSideInMeters;
+    real32 tileDeptInMeters;
+
+    sim_entity_collision_volume_group *wallCollision;
+    sim_entity_collision_volume_group *standardRoomCollision;
+
+    // NOTE : Sum of the checksums of every region that went into the world.
+    // The regions can go in in any order, but this should always be the same
+    // for the same regions, no matter how many threads we had.
+    uint64 checksum;
+
+    world_gen_region_entry *regionHash[WORLD_GEN_REGION_HASH_COUNT];
+};
+
+// NOTE : Output of one region job.
+// Every region has its own memory, so the jobs never touch the same thing.
+struct world_gen_region
+{
+    world_gen *gen;
+
+    int32 minRoomX;
+    int32 minRoomY;
+    int32 roomZ;
+    int32 roomCountX;
+    int32 roomCountY;
+
+    // NOTE : Every chunk that this region can touch, for the counting sort
+    world_position minChunkPos;
+    uint32 chunkCountX;
+    uint32 chunkCountY;
+    uint32 chunkCountZ;
+    uint32 maxChunkCount;
+
+    uint32 entityCount;
+    uint32 maxEntityCount;
+    // NOTE : These are the low entities without the slots.
+    // They are sorted by the chunk when the job is done,
+    // so that the insertion only looks up each chunk once.
+    low_entity *entities;
+
+    // NOTE : These are in the scratch arena of the thread that does the job,
+    // so they are only there while the job is running.
+    uint32 *chunkCounts;
+    low_entity *unsortedEntities;
+
+    // NOTE : FNV-1a over the sorted entities
+    uint64 checksum;
+};
+
+// NOTE : The job slot keeps its memory, and only the entry changes when it's reused.
+struct world_gen_job
+{
+    world_gen_region region;
+
+    // 0 if this slot is free
+    world_gen_region_entry *entry;
+    // NOTE : The regions go into the world in this order, not in the order that the jobs are done
+    uint32 requestIndex;
+    // NOTE : Set by the thread that did the job, after everything else was written
+    bool32 volatile isDone;
+};
+
+struct world_gen_region_range
+{
+    int32 minRegionX;
+    int32 minRegionY;
+    int32 maxRegionX;
+    int32 maxRegionY;
+};
+
+#endif
@@ -0,0 +1,266 @@
+/******************************************************************************
+File:   linux_fox.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    TODO: THIS IS NOT A FINAL PATFORM LAYER!!
+
+    For now, this has no window, no sound and no controller.
+    The game runs as fast as it can with the scripted input below, and prints
+    the cycle counters, the arena profile and the hash of the last frame when it's done.
+    That's enough to profile the game and to compare two builds on linux.
+
+    - Window and blit(X11?)
+    - Sound(ALSA?)
+    - Keyboard and controllers
+    - Hot reloading the game code
+    - Sleep to the target frame rate
+*****/
+
+//Always mind the orders - it matters!
+
+#include "fox.h"
+#include "fox_intrinsics.h"
+#include "fox_math.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#include "linux_fox.h"
+#include "linux_fox_memory.cpp"
+#include "linux_fox_queue.cpp"
+#include "linux_fox_file.cpp"
+
+#if FOX_DEBUG
+// NOTE : fox.so has its own, this one is only for the arena functions that the platform layer uses
+game_memory *debugGlobalMemory;
+#endif
+
+internal linux_game_code
+LinuxLoadGameCode(char *sourceSOFullPath)
+{
+    linux_game_code result = {};
+
+    result.gameCodeSO = dlopen(sourceSOFullPath, RTLD_NOW|RTLD_LOCAL);
+    if(result.gameCodeSO)
+    {
+        result.updateAndRender = (game_update_and_render *)dlsym(result.gameCodeSO, "GameUpdateAndRender");
+        result.getSoundSamples = (game_get_sound_samples *)dlsym(result.gameCodeSO, "GameGetSoundSamples");
+
+        result.isValid = result.updateAndRender && result.getSoundSamples;
+    }
+    else
+    {
+        fprintf(stderr, "%s\n", dlerror());
+    }
+
+    if(!result.isValid)
+    {
+        result.updateAndRender = 0;
+        result.getSoundSamples = 0;
+    }
+
+    return result;
+}
+
+// NOTE : fox.so should be next to the executable
+internal void
+LinuxBuildEXEPathFileName(char *fileName, int destCount, char *dest)
+{
+    char exeFileName[4096] = {};
+    ssize_t exeFileNameSize = readlink("/proc/self/exe", exeFileName, sizeof(exeFileName) - 1);
+
+    char *onePastLastSlash = exeFileName;
+    for(ssize_t charIndex = 0;
+        charIndex < exeFileNameSize;
+        ++charIndex)
+    {
+        if(exeFileName[charIndex] == '/')
+        {
+            onePastLastSlash = exeFileName + charIndex + 1;
+        }
+    }
+    *onePastLastSlash = 0;
+
+    snprintf(dest, destCount, "%s%s", exeFileName, fileName);
+}
+
+internal real64
+LinuxGetSecondsElapsed(timespec start, timespec end)
+{
+    real64 result = (real64)(end.tv_sec - start.tv_sec) + 1e-9*(real64)(end.tv_nsec - start.tv_nsec);
+    return result;
+}
+
+internal void
+LinuxProcessScriptedButton(game_button_state *oldState, game_button_state *newState, bool32 isDown)
+{
+    newState->endedDown = isDown;
+    newState->halfTransitionCount = (oldState->endedDown != newState->endedDown) ? 1 : 0;
+}
+
+// NOTE : The hero starts at the first frame, and walks around the rooms
+// throwing the sword every now and then. This is always the same,
+// so two runs of the same build draw the same frames.
+internal void
+LinuxScriptInput(uint32 frameIndex, game_controller *oldController, game_controller *newController)
+{
+    LinuxProcessScriptedButton(&oldController->start, &newController->start, frameIndex == 1);
+    LinuxProcessScriptedButton(&oldController->moveRight, &newController->moveRight, (frameIndex % 120) < 60);
+    LinuxProcessScriptedButton(&oldController->moveUp, &newController->moveUp, (frameIndex % 90) < 30);
+    LinuxProcessScriptedButton(&oldController->actionLeft, &newController->actionLeft, (frameIndex % 45) == 0);
+    newController->isConnected = true;
+}
+
+internal void
+LinuxPrintCycleCounters(game_memory *gameMemory, uint32 frameCount)
+{
+#if FOX_DEBUG
+    printf("DEBUG CYCLE COUNT : \n");
+    for(int counterIndex = 0;
+        counterIndex < ArrayCount(gameMemory->counters);
+        ++counterIndex)
+    {
+        debug_cycle_counter *counter = gameMemory->counters + counterIndex;
+        if(counter->hitCount)
+        {
+            printf(" %d : %llucycles/frame, %uhit, %llucycles/hit\n",
+                counterIndex,
+                (unsigned long long)(counter->cycleCount/frameCount),
+                counter->hitCount,
+                (unsigned long long)(counter->cycleCount/counter->hitCount));
+        }
+    }
+#endif
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32 frameCount = 300;
+    if(argc > 1)
+    {
+        frameCount = (uint32)atoi(argv[1]);
+    }
+
+    // TODO : Get the number of the logical cores from the OS
+    platform_work_queue workQueue = {};
+    linux_thread_startup threadStartups[7] = {};
+    LinuxMakeQueue(&workQueue, ArrayCount(threadStartups), threadStartups);
+
+    // NOTE : The main thread does the work too, while it waits for the queue
+    thread_context mainThread;
+    bool32 mainThreadInitialized = LinuxInitializeThreadContext(&mainThread, LINUX_SCRATCH_ARENA_SIZE);
+    Assert(mainThreadInitialized);
+
+    char sourceSOFullPath[4096];
+    LinuxBuildEXEPathFileName("fox.so", sizeof(sourceSOFullPath), sourceSOFullPath);
+
+    int32 screenWidth = 960;
+    int32 screenHeight = 540;
+    int32 bytesPerPixel = 4;
+
+    game_offscreen_buffer gameBuffer = {};
+    gameBuffer.width = screenWidth;
+    gameBuffer.height = screenHeight;
+    gameBuffer.bytesPerPixel = bytesPerPixel;
+    gameBuffer.pitch = screenWidth*bytesPerPixel;
+    gameBuffer.memory = calloc(1, gameBuffer.pitch*gameBuffer.height);
+
+    int gameUpdateHz = 30;
+    real32 targetSecondsPerFrame = 1.0f / (real32)gameUpdateHz;
+
+//If possible, set the base address to where we want for debugging purpose
+#if FOX_DEBUG
+    void *baseAddress = (void *)Terabytes(2);
+#else
+    void *baseAddress = 0;
+#endif
+    game_memory gameMemory = {};
+    // NOTE : Same as win32, these are only reserved, and the game commits what it uses.
+    gameMemory.permanentStorageSize = Gigabytes(1);
+    gameMemory.transientStorageSize = Gigabytes(4);
+    gameMemory.debugPlatformFreeFileMemory = DEBUGPlatformFreeFileMemory;
+    gameMemory.debugPlatformReadEntireFile = DEBUGPlatformReadEntireFile;
+    gameMemory.debugPlatformWriteEntireFile = DEBUGPlatformWriteEntireFile;
+    gameMemory.platformOpenPageFile = LinuxOpenPageFile;
+    gameMemory.platformReadPageFile = LinuxReadPageFile;
+    gameMemory.platformWritePageFile = LinuxWritePageFile;
+    gameMemory.workQueue = &workQueue;
+    gameMemory.platformAddEntry = LinuxAddEntry;
+    gameMemory.platformCompleteAllWork = LinuxCompleteAllWork;
+#if FOX_ARENA_PROFILE
+    DEBUGRegisterArena(&gameMemory, &mainThread.scratchArena, "main scratch");
+    for(uint32 threadIndex = 0;
+        threadIndex < ArrayCount(threadStartups);
+        ++threadIndex)
+    {
+        DEBUGRegisterArena(&gameMemory, &threadStartups[threadIndex].thread.scratchArena, "worker scratch");
+    }
+#endif
+
+    int result = 1;
+    // NOTE : The guard is never committed, so that running off the end of the permanent storage
+    // faults right away instead of writing over the transient storage.
+    if(gameBuffer.memory && LinuxReserveGameMemory(&gameMemory, baseAddress, Kilobytes(64)))
+    {
+        linux_game_code gameCode = LinuxLoadGameCode(sourceSOFullPath);
+        if(gameCode.isValid)
+        {
+            game_input inputs[2] = {};
+            game_input *newInput = &inputs[0];
+            game_input *oldInput = &inputs[1];
+
+            timespec startClock;
+            clock_gettime(CLOCK_MONOTONIC, &startClock);
+
+            for(uint32 frameIndex = 0;
+                frameIndex < frameCount;
+                ++frameIndex)
+            {
+                newInput->dtForFrame = targetSecondsPerFrame;
+                LinuxScriptInput(frameIndex, &oldInput->controllers[0], &newInput->controllers[0]);
+
+                gameCode.updateAndRender(&mainThread, &gameMemory, &gameBuffer, newInput);
+#if FOX_ARENA_PROFILE
+                DEBUGEndArenaProfileFrame(&gameMemory);
+#endif
+
+                game_input *temp = newInput;
+                newInput = oldInput;
+                oldInput = temp;
+            }
+
+            timespec endClock;
+            clock_gettime(CLOCK_MONOTONIC, &endClock);
+            real64 secondsElapsed = LinuxGetSecondsElapsed(startClock, endClock);
+
+            LinuxPrintCycleCounters(&gameMemory, frameCount);
+
+            // NOTE : FNV-1a of the last frame, so that two builds can be compared
+            uint64 frameHash = 0xcbf29ce484222325ull;
+            uint8 *pixel = (uint8 *)gameBuffer.memory;
+            for(int32 byteIndex = 0;
+                byteIndex < gameBuffer.pitch*gameBuffer.height;
+                ++byteIndex)
+            {
+                frameHash ^= pixel[byteIndex];
+                frameHash *= 0x100000001b3ull;
+            }
+
+            printf("%u frames, %.02fms/f, last frame hash %016llx\n",
+                frameCount, 1000.0*secondsElapsed / (real64)frameCount, (unsigned long long)frameHash);
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,23 @@
+#ifndef LINUX_FOX_H
+#define LINUX_FOX_H
+
+struct linux_game_code
+{
+    void *gameCodeSO;
+
+    // IMPORTANT : Either of the callbacks can be 0
+    // You must check before calling.
+    game_update_and_render *updateAndRender;
+    game_get_sound_samples *getSoundSamples;
+
+    bool32 isValid;
+};
+
+// NOTE : Only reserved, so this can be big
+#define LINUX_SCRATCH_ARENA_SIZE Megabytes(256)
+struct linux_thread_startup
+{
+    platform_work_queue *queue;
+    thread_context thread;
+};
+#endif
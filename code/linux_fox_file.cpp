@@ -0,0 +1,142 @@
+/******************************************************************************
+File:   linux_fox_file.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    Files for the linux platform layer, which should include this after fox.h.
+*****/
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+
+DEBUG_PLATFORM_FREE_FILE_MEMORY(DEBUGPlatformFreeFileMemory)
+{
+    if(memory)
+    {
+        free(memory);
+    }
+}
+
+DEBUG_PLATFORM_READ_ENTIRE_FILE(DEBUGPlatformReadEntireFile)
+{
+    debug_read_file_result result = {};
+
+    int fileHandle = open(fileName, O_RDONLY);
+    if(fileHandle != -1)
+    {
+        struct stat fileStatus;
+        if(fstat(fileHandle, &fileStatus) == 0)
+        {
+            uint32 fileSize32 = SafeTruncateUInt64(fileStatus.st_size);
+            result.content = malloc(fileSize32);
+            if(result.content)
+            {
+                // NOTE : read can return less than we asked for, so keep going until we have it all
+                uint32 bytesRead = 0;
+                while(bytesRead < fileSize32)
+                {
+                    ssize_t readSize = read(fileHandle, (uint8 *)result.content + bytesRead, fileSize32 - bytesRead);
+                    if(readSize <= 0)
+                    {
+                        break;
+                    }
+                    bytesRead += (uint32)readSize;
+                }
+
+                if(bytesRead == fileSize32)
+                {
+                    result.contentSize = fileSize32;
+                }
+                else
+                {
+                    DEBUGPlatformFreeFileMemory(thread, result.content);
+                    result.content = 0;
+                }
+            }
+        }
+
+        close(fileHandle);
+    }
+
+    return result;
+}
+
+DEBUG_PLATFORM_WRTIE_ENTIRE_FILE(DEBUGPlatformWriteEntireFile)
+{
+    bool32 result = false;
+
+    int fileHandle = open(fileName, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fileHandle != -1)
+    {
+        ssize_t bytesWritten = write(fileHandle, memory, memorySize);
+        result = (bytesWritten == (ssize_t)memorySize);
+
+        close(fileHandle);
+    }
+
+    return result;
+}
+
+PLATFORM_OPEN_PAGE_FILE(LinuxOpenPageFile)
+{
+    platform_file_handle result = {};
+
+    int fileHandle = open(fileName, O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if(fileHandle != -1)
+    {
+        // NOTE : Same as FILE_FLAG_DELETE_ON_CLOSE, the file goes away
+        // when we close it(or crash), and nobody else can open it.
+        unlink(fileName);
+
+        result.noErrors = true;
+        result.platform = (void *)(memory_index)fileHandle;
+    }
+
+    return result;
+}
+
+PLATFORM_READ_PAGE_FILE(LinuxReadPageFile)
+{
+    bool32 result = false;
+
+    if(handle->noErrors)
+    {
+        int fileHandle = (int)(memory_index)handle->platform;
+        if(pread(fileHandle, dest, size, (off_t)offset) == (ssize_t)size)
+        {
+            result = true;
+        }
+        else
+        {
+            handle->noErrors = false;
+        }
+    }
+
+    return result;
+}
+
+PLATFORM_WRITE_PAGE_FILE(LinuxWritePageFile)
+{
+    bool32 result = false;
+
+    if(handle->noErrors)
+    {
+        int fileHandle = (int)(memory_index)handle->platform;
+        if(pwrite(fileHandle, source, size, (off_t)offset) == (ssize_t)size)
+        {
+            result = true;
+        }
+        else
+        {
+            handle->noErrors = false;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,107 @@
+/******************************************************************************
+File:   linux_fox_memory.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    Game memory for the linux platform layer, which should include this after fox.h.
+
+    The storage is only reserved with PROT_NONE, so it costs nothing until the arenas commit it.
+    Committing is just making the pages writable, and the kernel gives us the zero page
+    when we first touch them. Decommit throws the pages away with MADV_DONTNEED
+    and makes them PROT_NONE again, so touching the memory that the arena gave back faults.
+*****/
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+internal memory_index
+LinuxGetPageSize()
+{
+    local_persist memory_index pageSize = 0;
+    if(!pageSize)
+    {
+        pageSize = (memory_index)sysconf(_SC_PAGESIZE);
+    }
+
+    return pageSize;
+}
+
+PLATFORM_COMMIT_MEMORY(LinuxCommitMemory)
+{
+    memory_index pageMask = LinuxGetPageSize() - 1;
+
+    // NOTE : Round out to the whole pages
+    memory_index start = (memory_index)base & ~pageMask;
+    memory_index end = ((memory_index)base + size + pageMask) & ~pageMask;
+    bool32 result = (mprotect((void *)start, end - start, PROT_READ|PROT_WRITE) == 0);
+
+    return result;
+}
+
+PLATFORM_DECOMMIT_MEMORY(LinuxDecommitMemory)
+{
+    memory_index pageMask = LinuxGetPageSize() - 1;
+
+    // NOTE : Round in, because the pages at the edges might still have something in them
+    memory_index start = ((memory_index)base + pageMask) & ~pageMask;
+    memory_index end = ((memory_index)base + size) & ~pageMask;
+    if(start < end)
+    {
+        madvise((void *)start, end - start, MADV_DONTNEED);
+        mprotect((void *)start, end - start, PROT_NONE);
+    }
+}
+
+// NOTE : Reserves the permanent and the transient storage of the memory,
+// which should already have their sizes.
+// If the guardSize is not 0, that much is left uncommitted after each storage,
+// so that running off the end faults right away instead of writing over the next one.
+internal bool32
+LinuxReserveGameMemory(game_memory *memory, void *baseAddress, memory_index guardSize)
+{
+    bool32 result = false;
+
+    memory_index pageMask = LinuxGetPageSize() - 1;
+    guardSize = (guardSize + pageMask) & ~pageMask;
+    memory_index permanentSize = ((memory_index)memory->permanentStorageSize + pageMask) & ~pageMask;
+    memory_index totalSize = permanentSize + guardSize +
+                            (memory_index)memory->transientStorageSize + guardSize;
+
+    // NOTE : MAP_NORESERVE, because we don't want the kernel to count
+    // the whole reservation against the overcommit limit.
+    void *storage = mmap(baseAddress, totalSize, PROT_NONE,
+                        MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if(storage != MAP_FAILED)
+    {
+        memory->permanentStorage = storage;
+        memory->transientStorage = (uint8 *)storage + permanentSize + guardSize;
+        memory->platformCommitMemory = LinuxCommitMemory;
+        memory->platformDecommitMemory = LinuxDecommitMemory;
+
+        result = true;
+    }
+
+    return result;
+}
+
+// NOTE : Every thread gets its own scratch arena, which commits as it grows
+internal bool32
+LinuxInitializeThreadContext(thread_context *thread, memory_index scratchSize)
+{
+    bool32 result = false;
+    *thread = {};
+
+    void *scratch = mmap(0, scratchSize, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if(scratch != MAP_FAILED)
+    {
+        InitializeArena(&thread->scratchArena, scratchSize, scratch, LinuxCommitMemory, LinuxDecommitMemory);
+        result = true;
+    }
+
+    return result;
+}
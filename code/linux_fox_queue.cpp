@@ -0,0 +1,146 @@
+/******************************************************************************
+File:   linux_fox_queue.cpp
+Author: GyuHyeon Lee
+Email:  email: weanother@gmail.com
+
+Github : https://git.digipen.edu/projects/jisendal
+
+Notice: (C) Copyright 2017 by GyuHyeon, Lee. All Rights Reserved. $
+******************************************************************************/
+/*****
+    Work queue for the linux platform layer, which should include this after linux_fox_memory.cpp.
+    Same ring buffer as the win32 one, with the pthreads and the posix semaphore.
+*****/
+
+#include <pthread.h>
+#include <semaphore.h>
+
+struct platform_work_queue_entry
+{
+    platform_work_queue_callback *callback;
+    void *data;
+};
+
+// NOTE : This is a ring buffer, and only one thread writes to it.
+struct platform_work_queue
+{
+    uint32 volatile completionGoal;
+    uint32 volatile completionCount;
+
+    uint32 volatile nextEntryToWrite;
+    uint32 volatile nextEntryToRead;
+
+    sem_t semaphoreHandle;
+
+    platform_work_queue_entry entries[256];
+};
+
+internal void
+LinuxAddEntry(platform_work_queue *queue, platform_work_queue_callback *callback, void *data)
+{
+    uint32 newNextEntryToWrite = (queue->nextEntryToWrite + 1) % ArrayCount(queue->entries);
+    // NOTE : The queue is full!
+    Assert(newNextEntryToWrite != queue->nextEntryToRead);
+
+    platform_work_queue_entry *entry = queue->entries + queue->nextEntryToWrite;
+    entry->callback = callback;
+    entry->data = data;
+    ++queue->completionGoal;
+
+    // NOTE : The threads should see the entry before they see the new nextEntryToWrite
+    CompletePreviousWritesBeforeFutureWrites;
+
+    queue->nextEntryToWrite = newNextEntryToWrite;
+
+    sem_post(&queue->semaphoreHandle);
+}
+
+// Returns true if there was no work to do, so that the thread can go to sleep
+internal bool32
+LinuxDoNextWorkQueueEntry(thread_context *thread, platform_work_queue *queue)
+{
+    bool32 shouldSleep = false;
+
+    uint32 originalNextEntryToRead = queue->nextEntryToRead;
+    uint32 newNextEntryToRead = (originalNextEntryToRead + 1) % ArrayCount(queue->entries);
+    if(originalNextEntryToRead != queue->nextEntryToWrite)
+    {
+        // NOTE : Other thread might have taken this entry already,
+        // so only take it if nextEntryToRead is still the same
+        uint32 index = __sync_val_compare_and_swap(&queue->nextEntryToRead,
+                                                originalNextEntryToRead,
+                                                newNextEntryToRead);
+        if(index == originalNextEntryToRead)
+        {
+            platform_work_queue_entry entry = queue->entries[index];
+            entry.callback(thread, queue, entry.data);
+            CheckScratchArena(&thread->scratchArena);
+            __sync_fetch_and_add(&queue->completionCount, 1);
+        }
+    }
+    else
+    {
+        shouldSleep = true;
+    }
+
+    return shouldSleep;
+}
+
+internal void
+LinuxCompleteAllWork(thread_context *thread, platform_work_queue *queue)
+{
+    // NOTE : Don't just wait, help the threads!
+    while(queue->completionGoal != queue->completionCount)
+    {
+        LinuxDoNextWorkQueueEntry(thread, queue);
+    }
+
+    queue->completionGoal = 0;
+    queue->completionCount = 0;
+}
+
+internal void *
+LinuxThreadProc(void *parameter)
+{
+    linux_thread_startup *startup = (linux_thread_startup *)parameter;
+    platform_work_queue *queue = startup->queue;
+    thread_context *thread = &startup->thread;
+
+    for(;;)
+    {
+        if(LinuxDoNextWorkQueueEntry(thread, queue))
+        {
+            sem_wait(&queue->semaphoreHandle);
+        }
+    }
+
+    // return 0;
+}
+
+// NOTE : The startups should live as long as the threads, and there should be threadCount of them.
+internal void
+LinuxMakeQueue(platform_work_queue *queue, uint32 threadCount, linux_thread_startup *startups)
+{
+    queue->completionGoal = 0;
+    queue->completionCount = 0;
+    queue->nextEntryToWrite = 0;
+    queue->nextEntryToRead = 0;
+
+    uint32 initialCount = 0;
+    sem_init(&queue->semaphoreHandle, 0, initialCount);
+
+    for(uint32 threadIndex = 0;
+        threadIndex < threadCount;
+        ++threadIndex)
+    {
+        linux_thread_startup *startup = startups + threadIndex;
+        startup->queue = queue;
+        bool32 initialized = LinuxInitializeThreadContext(&startup->thread, LINUX_SCRATCH_ARENA_SIZE);
+        Assert(initialized);
+
+        // NOTE : Nobody joins these, they just go away with the process
+        pthread_t threadHandle;
+        pthread_create(&threadHandle, 0, LinuxThreadProc, startup);
+        pthread_detach(threadHandle);
+    }
+}
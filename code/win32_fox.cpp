@@ -64,6 +64,8 @@ global_variable win32_offscreen_buffer globalBackBuffer;
 global_variable LPDIRECTSOUNDBUFFER globalSecondaryBuffer;
 global_variable int64 perfCountFrequency;
 global_variable bool32 globalDEBUGShowCursor;
+// NOTE : F1 asks for the arena summary at the end of this frame
+global_variable bool32 globalDEBUGPrintArenaProfile;
 
 global_variable WINDOWPLACEMENT globalWindowPosition = {sizeof(globalWindowPosition)};
 
@@ -281,6 +283,97 @@ DEBUG_PLATFORM_WRTIE_ENTIRE_FILE(DEBUGPlatformWriteEntireFile)
     return result;
 }
 
+PLATFORM_OPEN_PAGE_FILE(Win32OpenPageFile)
+{
+    platform_file_handle result = {};
+
+    // NOTE : Nobody else should touch this file, and windows deletes it when we close it(or crash)
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ|GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 
+                                    FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_DELETE_ON_CLOSE, 0);
+    if(fileHandle != INVALID_HANDLE_VALUE)
+    {
+        result.noErrors = true;
+        result.platform = fileHandle;
+    }
+
+    return result;
+}
+
+PLATFORM_READ_PAGE_FILE(Win32ReadPageFile)
+{
+    bool32 result = false;
+
+    if(handle->noErrors)
+    {
+        // NOTE : The file was not opened with FILE_FLAG_OVERLAPPED, 
+        // so this is just a synchronous read at the offset
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+        DWORD bytesRead;
+        if(ReadFile((HANDLE)handle->platform, dest, size, &bytesRead, &overlapped) &&
+            bytesRead == size)
+        {
+            result = true;
+        }
+        else
+        {
+            handle->noErrors = false;
+        }
+    }
+
+    return result;
+}
+
+PLATFORM_WRITE_PAGE_FILE(Win32WritePageFile)
+{
+    bool32 result = false;
+
+    if(handle->noErrors)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+        DWORD bytesWritten;
+        if(WriteFile((HANDLE)handle->platform, source, size, &bytesWritten, &overlapped) &&
+            bytesWritten == size)
+        {
+            result = true;
+        }
+        else
+        {
+            handle->noErrors = false;
+        }
+    }
+
+    return result;
+}
+
+PLATFORM_COMMIT_MEMORY(Win32CommitMemory)
+{
+    // NOTE : VirtualAlloc already rounds out to the whole pages,
+    // and committing the committed page again is fine.
+    bool32 result = (VirtualAlloc(base, size, MEM_COMMIT, PAGE_READWRITE) != 0);
+    return result;
+}
+
+PLATFORM_DECOMMIT_MEMORY(Win32DecommitMemory)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    memory_index pageMask = (memory_index)systemInfo.dwPageSize - 1;
+
+    // NOTE : Round in, because the pages at the edges might still have something in them
+    memory_index start = ((memory_index)base + pageMask) & ~pageMask;
+    memory_index end = ((memory_index)base + size) & ~pageMask;
+    if(start < end)
+    {
+        VirtualFree((void *)start, end - start, MEM_DECOMMIT);
+    }
+}
+
 internal void
 Win32InitOpenGL(HWND window)
 {
@@ -929,6 +1022,10 @@ Win32ProcessPendingMessages(game_controller *keyboardController)
                     {
                         bool32 altKeyWasDown = msg.lParam & (1 << 29);
 
+                        if(vkCode == VK_F1)
+                        {
+                            globalDEBUGPrintArenaProfile = true;
+                        }
                         if(vkCode == VK_F4 && altKeyWasDown)
                         {
                             globalRunning = false;
@@ -1037,129 +1134,258 @@ HandleDebugCycleCounter(game_memory *gameMemory)
 #endif
 }
 
-struct work_queue_entry_storage
+// NOTE : What each arena has, and which sites pushed in this frame.
+// This only prints when F1 was pressed or every DEBUG_ARENA_PROFILE_SUMMARY_FRAMES,
+// but the frame always ends so that the most per frame is right.
+internal void
+HandleDebugArenaProfile(game_memory *gameMemory)
 {
-    void *userPointer;
-};
+#if FOX_ARENA_PROFILE
+    debug_arena_profile *profile = &gameMemory->arenaProfile;
+    DEBUGEndArenaProfileFrame(gameMemory);
+
+    bool32 shouldPrint = globalDEBUGPrintArenaProfile ||
+                        (profile->frameCount % DEBUG_ARENA_PROFILE_SUMMARY_FRAMES) == 0;
+    globalDEBUGPrintArenaProfile = false;
+    if(shouldPrint)
+    {
+        OutputDebugStringA("DEBUG ARENAS : \n");
+        for(uint32 arenaIndex = 0;
+            arenaIndex < profile->arenaCount;
+            ++arenaIndex)
+        {
+            memory_arena *arena = profile->arenas[arenaIndex];
+            char buffer[512];
+            sprintf_s(buffer, " %s : %I64uKB used, %I64uKB max, %I64uKB committed, %I64uKB size, %upushes %I64ubytes this frame\n",
+                arena->name,
+                (uint64)arena->used / 1024,
+                (uint64)arena->maxUsed / 1024,
+                (uint64)arena->committed / 1024,
+                (uint64)arena->size / 1024,
+                arena->lastFramePushCount,
+                (uint64)arena->lastFrameByteCount);
+            OutputDebugStringA(buffer);
+        }
 
-// Get on it!!(To the work_queue)
-struct work_queue_entry
+        for(uint32 siteIndex = 0;
+            siteIndex < ArrayCount(profile->sites);
+            ++siteIndex)
+        {
+            debug_arena_site *site = profile->sites + siteIndex;
+            if(site->key && site->lastFramePushCount)
+            {
+                char buffer[512];
+                if(site->isTemporary)
+                {
+                    sprintf_s(buffer, " %s [%s] : %I64utemporary, %I64ubytes max\n",
+                        site->name, site->arenaName,
+                        site->lastFramePushCount,
+                        site->maxTempByteCount);
+                }
+                else
+                {
+                    sprintf_s(buffer, " %s [%s] : %I64upushes, %I64ubytes\n",
+                        site->name, site->arenaName,
+                        site->lastFramePushCount,
+                        site->lastFrameByteCount);
+                }
+                OutputDebugStringA(buffer);
+            }
+        }
+    }
+#endif
+}
+
+// NOTE : Every site that ever pushed, and the most that the arenas ever used,
+// so that we can see how big the arenas should actually be.
+internal void
+Win32DumpArenaProfile(game_memory *gameMemory)
 {
+#if FOX_ARENA_PROFILE
+    debug_arena_profile *profile = &gameMemory->arenaProfile;
+
+    OutputDebugStringA("DEBUG ARENA PROFILE : \n");
+    for(uint32 arenaIndex = 0;
+        arenaIndex < profile->arenaCount;
+        ++arenaIndex)
+    {
+        memory_arena *arena = profile->arenas[arenaIndex];
+        char buffer[512];
+        sprintf_s(buffer, " %s : %I64uKB max of %I64uKB\n",
+            arena->name,
+            (uint64)arena->maxUsed / 1024,
+            (uint64)arena->size / 1024);
+        OutputDebugStringA(buffer);
+    }
+
+    for(uint32 siteIndex = 0;
+        siteIndex < ArrayCount(profile->sites);
+        ++siteIndex)
+    {
+        debug_arena_site *site = profile->sites + siteIndex;
+        if(site->key)
+        {
+            char buffer[512];
+            if(site->isTemporary)
+            {
+                sprintf_s(buffer, " %s [%s] : %I64utemporary, %I64ubytes max\n",
+                    site->name, site->arenaName,
+                    site->pushCount,
+                    site->maxTempByteCount);
+            }
+            else
+            {
+                sprintf_s(buffer, " %s [%s] : %I64upushes, %I64ubytes, %I64ubytes/push, %I64ubytes max/frame\n",
+                    site->name, site->arenaName,
+                    site->pushCount,
+                    site->byteCount,
+                    site->byteCount / site->pushCount,
+                    site->maxFrameByteCount);
+            }
+            OutputDebugStringA(buffer);
+        }
+    }
+
+    if(profile->droppedPushCount)
+    {
+        char buffer[256];
+        sprintf_s(buffer, " %I64upushes had no site, DEBUG_MAX_ARENA_SITE_COUNT is too small\n",
+            profile->droppedPushCount);
+        OutputDebugStringA(buffer);
+    }
+#endif
+}
+
+struct platform_work_queue_entry
+{
+    platform_work_queue_callback *callback;
     void *data;
-    bool32 isCompleted;
 };
 
 // Contains all the work that needed to be done.
-struct work_queue
+// NOTE : This is a ring buffer, and only one thread writes to it.
+struct platform_work_queue
 {
-    uint32 volatile entryCompletionCount;
-    uint32 volatile nextEntryToDo;
-    uint32 volatile entryCount;
-    work_queue_entry_storage entries[256];
+    uint32 volatile completionGoal;
+    uint32 volatile completionCount;
+
+    uint32 volatile nextEntryToWrite;
+    uint32 volatile nextEntryToRead;
 
     HANDLE semaphoreHandle;
+
+    platform_work_queue_entry entries[256];
 };
 
 internal void
-AddWorkToQueue(work_queue *queue, void *pointer)
+Win32AddEntry(platform_work_queue *queue, platform_work_queue_callback *callback, void *data)
 {
-    queue->entries[queue->entryCount].userPointer = pointer;
+    uint32 newNextEntryToWrite = (queue->nextEntryToWrite + 1) % ArrayCount(queue->entries);
+    // NOTE : The queue is full! 
+    Assert(newNextEntryToWrite != queue->nextEntryToRead);
 
-    _WriteBarrier();
-    _mm_sfence();
+    platform_work_queue_entry *entry = queue->entries + queue->nextEntryToWrite;
+    entry->callback = callback;
+    entry->data = data;
+    ++queue->completionGoal;
 
     // This will notice the threads that there are more works, 
     // so make sure to setup the writebarrier.
     // so that the threads will get the right data of works
-    queue->entryCount++;
+    _WriteBarrier();
+    _mm_sfence();
+
+    queue->nextEntryToWrite = newNextEntryToWrite;
 
     // NOTE : Wake up the threads by incrementing the count by 1
-    ReleaseSemaphore(queue->semaphoreHandle, 1, NULL);
+    ReleaseSemaphore(queue->semaphoreHandle, 1, 0);
+}
+
+// NOTE : Every thread gets its own scratch arena, which commits as it grows
+internal void
+Win32InitializeThreadContext(thread_context *thread, memory_index scratchSize)
+{
+    *thread = {};
+
+    void *scratch = VirtualAlloc(0, scratchSize, MEM_RESERVE, PAGE_NOACCESS);
+    Assert(scratch);
+    InitializeArena(&thread->scratchArena, scratchSize, scratch, Win32CommitMemory, Win32DecommitMemory);
 }
 
-internal work_queue_entry
-CompleteAndGetNextWorkQueueEntry(work_queue *queue, work_queue_entry completed)
+// Returns true if there was no work to do, so that the thread can go to sleep
+internal bool32
+Win32DoNextWorkQueueEntry(thread_context *thread, platform_work_queue *queue)
 {
-    work_queue_entry result;
-    result.isCompleted = false;
+    bool32 shouldSleep = false;
 
-    if(completed.isCompleted)
+    uint32 originalNextEntryToRead = queue->nextEntryToRead;
+    uint32 newNextEntryToRead = (originalNextEntryToRead + 1) % ArrayCount(queue->entries);
+    if(originalNextEntryToRead != queue->nextEntryToWrite)
     {
-        InterlockedIncrement((LONG volatile *)&queue->entryCompletionCount);
+        // NOTE : Other thread might have taken this entry already,
+        // so only take it if nextEntryToRead is still the same
+        uint32 index = InterlockedCompareExchange((LONG volatile *)&queue->nextEntryToRead,
+                                                newNextEntryToRead,
+                                                originalNextEntryToRead);
+        if(index == originalNextEntryToRead)
+        {
+            platform_work_queue_entry entry = queue->entries[index];
+            entry.callback(thread, queue, entry.data);
+            CheckScratchArena(&thread->scratchArena);
+            InterlockedIncrement((LONG volatile *)&queue->completionCount);
+        }
     }
-
-    if(queue->nextEntryToDo < queue->entryCount)
+    else
     {
-        // What if the other thread is already inside here?
-        int entryIndex = InterlockedIncrement((LONG volatile *)&queue->nextEntryToDo) - 1;
-        result.data = queue->entries[entryIndex].userPointer;
-        _ReadBarrier();
-        result.isCompleted = true;
-
+        shouldSleep = true;
     }
 
-    return result;
-}
-
-internal bool32
-QueueWorkStillInProgress(work_queue *queue)
-{
-    // If the entr
-    bool32 result = queue->entryCompletionCount != queue->entryCount;
-    return result;
+    return shouldSleep;
 }
 
 internal void
-DoWorkInsideEntry(work_queue_entry *entry, int32 logicalThreadIndex)
+Win32CompleteAllWork(thread_context *thread, platform_work_queue *queue)
 {
-    char buffer[256];
-    wsprintf(buffer, "thread : %u, %s\n", logicalThreadIndex, (char *)entry->data);
-    OutputDebugStringA(buffer);
+    // NOTE : Don't just wait, help the threads!
+    while(queue->completionGoal != queue->completionCount)
+    {
+        Win32DoNextWorkQueueEntry(thread, queue);
+    }
+
+    queue->completionGoal = 0;
+    queue->completionCount = 0;
 }
 
-struct win32_thread_info
-{
-    int logicalThreadIndex;
-    work_queue *queue;
-};
 DWORD WINAPI 
 ThreadProc(LPVOID lpParameter)
 {
-    win32_thread_info *threadInfo = (win32_thread_info *)lpParameter;  
+    win32_thread_startup *startup = (win32_thread_startup *)lpParameter;
+    platform_work_queue *queue = startup->queue;
+    thread_context *thread = &startup->thread;
 
-    work_queue_entry entry = {};
     for(;;)
     {
-        entry = CompleteAndGetNextWorkQueueEntry(threadInfo->queue, entry);
-        if(entry.isCompleted)
-        {
-            DoWorkInsideEntry(&entry, threadInfo->logicalThreadIndex);
-        }
-        else
+        if(Win32DoNextWorkQueueEntry(thread, queue))
         {
             // Whenever the thread wakes up, it will decrement the semaphore by 1
-            WaitForSingleObjectEx(threadInfo->queue->semaphoreHandle, INFINITE, false);
+            WaitForSingleObjectEx(queue->semaphoreHandle, INFINITE, false);
         }
     }
 
     // return 0;
 }
 
-int CALLBACK 
-WinMain(HINSTANCE hInstance,
-    HINSTANCE HPrevInstance,
-    LPSTR lpCmdLine,
-    int nCmdShow)
+// NOTE : The startups should live as long as the threads, and there should be threadCount of them.
+internal void
+Win32MakeQueue(platform_work_queue *queue, uint32 threadCount, win32_thread_startup *startups)
 {
-    #if 1
-    win32_thread_info threadInfos[7] = {};
-
-    work_queue queue = {};
+    queue->completionGoal = 0;
+    queue->completionCount = 0;
+    queue->nextEntryToWrite = 0;
+    queue->nextEntryToRead = 0;
 
     uint32 initialCount = 0;
-    uint32 threadCount = ArrayCount(threadInfos);
-
-    queue.semaphoreHandle = CreateSemaphoreEx(0, initialCount, 
+    queue->semaphoreHandle = CreateSemaphoreEx(0, initialCount, 
                                                 threadCount, 
                                                 0, 0, SEMAPHORE_ALL_ACCESS); 
 
@@ -1167,43 +1393,33 @@ WinMain(HINSTANCE hInstance,
         threadIndex < threadCount;
         ++threadIndex)
     {
-        win32_thread_info *info = threadInfos + threadIndex;
-        info->logicalThreadIndex = threadIndex;
-        info->queue = &queue;
+        win32_thread_startup *startup = startups + threadIndex;
+        startup->queue = queue;
+        Win32InitializeThreadContext(&startup->thread, WIN32_SCRATCH_ARENA_SIZE);
 
-        // Just a placeholder
         DWORD threadID;
-        HANDLE threadHandle = CreateThread(0, 0, ThreadProc, (LPVOID)info, 0, &threadID);
+        HANDLE threadHandle = CreateThread(0, 0, ThreadProc, (LPVOID)startup, 0, &threadID);
         // Close handle does not actually close the thread entirely.. it returns the thread to the OS.
         // The end of WinMain will actually call the ExitProcess, which actually shuts down all the threads.
         CloseHandle(threadHandle);
     }
+}
 
-    // Push string so that the threads have work to do.
-    AddWorkToQueue(&queue, "string 0");
-    AddWorkToQueue(&queue, "string 1");
-    AddWorkToQueue(&queue, "string 2");
-    AddWorkToQueue(&queue, "string 3");
-    AddWorkToQueue(&queue, "string 4");
-    AddWorkToQueue(&queue, "string 5");
-    AddWorkToQueue(&queue, "string 6");
-    AddWorkToQueue(&queue, "string 7");
-    AddWorkToQueue(&queue, "string 8");
-    AddWorkToQueue(&queue, "string 9");
-
-    // This is for the main thread
-    work_queue_entry entry = {};
-
-    while(QueueWorkStillInProgress(&queue))
-    {
-        entry = CompleteAndGetNextWorkQueueEntry(&queue, entry);
-        if(entry.isCompleted)
-        {
-            DoWorkInsideEntry(&entry, 7);
-        }
-    }
+int CALLBACK 
+WinMain(HINSTANCE hInstance,
+    HINSTANCE HPrevInstance,
+    LPSTR lpCmdLine,
+    int nCmdShow)
+{
+    // TODO : Get the number of the logical cores from the OS
+    platform_work_queue workQueue = {};
+    win32_thread_startup threadStartups[7] = {};
+    Win32MakeQueue(&workQueue, ArrayCount(threadStartups), threadStartups);
+
+    // NOTE : The main thread does the work too, while it waits for the queue
+    thread_context mainThread;
+    Win32InitializeThreadContext(&mainThread, WIN32_SCRATCH_ARENA_SIZE);
 
-#endif
     //Because the frequency doesn't change, we can just compute here.
     LARGE_INTEGER perfCountFreqResult;
     QueryPerformanceFrequency(&perfCountFreqResult);
@@ -1314,17 +1530,40 @@ WinMain(HINSTANCE hInstance,
 #endif
             game_memory gameMemory = {};
             // TODO : See how much this game actually needs
-            gameMemory.permanentStorageSize = Megabytes(64);
-            gameMemory.transientStorageSize = Gigabytes(1);
+            // NOTE : These are only reserved, and the game commits what it uses.
+            gameMemory.permanentStorageSize = Gigabytes(1);
+            gameMemory.transientStorageSize = Gigabytes(4);
             gameMemory.debugPlatformFreeFileMemory = DEBUGPlatformFreeFileMemory;            
             gameMemory.debugPlatformReadEntireFile = DEBUGPlatformReadEntireFile;
             gameMemory.debugPlatformWriteEntireFile = DEBUGPlatformWriteEntireFile;
-            uint64 totalSize = gameMemory.permanentStorageSize + gameMemory.transientStorageSize;
+            gameMemory.platformOpenPageFile = Win32OpenPageFile;
+            gameMemory.platformReadPageFile = Win32ReadPageFile;
+            gameMemory.platformWritePageFile = Win32WritePageFile;
+            gameMemory.workQueue = &workQueue;
+            gameMemory.platformAddEntry = Win32AddEntry;
+            gameMemory.platformCompleteAllWork = Win32CompleteAllWork;
+            gameMemory.platformCommitMemory = Win32CommitMemory;
+            gameMemory.platformDecommitMemory = Win32DecommitMemory;
+#if FOX_ARENA_PROFILE
+            DEBUGRegisterArena(&gameMemory, &mainThread.scratchArena, "main scratch");
+            for(uint32 threadIndex = 0;
+                threadIndex < ArrayCount(threadStartups);
+                ++threadIndex)
+            {
+                DEBUGRegisterArena(&gameMemory, &threadStartups[threadIndex].thread.scratchArena, "worker scratch");
+            }
+#endif
+            // NOTE : Never committed, so that running off the end of the permanent storage
+            // faults right away instead of writing over the transient storage.
+            uint64 guardSize = Kilobytes(64);
+            uint64 totalSize = gameMemory.permanentStorageSize + guardSize + 
+                                gameMemory.transientStorageSize + guardSize;
             // TODO :Use MEM_LARGE_PAGES. This need many pre-functions so this is todo.
             
             gameMemory.permanentStorage = VirtualAlloc(baseAddress, (size_t)totalSize,
-                MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-            gameMemory.transientStorage = ((uint8 *)gameMemory.permanentStorage + gameMemory.permanentStorageSize);
+                MEM_RESERVE, PAGE_NOACCESS);
+            gameMemory.transientStorage = ((uint8 *)gameMemory.permanentStorage + 
+                                            gameMemory.permanentStorageSize + guardSize);
 
             if(samples && gameMemory.permanentStorage && gameMemory.transientStorage)
             {
@@ -1488,7 +1727,6 @@ WinMain(HINSTANCE hInstance,
                         }
                     }
 
-                    thread_context thread = {};
                     game_offscreen_buffer gameBuffer = {};
                     gameBuffer.memory = globalBackBuffer.memory;
                     gameBuffer.width = globalBackBuffer.width;
@@ -1499,10 +1737,11 @@ WinMain(HINSTANCE hInstance,
                     // Get the update and render function so that we can update the game
                     if(gameCode.updateAndRender)
                     {
-                        gameCode.updateAndRender(&thread, &gameMemory, &gameBuffer, newInput);
+                        gameCode.updateAndRender(&mainThread, &gameMemory, &gameBuffer, newInput);
 
                         // Clear Timer
                         HandleDebugCycleCounter(&gameMemory);
+                        HandleDebugArenaProfile(&gameMemory);
                     }
 
                     LARGE_INTEGER audioWallClock = Win32GetWallClock();
@@ -1586,7 +1825,7 @@ WinMain(HINSTANCE hInstance,
                         if(gameCode.getSoundSamples)
                         {
                             // Get the sound samples from the game code
-                            gameCode.getSoundSamples(&thread, &gameMemory, &soundBuffer);
+                            gameCode.getSoundSamples(&mainThread, &gameMemory, &soundBuffer);
                         }
 
                         Win32FillSoundBuffer(&soundOutput, byteToLock, bytesToWrite, &soundBuffer);
@@ -1671,6 +1910,8 @@ WinMain(HINSTANCE hInstance,
 #endif
 
                 }
+
+                Win32DumpArenaProfile(&gameMemory);
             }
         }
         else
@@ -54,4 +54,12 @@ struct win32_state
     char exeFileName[MAX_PATH];   
     char *onePastLastSlash;
 };
+
+// NOTE : Only reserved, so this can be big
+#define WIN32_SCRATCH_ARENA_SIZE Megabytes(256)
+struct win32_thread_startup
+{
+    platform_work_queue *queue;
+    thread_context thread;
+};
 #endif
\ No newline at end of file